@@ -0,0 +1,56 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Internal Interface */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "openhmdi.h"
+
+// keeps the compiler from optimizing away results
+extern volatile float bench_sink;
+
+// timing harness, each case runs its operation n times per call and is
+// reported in ns per operation over repeated runs
+typedef struct {
+	const char* name;
+	void (*fn)(long n);
+	void (*setup)(); // optional, called once before the case is timed
+} bench_case;
+
+typedef enum {
+	BENCH_TEXT,
+	BENCH_CSV,
+	BENCH_JSON
+} bench_format;
+
+void bench_begin(bench_format format, const char* filter);
+void bench_run_cases(const char* group, const bench_case* cases, int count);
+void bench_end();
+
+// per operation benchmarks, through the harness
+void bench_ops_omath();
+void bench_ops_queue();
+void bench_ops_fusion();
+void bench_ops_packet();
+
+// comparison reports, text only
+void bench_omath_impls();
+void bench_transform_points();
+void bench_eye_views();
+
+void bench_fusion_batch();
+void bench_fusion_algorithms();
+void bench_fusion_inline();
+void bench_fusion_precision();
+
+#endif
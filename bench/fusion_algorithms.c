@@ -0,0 +1,118 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Fusion Algorithms */
+
+#include <stdlib.h>
+#include "bench.h"
+
+#define SAMPLE_RATE 1000
+#define DURATION 60
+#define SAMPLES (SAMPLE_RATE * DURATION)
+
+typedef struct {
+	vec3f ang_vel, accel;
+} sample;
+
+static const struct {
+	int algorithm;
+	const char* name;
+	int fuse_interval;
+} algorithms[] = {
+	{ OHMD_FUSION_COMPLEMENTARY, "complementary", 1 },
+	{ OHMD_FUSION_COMPLEMENTARY, "complementary", 4 },
+	{ OHMD_FUSION_COMPLEMENTARY, "complementary", 8 },
+	{ OHMD_FUSION_MADGWICK, "madgwick", 1 },
+	{ OHMD_FUSION_MADGWICK, "madgwick", 4 },
+	{ OHMD_FUSION_MAHONY, "mahony", 1 },
+	{ OHMD_FUSION_MAHONY, "mahony", 4 },
+};
+
+// deterministic noise in [-1, 1]
+static float noise(unsigned int* state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return (float)(*state >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+// synthetic head motion with a biased, noisy gyro, returns the true final orientation
+static void generate(sample* samples, quatf* truth)
+{
+	const vec3f bias = {{0.005f, -0.004f, 0.003f}};
+	const vec3f up = {{0, 9.82f, 0}};
+	unsigned int state = 1;
+	float dt = 1.0f / SAMPLE_RATE;
+
+	truth->x = truth->y = truth->z = 0;
+	truth->w = 1;
+
+	for(int i = 0; i < SAMPLES; i++){
+		float t = i * dt;
+		vec3f ang_vel = {{ 0.5f * sinf(0.7f * t), 0.8f * sinf(0.3f * t), 0.4f * cosf(0.5f * t) }};
+
+		// gravity in sensor space
+		quatf inv = *truth;
+		oquatf_inverse(&inv);
+		oquatf_get_rotated(&inv, &up, &samples[i].accel);
+
+		for(int j = 0; j < 3; j++){
+			samples[i].ang_vel.arr[j] = ang_vel.arr[j] + bias.arr[j] + 0.01f * noise(&state);
+			samples[i].accel.arr[j] += 0.05f * noise(&state);
+		}
+
+		float length = ovec3f_get_length(&ang_vel);
+		vec3f axis = {{ ang_vel.x / length, ang_vel.y / length, ang_vel.z / length }};
+		quatf delta;
+		oquatf_init_axis(&delta, &axis, length * dt);
+		oquatf_mult_me(truth, &delta);
+		oquatf_normalize_me(truth);
+	}
+}
+
+void bench_fusion_algorithms()
+{
+	vec3f no_mag = {{0, 0, 0}};
+	quatf truth;
+
+	sample* samples = malloc(sizeof(sample) * SAMPLES);
+	if(!samples)
+		return;
+
+	generate(samples, &truth);
+
+	printf("   %d s at %d Hz, biased and noisy gyro\n", DURATION, SAMPLE_RATE);
+	printf("   %-14s %8s %12s %12s %12s\n", "algorithm", "window", "ns/sample", "tilt deg", "total deg");
+
+	for(int a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++){
+		fusion f;
+		ofusion_init(&f);
+		ofusion_set_algorithm(&f, algorithms[a].algorithm);
+		f.fuse_interval = algorithms[a].fuse_interval;
+
+		double start = ohmd_get_tick();
+		for(int i = 0; i < SAMPLES; i++)
+			ofusion_update(&f, 1.0f / SAMPLE_RATE, &samples[i].ang_vel, &samples[i].accel, &no_mag);
+		double time = ohmd_get_tick() - start;
+
+		bench_sink = f.orient.w;
+
+		// tilt error is how far the estimated up axis is from the true one
+		vec3f up = {{0, 1, 0}}, body_up, est_up;
+		quatf inv = truth;
+		oquatf_inverse(&inv);
+		oquatf_get_rotated(&inv, &up, &body_up);
+		oquatf_get_rotated(&f.orient, &body_up, &est_up);
+
+		float tilt = ovec3f_get_angle(&est_up, &up);
+		float total = 2.0f * acosf(OHMD_MIN(fabsf(oquatf_get_dot(&f.orient, &truth)), 1.0f));
+
+		printf("   %-14s %8d %12.1f %12.3f %12.3f\n", algorithms[a].name, algorithms[a].fuse_interval,
+			time * 1e9 / SAMPLES, tilt * 180.0f / M_PI, total * 180.0f / M_PI);
+	}
+
+	free(samples);
+}
@@ -0,0 +1,85 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Batched Sensor Fusion */
+
+#include "bench.h"
+#include "fusion_batch.h"
+
+#define UPDATES 2000
+
+static fusion_batch batch;
+static fusion single[FUSION_BATCH_MAX_SIZE];
+
+static void get_sample(int dev, int i, vec3f* ang_vel, vec3f* accel)
+{
+	// a slow wobble, different per device, with gravity along y
+	ang_vel->x = 0.1f * sinf(i * 0.01f + dev);
+	ang_vel->y = 0.2f;
+	ang_vel->z = 0.1f * cosf(i * 0.01f + dev);
+
+	accel->x = 0.1f;
+	accel->y = 9.8f;
+	accel->z = -0.1f;
+}
+
+void bench_fusion_batch()
+{
+	static const int sizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+	vec3f no_mag = {{0, 0, 0}};
+
+	// warm up caches and clocks before the first measurement
+	ofusion_batch_init(&batch);
+	batch.size = FUSION_BATCH_MAX_SIZE;
+	for(int i = 0; i < UPDATES; i++){
+		for(int d = 0; d < FUSION_BATCH_MAX_SIZE; d++)
+			batch.dt[d] = 0.001f;
+
+		ofusion_batch_update(&batch);
+	}
+
+	printf("   batch update built for %s\n", ofusion_batch_get_isa());
+	printf("   %-10s %14s %14s\n", "devices", "batch ns/dev", "single ns/dev");
+
+	for(int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+		int n = sizes[s];
+
+		ofusion_batch_init(&batch);
+		for(int d = 0; d < n; d++){
+			ofusion_batch_add(&batch);
+			ofusion_init(&single[d]);
+		}
+
+		double start = ohmd_get_tick();
+		for(int i = 0; i < UPDATES; i++){
+			for(int d = 0; d < n; d++){
+				vec3f ang_vel, accel;
+				get_sample(d, i, &ang_vel, &accel);
+				ofusion_batch_set_sample(&batch, d, 0.001f, &ang_vel, &accel);
+			}
+
+			ofusion_batch_update(&batch);
+		}
+		double batch_time = ohmd_get_tick() - start;
+
+		start = ohmd_get_tick();
+		for(int i = 0; i < UPDATES; i++){
+			for(int d = 0; d < n; d++){
+				vec3f ang_vel, accel;
+				get_sample(d, i, &ang_vel, &accel);
+				ofusion_update(&single[d], 0.001f, &ang_vel, &accel, &no_mag);
+			}
+		}
+		double single_time = ohmd_get_tick() - start;
+
+		bench_sink = batch.ow[0] + single[0].orient.w;
+
+		printf("   %-10d %14.1f %14.1f\n", n,
+			batch_time * 1e9 / ((double)UPDATES * n),
+			single_time * 1e9 / ((double)UPDATES * n));
+	}
+}
@@ -0,0 +1,94 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Inline Math In The Fusion Path */
+
+#include <stdlib.h>
+#include "bench.h"
+
+#define SAMPLES 200000
+
+// fusion.c built without OMATH_INLINE, see fusion_outline.c
+void outline_ofusion_init(fusion* me);
+int outline_ofusion_set_algorithm(fusion* me, int algorithm);
+void outline_ofusion_update(fusion* me, float dt, const vec3f* ang_vel, const vec3f* accel, const vec3f* mag);
+
+typedef struct {
+	vec3f ang_vel, accel;
+} sample;
+
+static const struct {
+	int algorithm;
+	const char* name;
+} algorithms[] = {
+	{ OHMD_FUSION_COMPLEMENTARY, "complementary" },
+	{ OHMD_FUSION_MADGWICK, "madgwick" },
+	{ OHMD_FUSION_MAHONY, "mahony" },
+};
+
+static double run(sample* samples, int algorithm, bool outline, float* w)
+{
+	vec3f no_mag = {{0, 0, 0}};
+	fusion f;
+
+	if(outline){
+		outline_ofusion_init(&f);
+		outline_ofusion_set_algorithm(&f, algorithm);
+	}else{
+		ofusion_init(&f);
+		ofusion_set_algorithm(&f, algorithm);
+	}
+
+	double start = ohmd_get_tick();
+	if(outline){
+		for(int i = 0; i < SAMPLES; i++)
+			outline_ofusion_update(&f, 0.001f, &samples[i].ang_vel, &samples[i].accel, &no_mag);
+	}else{
+		for(int i = 0; i < SAMPLES; i++)
+			ofusion_update(&f, 0.001f, &samples[i].ang_vel, &samples[i].accel, &no_mag);
+	}
+	double time = ohmd_get_tick() - start;
+
+	*w = f.orient.w;
+	bench_sink = f.orient.w;
+
+	return time * 1e9 / SAMPLES;
+}
+
+void bench_fusion_inline()
+{
+	sample* samples = malloc(sizeof(sample) * SAMPLES);
+	if(!samples)
+		return;
+
+	// slow rotation with gravity close to one g, so the tilt correction runs
+	for(int i = 0; i < SAMPLES; i++){
+		float t = i * 0.001f;
+		samples[i].ang_vel = (vec3f){{ 0.3f * sinf(t), 0.2f * cosf(0.5f * t), 0.1f }};
+		samples[i].accel = (vec3f){{ 0.5f * sinf(0.3f * t), 9.8f, 0.4f * cosf(0.2f * t) }};
+	}
+
+#ifdef OMATH_INLINE
+	const char* mode = "inline";
+#else
+	const char* mode = "exported";
+#endif
+
+	printf("   per sample update, library math %s\n", mode);
+	printf("   %-14s %12s %12s %8s\n", "algorithm", "exported ns", "library ns", "speedup");
+
+	for(int a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++){
+		float w_outline, w_lib;
+		double outline = run(samples, algorithms[a].algorithm, true, &w_outline);
+		double lib = run(samples, algorithms[a].algorithm, false, &w_lib);
+
+		printf("   %-14s %12.1f %12.1f %7.2fx%s\n", algorithms[a].name, outline, lib, outline / lib,
+			fabsf(w_outline - w_lib) > 1e-4f ? "  (results differ)" : "");
+	}
+
+	free(samples);
+}
@@ -0,0 +1,24 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Fusion Without Inline Math */
+
+// the fusion code as built without OMATH_INLINE, calling the exported math functions
+#undef OMATH_INLINE
+
+#define ofusion_init outline_ofusion_init
+#define ofusion_set_algorithm outline_ofusion_set_algorithm
+#define ofusion_set_mag_gain outline_ofusion_set_mag_gain
+#define ofusion_get_mag_gain outline_ofusion_get_mag_gain
+#define ofusion_madgwick_init outline_ofusion_madgwick_init
+#define ofusion_madgwick_update outline_ofusion_madgwick_update
+#define ofusion_mahony_init outline_ofusion_mahony_init
+#define ofusion_mahony_update outline_ofusion_mahony_update
+#define ofusion_update outline_ofusion_update
+#define ofusion_update_delta outline_ofusion_update_delta
+
+#include "../src/fusion.c"
@@ -0,0 +1,56 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Fusion Precision */
+
+#include "bench.h"
+
+#define SAMPLE_RATE 1000
+#define HOURS 2
+
+// angle between an orientation and the exact one
+static double get_error(const quatf* q, const quatd* expected)
+{
+	quatd qd, diff;
+	oquatd_from_quatf(&qd, q);
+	oquatd_diff(expected, &qd, &diff);
+
+	vec3d v = {{ diff.x, diff.y, diff.z }};
+	return 2.0 * asin(OHMD_MIN(ovec3d_get_length(&v), 1.0));
+}
+
+void bench_fusion_precision()
+{
+	const vec3f gravity = {{0, 9.82f, 0}}, no_mag = {{0, 0, 0}};
+	const vec3f ang_vel = {{ 0.3f, -0.7f, 0.2f }};
+	const float dt = 1.0f / SAMPLE_RATE;
+	const char* names[] = { "float", "double" };
+
+	// a constant turn has an exact answer, the summed rotation vector
+	long long samples = (long long)HOURS * 3600 * SAMPLE_RATE;
+	vec3d total = {{ (double)(ang_vel.x * dt) * samples, (double)(ang_vel.y * dt) * samples, (double)(ang_vel.z * dt) * samples }};
+	quatd expected;
+	oquatd_init_rotation_vector(&expected, &total);
+
+	printf("   %d h constant turn at %d Hz\n", HOURS, SAMPLE_RATE);
+	printf("   %-8s %12s %12s\n", "orient", "ns/sample", "error deg");
+
+	for(int i = 0; i < 2; i++){
+		fusion f;
+		ofusion_init(&f);
+		f.flags = i ? FF_DOUBLE_PRECISION : 0;
+
+		double start = ohmd_get_tick();
+		for(long long s = 0; s < samples; s++)
+			ofusion_update(&f, dt, &ang_vel, &gravity, &no_mag);
+		double time = ohmd_get_tick() - start;
+
+		bench_sink = f.orient.w;
+
+		printf("   %-8s %12.1f %12.6f\n", names[i], time * 1e9 / samples, get_error(&f.orient, &expected) * 180.0 / M_PI);
+	}
+}
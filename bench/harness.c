@@ -0,0 +1,133 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Timing Harness */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "fusion_batch.h"
+
+// each run is at least this long, long enough that the timer resolution doesn't matter
+#define MIN_RUN_TIME 0.002
+
+// runs thrown away before measuring, to settle caches, branch predictors and clocks
+#define WARMUP_RUNS 3
+
+// measured runs per case
+#define RUNS 15
+
+static bench_format format = BENCH_TEXT;
+static const char* filter = NULL;
+static int results = 0;
+
+// group of the last text header, a group can be run a case at a time
+static char text_group[64];
+
+static double time_run(const bench_case* c, long n)
+{
+	double start = ohmd_get_tick();
+	c->fn(n);
+	return ohmd_get_tick() - start;
+}
+
+static int compare_double(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
+
+void bench_begin(bench_format fmt, const char* name_filter)
+{
+	format = fmt;
+	filter = name_filter;
+	results = 0;
+	text_group[0] = '\0';
+
+	const char* impl = omath_get_impl_name(omath_get_impl());
+
+	switch(format){
+	case BENCH_CSV:
+		printf("group,name,iterations,min_ns,median_ns,mean_ns,stddev_ns,ops_per_s\n");
+		break;
+
+	case BENCH_JSON:
+		printf("{\n  \"omath_impl\": \"%s\",\n  \"fusion_batch_isa\": \"%s\",\n  \"runs\": %d,\n  \"results\": [",
+			impl, ofusion_batch_get_isa(), RUNS);
+		break;
+
+	default:
+		printf("omath implementation %s, %d runs per case after %d warm-up runs\n\n", impl, RUNS, WARMUP_RUNS);
+		break;
+	}
+}
+
+void bench_end()
+{
+	if(format == BENCH_JSON)
+		printf("\n  ]\n}\n");
+	else if(format == BENCH_TEXT && text_group[0])
+		printf("\n");
+}
+
+void bench_run_cases(const char* group, const bench_case* cases, int count)
+{
+	for(int i = 0; i < count; i++){
+		const bench_case* c = cases + i;
+
+		if(filter && !strstr(group, filter) && !strstr(c->name, filter))
+			continue;
+
+		if(c->setup)
+			c->setup();
+
+		// find an iteration count that takes long enough, doubles as the first warm-up run
+		long n = 1;
+		while(time_run(c, n) < MIN_RUN_TIME && n < (1L << 40))
+			n *= 2;
+
+		for(int j = 0; j < WARMUP_RUNS; j++)
+			time_run(c, n);
+
+		double ns[RUNS], mean = 0, var = 0;
+		for(int j = 0; j < RUNS; j++){
+			ns[j] = time_run(c, n) * 1e9 / n;
+			mean += ns[j] / RUNS;
+		}
+
+		for(int j = 0; j < RUNS; j++)
+			var += POW2(ns[j] - mean) / (RUNS - 1);
+
+		qsort(ns, RUNS, sizeof(double), compare_double);
+
+		double min = ns[0], median = ns[RUNS / 2], stddev = sqrt(var);
+		double per_s = 1e9 / median;
+
+		switch(format){
+		case BENCH_CSV:
+			printf("%s,%s,%ld,%.3f,%.3f,%.3f,%.3f,%.0f\n", group, c->name, n, min, median, mean, stddev, per_s);
+			break;
+
+		case BENCH_JSON:
+			printf("%s\n    {\"group\": \"%s\", \"name\": \"%s\", \"iterations\": %ld, \"min_ns\": %.3f, "
+				"\"median_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"ops_per_s\": %.0f}",
+				results ? "," : "", group, c->name, n, min, median, mean, stddev, per_s);
+			break;
+
+		default:
+			if(strcmp(text_group, group) != 0){
+				printf("%s%s, ns/op\n   %-40s %10s %10s %10s %10s %12s\n", text_group[0] ? "\n" : "", group,
+					"", "min", "median", "mean", "stddev", "ops/s");
+				snprintf(text_group, sizeof(text_group), "%s", group);
+			}
+			printf("   %-40s %10.2f %10.2f %10.2f %10.2f %12.0f\n", c->name, min, median, mean, stddev, per_s);
+			break;
+		}
+
+		results++;
+	}
+}
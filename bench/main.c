@@ -0,0 +1,66 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Main */
+
+#include <string.h>
+#include "bench.h"
+
+volatile float bench_sink;
+
+static void usage(const char* name)
+{
+	printf("usage: %s [--csv | --json] [--filter <substring>]\n", name);
+	printf("  --csv     one line per operation, for spreadsheets and scripts\n");
+	printf("  --json    a single json document, for comparing runs\n");
+	printf("  --filter  only run operations whose group or name contains <substring>\n");
+}
+
+int main(int argc, char** argv)
+{
+	bench_format format = BENCH_TEXT;
+	const char* filter = NULL;
+
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--csv") == 0){
+			format = BENCH_CSV;
+		}else if(strcmp(argv[i], "--json") == 0){
+			format = BENCH_JSON;
+		}else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+			filter = argv[++i];
+		}else{
+			usage(argv[0]);
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	bench_begin(format, filter);
+	bench_ops_omath();
+	bench_ops_queue();
+	bench_ops_fusion();
+	bench_ops_packet();
+	bench_end();
+
+	// the comparison reports are free form text, only run them for a full text run
+	if(format != BENCH_TEXT || filter)
+		return 0;
+
+	printf("math benchmarks\n");
+	bench_omath_impls();
+	bench_transform_points();
+	bench_eye_views();
+	printf("\n");
+
+	printf("fusion benchmarks\n");
+	bench_fusion_batch();
+	bench_fusion_algorithms();
+	bench_fusion_inline();
+	bench_fusion_precision();
+	printf("\n");
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Math Kernels */
+
+#include "bench.h"
+
+#define ITERATIONS 1000000
+
+void bench_omath_impls()
+{
+	quatf a = {{0.1f, 0.2f, 0.3f, 0.927f}}, b = {{-0.3f, 0.1f, 0.2f, 0.927f}};
+	vec3f v = {{1, 2, 3}};
+	mat4x4f l, r, t;
+
+	// unit length rotations, so the chained results neither blow up nor decay into denormals
+	oquatf_normalize_me(&a);
+	oquatf_normalize_me(&b);
+	oquatf_get_mat4x4(&a, &v, l.m);
+	oquatf_get_mat4x4(&b, &v, r.m);
+
+	omath_impl prev = omath_get_impl();
+
+	printf("   %-8s %12s %12s %12s %12s %12s\n", "impl", "quat_mult", "rotated", "normalize", "mat_mult", "transpose");
+
+	for(int impl = 0; impl < OMATH_IMPL_COUNT; impl++){
+		if(omath_set_impl(impl) != 0)
+			continue;
+
+		double ns[5];
+		double start;
+
+		// every iteration feeds into the next one so the calls can't be skipped
+		quatf q = a, tmp;
+		start = ohmd_get_tick();
+		for(int i = 0; i < ITERATIONS / 2; i++){
+			oquatf_mult(&q, &b, &tmp);
+			oquatf_mult(&tmp, &b, &q);
+		}
+		ns[0] = (ohmd_get_tick() - start) * 1e9 / ITERATIONS;
+
+		vec3f out = v, tmp_v;
+		start = ohmd_get_tick();
+		for(int i = 0; i < ITERATIONS / 2; i++){
+			oquatf_get_rotated(&a, &out, &tmp_v);
+			oquatf_get_rotated(&a, &tmp_v, &out);
+		}
+		ns[1] = (ohmd_get_tick() - start) * 1e9 / ITERATIONS;
+
+		start = ohmd_get_tick();
+		for(int i = 0; i < ITERATIONS; i++)
+			oquatf_normalize_me(&q);
+		ns[2] = (ohmd_get_tick() - start) * 1e9 / ITERATIONS;
+
+		mat4x4f m = l;
+		start = ohmd_get_tick();
+		for(int i = 0; i < ITERATIONS; i++)
+			omat4x4f_mult(&m, &r, &m);
+		ns[3] = (ohmd_get_tick() - start) * 1e9 / ITERATIONS;
+
+		start = ohmd_get_tick();
+		for(int i = 0; i < ITERATIONS / 2; i++){
+			omat4x4f_transpose(&m, &t);
+			omat4x4f_transpose(&t, &m);
+		}
+		ns[4] = (ohmd_get_tick() - start) * 1e9 / ITERATIONS;
+
+		bench_sink = q.w + out.x + m.arr[0];
+
+		printf("   %-8s %12.2f %12.2f %12.2f %12.2f %12.2f\n", omath_get_impl_name(impl), ns[0], ns[1], ns[2], ns[3], ns[4]);
+	}
+
+	omath_set_impl(prev);
+}
+
+#define POINTS 4096
+
+void bench_transform_points()
+{
+	static float in[POINTS * 3], out[POINTS * 3];
+	quatf rot = {{0.1f, 0.2f, 0.3f, 0.927f}};
+	vec3f pos = {{1, 2, 3}};
+	mat4x4f mat;
+
+	oquatf_normalize_me(&rot);
+	oquatf_get_mat4x4(&rot, &pos, mat.m);
+
+	for(int i = 0; i < POINTS * 3; i++)
+		in[i] = i * 0.001f;
+
+	omath_impl prev = omath_get_impl();
+
+	printf("   %-8s %12s %12s\n", "impl", "aos ns/pt", "soa ns/pt");
+
+	for(int impl = 0; impl < OMATH_IMPL_COUNT; impl++){
+		if(omath_set_impl(impl) != 0)
+			continue;
+
+		double start = ohmd_get_tick();
+		for(int i = 0; i < 1000; i++)
+			omat4x4f_transform_points_aos(&mat, in, out, POINTS);
+		double aos = (ohmd_get_tick() - start) * 1e9 / (1000.0 * POINTS);
+
+		start = ohmd_get_tick();
+		for(int i = 0; i < 1000; i++)
+			omat4x4f_transform_points_soa(&mat, in, out, POINTS);
+		double soa = (ohmd_get_tick() - start) * 1e9 / (1000.0 * POINTS);
+
+		bench_sink = out[0];
+
+		printf("   %-8s %12.3f %12.3f\n", omath_get_impl_name(impl), aos, soa);
+	}
+
+	omath_set_impl(prev);
+}
+
+#define EYE_VIEW_ITERATIONS 1000000
+
+void bench_eye_views()
+{
+	quatf rot = {{0.1f, 0.2f, 0.3f, 0.927f}};
+	vec3f pos = {{1, 2, 3}}, point = {{0, 0, 0}};
+	float ipd = 0.064f;
+	float left[16], right[16];
+
+	oquatf_normalize_me(&rot);
+
+	// both eyes the way getf used to build them
+	double start = ohmd_get_tick();
+	for(int i = 0; i < EYE_VIEW_ITERATIONS; i++){
+		mat4x4f orient, world_shift, result;
+		rot.w += 1e-9f;
+
+		omat4x4f_init_look_at(&orient, &rot, &point);
+		omat4x4f_init_translate(&world_shift, -pos.x + ipd / 2.0f, -pos.y, -pos.z);
+		omat4x4f_mult(&world_shift, &orient, &result);
+		omat4x4f_transpose(&result, (mat4x4f*)left);
+
+		omat4x4f_init_look_at(&orient, &rot, &point);
+		omat4x4f_init_translate(&world_shift, -pos.x - ipd / 2.0f, -pos.y, -pos.z);
+		omat4x4f_mult(&world_shift, &orient, &result);
+		omat4x4f_transpose(&result, (mat4x4f*)right);
+
+		bench_sink = left[0] + right[12];
+	}
+	double chain = (ohmd_get_tick() - start) * 1e9 / EYE_VIEW_ITERATIONS;
+
+	start = ohmd_get_tick();
+	for(int i = 0; i < EYE_VIEW_ITERATIONS; i++){
+		rot.w += 1e-9f;
+		omat4x4f_init_eye_views_gl(&rot, &pos, ipd, left, right);
+		bench_sink = left[0] + right[12];
+	}
+	double gl = (ohmd_get_tick() - start) * 1e9 / EYE_VIEW_ITERATIONS;
+
+	start = ohmd_get_tick();
+	for(int i = 0; i < EYE_VIEW_ITERATIONS; i++){
+		rot.w += 1e-9f;
+		omat3x4f_init_eye_views(&rot, &pos, ipd, left, right);
+		bench_sink = left[0] + right[11];
+	}
+	double affine = (ohmd_get_tick() - start) * 1e9 / EYE_VIEW_ITERATIONS;
+
+	printf("   %-8s %12s %12s %12s\n", "eyes", "chain ns", "gl 4x4 ns", "3x4 ns");
+	printf("   %-8s %12.2f %12.2f %12.2f\n", "both", chain, gl, affine);
+}
@@ -0,0 +1,84 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Fusion Per Sample */
+
+#include "bench.h"
+#include "fusion_batch.h"
+
+#define SAMPLES 1024
+
+static vec3f ang_vel[SAMPLES], accel[SAMPLES], mag[SAMPLES];
+static fusion f;
+static fusion_batch batch;
+
+// n samples through the fusion state prepared by the setup function of the case
+static void run_fusion(long n)
+{
+	for(long i = 0; i < n; i++){
+		int s = i & (SAMPLES - 1);
+		ofusion_update(&f, 0.001f, ang_vel + s, accel + s, mag + s);
+	}
+
+	bench_sink = f.orient.w;
+}
+
+#define FUSION_CASE(_name, _algorithm, _flags, _interval) \
+	static void setup_##_name() \
+	{ \
+		ofusion_init(&f); \
+		ofusion_set_algorithm(&f, _algorithm); \
+		f.flags = _flags; \
+		f.fuse_interval = _interval; \
+	}
+
+FUSION_CASE(complementary, OHMD_FUSION_COMPLEMENTARY, FF_USE_GRAVITY, 1)
+FUSION_CASE(complementary_bias_mag, OHMD_FUSION_COMPLEMENTARY, FF_USE_GRAVITY | FF_USE_GYRO_BIAS | FF_USE_MAG, 1)
+FUSION_CASE(complementary_window_4, OHMD_FUSION_COMPLEMENTARY, FF_USE_GRAVITY, 4)
+FUSION_CASE(complementary_double, OHMD_FUSION_COMPLEMENTARY, FF_USE_GRAVITY | FF_DOUBLE_PRECISION, 1)
+FUSION_CASE(madgwick, OHMD_FUSION_MADGWICK, FF_USE_GRAVITY, 1)
+FUSION_CASE(mahony, OHMD_FUSION_MAHONY, FF_USE_GRAVITY, 1)
+
+// one sample for each of 64 devices and a batch update, per device
+static void op_batch_64_per_device(long n)
+{
+	for(long i = 0; i < n; i += 64){
+		for(int d = 0; d < 64; d++)
+			ofusion_batch_set_sample(&batch, d, 0.001f, ang_vel + d, accel + d);
+
+		ofusion_batch_update(&batch);
+	}
+
+	bench_sink = batch.ow[0];
+}
+
+void bench_ops_fusion()
+{
+	static const bench_case cases[] = {
+		{ "ofusion_update_complementary", run_fusion, setup_complementary },
+		{ "ofusion_update_complementary_bias_mag", run_fusion, setup_complementary_bias_mag },
+		{ "ofusion_update_complementary_window_4", run_fusion, setup_complementary_window_4 },
+		{ "ofusion_update_complementary_double", run_fusion, setup_complementary_double },
+		{ "ofusion_update_madgwick", run_fusion, setup_madgwick },
+		{ "ofusion_update_mahony", run_fusion, setup_mahony },
+		{ "ofusion_batch_update_64_per_device", op_batch_64_per_device },
+	};
+
+	// slow head motion with gravity and a magnetic field
+	for(int i = 0; i < SAMPLES; i++){
+		float t = i * 0.001f;
+		ang_vel[i] = (vec3f){{ 0.3f * sinf(5 * t), 0.2f * cosf(3 * t), 0.01f }};
+		accel[i] = (vec3f){{ 0.2f * sinf(2 * t), 9.81f, 0.1f * cosf(7 * t) }};
+		mag[i] = (vec3f){{ 0.3f, -0.4f, 0.1f }};
+	}
+
+	ofusion_batch_init(&batch);
+	for(int i = 0; i < 64; i++)
+		ofusion_batch_add(&batch);
+
+	bench_run_cases("fusion", cases, sizeof(cases) / sizeof(cases[0]));
+}
@@ -0,0 +1,142 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Math Functions */
+
+// time the exported functions, not their inline versions
+#undef OMATH_INLINE
+
+#include "bench.h"
+
+// exported but not declared in omath.h
+void oquatf_slerp(float fT, const quatf* rkP, const quatf* rkQ, bool shortestPath, quatf* out_q);
+
+#define POINTS 64
+
+static vec3f va = {{0.3f, -1.2f, 0.8f}}, vb = {{-0.5f, 0.25f, 2.0f}}, vout;
+static quatf qa = {{0.1825742f, 0.3651484f, 0.5477226f, 0.7302967f}}, qb = {{0.5f, -0.5f, 0.5f, 0.5f}}, qout;
+static mat4x4f ma, mb, mout;
+static float eye_left[16], eye_right[16];
+static float points_in[POINTS * 3], points_out[POINTS * 3];
+
+static vec3d vda = {{0.3, -1.2, 0.8}}, vdb = {{-0.5, 0.25, 2.0}}, vdout;
+static quatd qda = {{0.1825742, 0.3651484, 0.5477226, 0.7302967}}, qdb = {{0.5, -0.5, 0.5, 0.5}}, qdout;
+static mat4x4d mda, mdb, mdout;
+
+static float fout;
+static double dout;
+
+// one case per function, n calls
+#define OP(_name, _body) static void op_##_name(long n) { for(long i = 0; i < n; i++){ _body; } }
+
+OP(ovec3f_normalize_me, vout = va; ovec3f_normalize_me(&vout))
+OP(ovec3f_get_length, fout += ovec3f_get_length(&va))
+OP(ovec3f_get_angle, fout += ovec3f_get_angle(&va, &vb))
+OP(ovec3f_get_dot, fout += ovec3f_get_dot(&va, &vb))
+OP(ovec3f_subtract, ovec3f_subtract(&va, &vb, &vout))
+
+OP(oquatf_init_axis, oquatf_init_axis(&qout, &va, 0.3f))
+OP(oquatf_init_rotation_vector, oquatf_init_rotation_vector(&qout, &va))
+OP(oquatf_get_rotated, oquatf_get_rotated(&qa, &va, &vout))
+OP(oquatf_mult_me, oquatf_mult_me(&qout, &qa))
+OP(oquatf_mult, oquatf_mult(&qa, &qb, &qout))
+OP(oquatf_diff, oquatf_diff(&qa, &qb, &qout))
+OP(oquatf_normalize_me, qout = qa; oquatf_normalize_me(&qout))
+OP(oquatf_get_length, fout += oquatf_get_length(&qa))
+OP(oquatf_get_dot, fout += oquatf_get_dot(&qa, &qb))
+OP(oquatf_inverse, oquatf_inverse(&qout))
+OP(oquatf_slerp, oquatf_slerp(0.3f, &qa, &qb, true, &qout))
+OP(oquatf_get_mat4x4, oquatf_get_mat4x4(&qa, &va, mout.m))
+
+OP(omat4x4f_init_ident, omat4x4f_init_ident(&mout))
+OP(omat4x4f_init_perspective, omat4x4f_init_perspective(&mout, 1.5f, 0.9f, 0.1f, 1000.0f))
+OP(omat4x4f_init_frustum, omat4x4f_init_frustum(&mout, -0.1f, 0.09f, -0.1f, 0.11f, 0.1f, 1000.0f))
+OP(omat4x4f_init_frustum_tangents, omat4x4f_init_frustum_tangents(&mout, -1.0f, 0.9f, -1.0f, 1.1f, 0.1f, 1000.0f, 0))
+OP(omat4x4f_init_look_at, omat4x4f_init_look_at(&mout, &qa, &va))
+OP(omat4x4f_init_translate, omat4x4f_init_translate(&mout, 1, 2, 3))
+OP(omat4x4f_mult, omat4x4f_mult(&ma, &mb, &mout))
+OP(omat4x4f_transpose, omat4x4f_transpose(&ma, &mout))
+OP(omat4x4f_init_eye_views_gl, omat4x4f_init_eye_views_gl(&qa, &va, 0.064f, eye_left, eye_right))
+OP(omat3x4f_init_eye_views, omat3x4f_init_eye_views(&qa, &va, 0.064f, eye_left, eye_right))
+OP(omat4x4f_transform_points_aos_64, omat4x4f_transform_points_aos(&ma, points_in, points_out, POINTS))
+OP(omat4x4f_transform_points_soa_64, omat4x4f_transform_points_soa(&ma, points_in, points_out, POINTS))
+
+OP(ovec3d_normalize_me, vdout = vda; ovec3d_normalize_me(&vdout))
+OP(ovec3d_get_length, dout += ovec3d_get_length(&vda))
+OP(ovec3d_get_dot, dout += ovec3d_get_dot(&vda, &vdb))
+OP(ovec3d_subtract, ovec3d_subtract(&vda, &vdb, &vdout))
+OP(ovec3d_from_vec3f, ovec3d_from_vec3f(&vdout, &va))
+OP(ovec3d_get_vec3f, ovec3d_get_vec3f(&vda, &vout))
+
+OP(oquatd_init_axis, oquatd_init_axis(&qdout, &vda, 0.3))
+OP(oquatd_init_rotation_vector, oquatd_init_rotation_vector(&qdout, &vda))
+OP(oquatd_get_rotated, oquatd_get_rotated(&qda, &vda, &vdout))
+OP(oquatd_mult_me, oquatd_mult_me(&qdout, &qda))
+OP(oquatd_mult, oquatd_mult(&qda, &qdb, &qdout))
+OP(oquatd_diff, oquatd_diff(&qda, &qdb, &qdout))
+OP(oquatd_normalize_me, qdout = qda; oquatd_normalize_me(&qdout))
+OP(oquatd_get_length, dout += oquatd_get_length(&qda))
+OP(oquatd_get_dot, dout += oquatd_get_dot(&qda, &qdb))
+OP(oquatd_inverse, oquatd_inverse(&qdout))
+OP(oquatd_get_mat4x4, oquatd_get_mat4x4(&qda, &vda, mdout.m))
+OP(oquatd_from_quatf, oquatd_from_quatf(&qdout, &qa))
+OP(oquatd_get_quatf, oquatd_get_quatf(&qda, &qout))
+
+OP(omat4x4d_init_ident, omat4x4d_init_ident(&mdout))
+OP(omat4x4d_init_translate, omat4x4d_init_translate(&mdout, 1, 2, 3))
+OP(omat4x4d_mult, omat4x4d_mult(&mda, &mdb, &mdout))
+OP(omat4x4d_transpose, omat4x4d_transpose(&mda, &mdout))
+OP(omat4x4d_get_mat4x4f, omat4x4d_get_mat4x4f(&mda, &mout))
+
+#define CASE(_name) { #_name, op_##_name }
+
+static const bench_case vec_cases[] = {
+	CASE(ovec3f_normalize_me), CASE(ovec3f_get_length), CASE(ovec3f_get_angle), CASE(ovec3f_get_dot),
+	CASE(ovec3f_subtract),
+	CASE(ovec3d_normalize_me), CASE(ovec3d_get_length), CASE(ovec3d_get_dot), CASE(ovec3d_subtract),
+	CASE(ovec3d_from_vec3f), CASE(ovec3d_get_vec3f),
+};
+
+static const bench_case quat_cases[] = {
+	CASE(oquatf_init_axis), CASE(oquatf_init_rotation_vector), CASE(oquatf_get_rotated), CASE(oquatf_mult_me),
+	CASE(oquatf_mult), CASE(oquatf_diff), CASE(oquatf_normalize_me), CASE(oquatf_get_length),
+	CASE(oquatf_get_dot), CASE(oquatf_inverse), CASE(oquatf_slerp), CASE(oquatf_get_mat4x4),
+	CASE(oquatd_init_axis), CASE(oquatd_init_rotation_vector), CASE(oquatd_get_rotated), CASE(oquatd_mult_me),
+	CASE(oquatd_mult), CASE(oquatd_diff), CASE(oquatd_normalize_me), CASE(oquatd_get_length),
+	CASE(oquatd_get_dot), CASE(oquatd_inverse), CASE(oquatd_get_mat4x4), CASE(oquatd_from_quatf),
+	CASE(oquatd_get_quatf),
+};
+
+static const bench_case mat_cases[] = {
+	CASE(omat4x4f_init_ident), CASE(omat4x4f_init_perspective), CASE(omat4x4f_init_frustum),
+	CASE(omat4x4f_init_frustum_tangents), CASE(omat4x4f_init_look_at), CASE(omat4x4f_init_translate),
+	CASE(omat4x4f_mult), CASE(omat4x4f_transpose), CASE(omat4x4f_init_eye_views_gl), CASE(omat3x4f_init_eye_views),
+	CASE(omat4x4f_transform_points_aos_64), CASE(omat4x4f_transform_points_soa_64),
+	CASE(omat4x4d_init_ident), CASE(omat4x4d_init_translate), CASE(omat4x4d_mult), CASE(omat4x4d_transpose),
+	CASE(omat4x4d_get_mat4x4f),
+};
+
+void bench_ops_omath()
+{
+	qout = qa;
+	qdout = qda;
+
+	oquatf_get_mat4x4(&qa, &va, ma.m);
+	oquatf_get_mat4x4(&qb, &vb, mb.m);
+	oquatd_get_mat4x4(&qda, &vda, mda.m);
+	oquatd_get_mat4x4(&qdb, &vdb, mdb.m);
+
+	for(int i = 0; i < POINTS * 3; i++)
+		points_in[i] = i * 0.01f;
+
+	bench_run_cases("vec3", vec_cases, sizeof(vec_cases) / sizeof(vec_cases[0]));
+	bench_run_cases("quat", quat_cases, sizeof(quat_cases) / sizeof(quat_cases[0]));
+	bench_run_cases("mat4x4", mat_cases, sizeof(mat_cases) / sizeof(mat_cases[0]));
+
+	bench_sink = fout + (float)dout + vout.x + qout.w + mout.arr[0] + eye_left[0] + points_out[0]
+		+ (float)(vdout.x + qdout.w + mdout.arr[0]);
+}
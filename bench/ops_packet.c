@@ -0,0 +1,46 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Packet Decoders */
+
+#include "bench.h"
+#include "fuzz.h"
+
+/*
+ * Decodes the first seed report of every per report fuzz target, through the
+ * same entry the fuzzers use, so a decoder change is measured on exactly what
+ * was fuzzed. The ops/s column is the number of reports a driver can decode.
+ */
+
+static const fuzz_target* target;
+static unsigned char report[FUZZ_MAX_REPORT_SIZE];
+static int report_size;
+
+static void op_decode(long n)
+{
+	for(long i = 0; i < n; i++)
+		target->decode(report, report_size);
+}
+
+void bench_ops_packet()
+{
+	const fuzz_target* t;
+	char group[64];
+
+	for(int i = 0; (t = fuzz_get_target(i)); i++){
+		if(!t->per_report)
+			continue;
+
+		bench_case c = { t->name, op_decode };
+
+		target = t;
+		report_size = t->seed(0, report);
+
+		snprintf(group, sizeof(group), "packet %s", t->driver);
+		bench_run_cases(group, &c, 1);
+	}
+}
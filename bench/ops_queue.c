@@ -0,0 +1,89 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Microbenchmarks - Filter Queue And Event Queue */
+
+#include "bench.h"
+
+static filter_queue fq;
+static ohmdq* q;
+static vec3f sample = {{0.1f, 9.8f, -0.2f}}, mean;
+
+static void op_ofq_add(long n)
+{
+	for(long i = 0; i < n; i++){
+		sample.x += 0.001f;
+		ofq_add(&fq, &sample);
+	}
+}
+
+static void op_ofq_get_mean(long n)
+{
+	for(long i = 0; i < n; i++){
+		ofq_get_mean(&fq, &mean);
+		bench_sink = mean.x;
+	}
+}
+
+// a push and a pop, the queue never fills up
+static void op_ohmdq_push_pop(long n)
+{
+	ohmd_digital_input_event event = { 3, OHMD_BUTTON_DOWN }, out;
+
+	for(long i = 0; i < n; i++){
+		ohmdq_push(q, &event);
+		ohmdq_pop(q, &out);
+	}
+
+	bench_sink = out.idx;
+}
+
+// fill the queue, then drain it
+static void op_ohmdq_fill_drain(long n)
+{
+	ohmd_digital_input_event event = { 3, OHMD_BUTTON_DOWN }, out;
+	unsigned max = ohmdq_get_max(q);
+
+	for(long i = 0; i < n; i += max){
+		for(unsigned j = 0; j < max; j++)
+			ohmdq_push(q, &event);
+		for(unsigned j = 0; j < max; j++)
+			ohmdq_pop(q, &out);
+	}
+
+	bench_sink = out.idx;
+}
+
+void bench_ops_queue()
+{
+	static const bench_case fq_cases[] = {
+		{ "ofq_add", op_ofq_add },
+		{ "ofq_get_mean_20", op_ofq_get_mean },
+	};
+
+	static const bench_case q_cases[] = {
+		{ "ohmdq_push_pop", op_ohmdq_push_pop },
+		{ "ohmdq_fill_drain_per_event", op_ohmdq_fill_drain },
+	};
+
+	// the queue sizes the fusion code and devices use
+	ofq_init(&fq, 20);
+	for(int i = 0; i < 20; i++)
+		ofq_add(&fq, &sample);
+
+	ohmd_context* ctx = ohmd_ctx_create();
+	if(!ctx)
+		return;
+
+	q = ohmdq_create(ctx, sizeof(ohmd_digital_input_event), 256);
+
+	bench_run_cases("filter_queue", fq_cases, sizeof(fq_cases) / sizeof(fq_cases[0]));
+	bench_run_cases("ohmdq", q_cases, sizeof(q_cases) / sizeof(q_cases[0]));
+
+	ohmdq_destroy(q);
+	ohmd_ctx_destroy(ctx);
+}
@@ -0,0 +1,73 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Seed Corpus Writer */
+
+#include <stdio.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "fuzz.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(_path) _mkdir(_path)
+#else
+#define make_dir(_path) mkdir(_path, 0755)
+#endif
+
+static int write_seeds(const char* dir, const fuzz_target* target)
+{
+	static unsigned char buffer[FUZZ_MAX_REPORT_SIZE];
+	char path[1024];
+	int idx, size;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, target->name);
+	if(make_dir(path) && errno != EEXIST){
+		fprintf(stderr, "could not create %s\n", path);
+		return -1;
+	}
+
+	for(idx = 0; (size = target->seed(idx, buffer)) > 0; idx++){
+		snprintf(path, sizeof(path), "%s/%s/seed-%d", dir, target->name, idx);
+
+		FILE* f = fopen(path, "wb");
+		if(!f || fwrite(buffer, 1, size, f) != (size_t)size){
+			fprintf(stderr, "could not write %s\n", path);
+			if(f)
+				fclose(f);
+			return -1;
+		}
+
+		fclose(f);
+	}
+
+	printf("%-28s %d seeds\n", target->name, idx);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const fuzz_target* target;
+
+	if(argc != 2){
+		printf("usage: %s <corpus directory>\n", argv[0]);
+		printf("writes the seed reports of every target to <corpus directory>/<target>/\n");
+		return 1;
+	}
+
+	if(make_dir(argv[1]) && errno != EEXIST){
+		fprintf(stderr, "could not create %s\n", argv[1]);
+		return 1;
+	}
+
+	for(int i = 0; (target = fuzz_get_target(i)); i++){
+		if(write_seeds(argv[1], target))
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Deepoon */
+
+#include <string.h>
+#include "fuzz.h"
+#include "drv_deepoon/deepoon.h"
+
+static volatile float sink;
+
+static void decode_range(const unsigned char* data, size_t size)
+{
+	pkt_sensor_range range;
+	if(dp_decode_sensor_range(&range, data, size))
+		sink = range.accel_scale;
+}
+
+static void decode_display_info(const unsigned char* data, size_t size)
+{
+	pkt_sensor_display_info info;
+	if(dp_decode_sensor_display_info(&info, data, size))
+		sink = info.lens_separation;
+}
+
+static void decode_config(const unsigned char* data, size_t size)
+{
+	pkt_sensor_config config;
+	if(dp_decode_sensor_config(&config, data, size))
+		sink = config.packet_interval;
+}
+
+static imu_ring samples;
+
+static void decode_tracker(const unsigned char* data, size_t size)
+{
+	if(!dp_decode_tracker_sensor_samples(&samples, data, size))
+		return;
+
+	for(imu_sample* s = imu_ring_pop(&samples); s; s = imu_ring_pop(&samples))
+		sink = s->accel.x + s->gyro.z;
+}
+
+static int seed_range(int idx, unsigned char* buffer)
+{
+	if(idx > 0)
+		return 0;
+
+	buffer[0] = RIFT_CMD_RANGE;
+	fuzz_write16(buffer + 1, 0);
+	buffer[3] = 4;
+	fuzz_write16(buffer + 4, 250);
+	fuzz_write16(buffer + 6, 1000);
+	return 8;
+}
+
+static int seed_display_info(int idx, unsigned char* buffer)
+{
+	if(idx > 0)
+		return 0;
+
+	memset(buffer, 0, 56);
+	buffer[0] = RIFT_CMD_DISPLAY_INFO;
+	buffer[3] = 1;
+	fuzz_write16(buffer + 4, 1920);
+	fuzz_write16(buffer + 6, 1080);
+	fuzz_write32(buffer + 8, 120960);
+	fuzz_write32(buffer + 12, 68040);
+	fuzz_write32(buffer + 16, 34020);
+	fuzz_write32(buffer + 20, 63500);
+	fuzz_write32(buffer + 24, 41000);
+	fuzz_write32(buffer + 28, 41000);
+	return 56;
+}
+
+static int seed_config(int idx, unsigned char* buffer)
+{
+	if(idx > 0)
+		return 0;
+
+	buffer[0] = RIFT_CMD_SENSOR_CONFIG;
+	fuzz_write16(buffer + 1, 0);
+	buffer[3] = 0x20;
+	buffer[4] = 0;
+	fuzz_write16(buffer + 5, 10000);
+	return 7;
+}
+
+static int seed_tracker(int idx, unsigned char* buffer)
+{
+	if(idx > 1)
+		return 0;
+
+	fuzz_fill(buffer, 64, idx);
+	buffer[0] = RIFT_IRQ_SENSORS;
+	buffer[3] = 1;
+	fuzz_write16(buffer + 4, 100 + idx);
+	fuzz_write32(buffer + 8, 1000000 + 1000 * idx);
+
+	for(int i = 0; i < DP_SAMPLE_VECTORS / 2; i++){
+		fuzz_write_sample21(buffer + 12 + 16 * i, 120, 98100, -340);
+		fuzz_write_sample21(buffer + 20 + 16 * i, -12, 30, 7);
+	}
+
+	return 62 + 2 * idx;
+}
+
+const fuzz_target fuzz_targets_deepoon[] = {
+	{ "deepoon_sensor_range", "deepoon", decode_range, seed_range, false },
+	{ "deepoon_display_info", "deepoon", decode_display_info, seed_display_info, false },
+	{ "deepoon_sensor_config", "deepoon", decode_config, seed_config, false },
+	{ "deepoon_tracker_sensor", "deepoon", decode_tracker, seed_tracker, true },
+	{ NULL }
+};
@@ -0,0 +1,37 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Fuzzer Entry Point */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "fuzz.h"
+
+#ifndef FUZZ_TARGET
+#error "define FUZZ_TARGET to the name of the target to build"
+#endif
+
+#define STR(_x) #_x
+#define XSTR(_x) STR(_x)
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	static const fuzz_target* target = NULL;
+
+	if(!target){
+		target = fuzz_find_target(XSTR(FUZZ_TARGET));
+		if(!target){
+			fprintf(stderr, "fuzz target %s is not built\n", XSTR(FUZZ_TARGET));
+			abort();
+		}
+	}
+
+	if(size <= FUZZ_MAX_REPORT_SIZE)
+		target->decode(data, size);
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Internal Interface */
+
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Every decoder that parses input from a device is a fuzz target. A target
+ * feeds an arbitrary buffer to its decoder the way the driver does, and can
+ * synthesize valid reports to seed a corpus and to benchmark the decoder with.
+ *
+ * Each target is built into its own openhmd-fuzz-<target> binary, either
+ * linked against libFuzzer or with a main that runs the files given on the
+ * command line, for AFL and for reproducing crashes. openhmd-fuzz-corpus
+ * writes the seed reports of every target to <dir>/<target>/.
+ */
+
+// larger than any report, the vive config is the largest input
+#define FUZZ_MAX_REPORT_SIZE 4096
+
+typedef struct {
+	const char* name;
+	const char* driver;
+
+	// runs the decoder on untrusted input
+	void (*decode)(const unsigned char* data, size_t size);
+
+	// writes seed report idx to buffer and returns its size, 0 past the last seed
+	int (*seed)(int idx, unsigned char* buffer);
+
+	// decoded for every input report, these are the ones benchmarked
+	bool per_report;
+} fuzz_target;
+
+// NULL past the last target of the drivers that are built
+const fuzz_target* fuzz_get_target(int idx);
+const fuzz_target* fuzz_find_target(const char* name);
+
+// per driver target lists, terminated by an entry without a name
+extern const fuzz_target fuzz_targets_rift[];
+extern const fuzz_target fuzz_targets_deepoon[];
+extern const fuzz_target fuzz_targets_psvr[];
+extern const fuzz_target fuzz_targets_vive[];
+extern const fuzz_target fuzz_targets_nolo[];
+
+// helpers for writing seed reports
+void fuzz_write16(unsigned char* p, uint16_t v);
+void fuzz_write32(unsigned char* p, uint32_t v);
+void fuzz_fill(unsigned char* p, int size, uint32_t seed);
+void fuzz_write_sample21(unsigned char* p, int32_t x, int32_t y, int32_t z);
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - NOLO VR */
+
+#include <string.h>
+#include "fuzz.h"
+#include "drv_nolo/nolo.h"
+
+#define CONTROLLERS_REPORT 0xa5
+#define HMD_REPORT 0xa6
+
+static drv_priv* get_priv()
+{
+	static drv_priv priv;
+	static ohmd_context* ctx = NULL;
+
+	if(!ctx){
+		ctx = ohmd_ctx_create();
+		priv.base.digital_input_event_queue = ohmdq_create(ctx, sizeof(ohmd_digital_input_event), 64);
+	}
+
+	return &priv;
+}
+
+// as update_device handles a report, with both controllers connected
+static void decode_report(const unsigned char* data, size_t size)
+{
+	unsigned char buffer[FEATURE_BUFFER_SIZE] = {0};
+	drv_priv* priv = get_priv();
+	ohmd_digital_input_event event;
+
+	memcpy(buffer, data, OHMD_MIN(size, sizeof(buffer)));
+
+	switch(buffer[0]){
+	case CONTROLLERS_REPORT:
+		nolo_decrypt_data_from(buffer, 1);
+		nolo_decode_controller(priv, buffer + 1);
+		nolo_decode_controller(priv, buffer + 64 - NOLO_CONTROLLER_LENGTH);
+		break;
+
+	case HMD_REPORT:
+		nolo_decrypt_data_from(buffer, 0x15);
+		nolo_decode_hmd_marker(priv, buffer + 0x15);
+		nolo_decode_base_station(priv, buffer + 0x36);
+		break;
+
+	default:
+		nolo_decrypt_data(buffer);
+		break;
+	}
+
+	while(ohmdq_pop(priv->base.digital_input_event_queue, &event));
+}
+
+#define DELTA 0x9e3779b9
+#define MX (((z>>5^y<<2) + (y>>3^z<<4)) ^ ((sum^y) + (key[(p&3)^e] ^ z)))
+
+// the inverse of btea_decrypt, for building seed reports
+static void encrypt_report(unsigned char* buffer)
+{
+	static const uint32_t key[4] = {0x875bcc51, 0xa7637a66, 0x50960967, 0xf8536c51};
+	const unsigned n = 15;
+	uint32_t v[15], y, z, sum = 0;
+	unsigned p, e, rounds = 1 + 52 / n;
+
+	for(unsigned i = 0; i < n; i++)
+		v[i] = buffer[1 + 4 * i] | buffer[2 + 4 * i] << 8 | buffer[3 + 4 * i] << 16 | (uint32_t)buffer[4 + 4 * i] << 24;
+
+	z = v[n - 1];
+	do {
+		sum += DELTA;
+		e = (sum >> 2) & 3;
+		for(p = 0; p < n - 1; p++){
+			y = v[p + 1];
+			z = v[p] += MX;
+		}
+		y = v[0];
+		z = v[n - 1] += MX;
+	} while(--rounds);
+
+	for(unsigned i = 0; i < n; i++)
+		fuzz_write32(buffer + 1 + 4 * i, v[i]);
+}
+
+static void write_be16(unsigned char* p, int16_t v)
+{
+	p[0] = (uint16_t)v >> 8;
+	p[1] = v;
+}
+
+static void write_position(unsigned char* p, int16_t x, int16_t y, int16_t z)
+{
+	write_be16(p, x);
+	write_be16(p + 2, y);
+	write_be16(p + 4, z);
+}
+
+// identity orientation, in 1/16384
+static void write_orientation(unsigned char* p)
+{
+	write_be16(p, 16384);
+	write_be16(p + 2, 0);
+	write_be16(p + 4, 0);
+	write_be16(p + 6, 0);
+}
+
+static void write_controller(unsigned char* data, int16_t x, uint8_t buttons)
+{
+	data[0] = 2;
+	data[1] = 1;
+	write_position(data + 3, x, 15000, 4000);
+	write_orientation(data + 3 + 3 * 2);
+	data[3 + 3 * 2 + 4 * 2] = buttons;
+}
+
+static void write_hmd_marker(unsigned char* data)
+{
+	data[0] = 2;
+	data[1] = 1;
+	write_position(data + 3, 0, 17000, 3000);
+	write_position(data + 3 + 3 * 2, 0, 17000, 3000);
+	write_orientation(data + 3 + 2 * 3 * 2 + 1);
+}
+
+// a controllers report, an HMD report and one of an unknown type
+static int seed_report(int idx, unsigned char* buffer)
+{
+	if(idx > 2)
+		return 0;
+
+	fuzz_fill(buffer, FEATURE_BUFFER_SIZE, idx);
+
+	switch(idx){
+	case 0:
+		buffer[0] = CONTROLLERS_REPORT;
+		write_controller(buffer + 1, -2000, 0x05);
+		write_controller(buffer + 64 - NOLO_CONTROLLER_LENGTH, 2000, 0x00);
+		break;
+
+	case 1:
+		buffer[0] = HMD_REPORT;
+		write_hmd_marker(buffer + 0x15);
+		buffer[0x36] = 2;
+		buffer[0x37] = 1;
+		break;
+
+	default:
+		buffer[0] = 0xa7;
+		break;
+	}
+
+	encrypt_report(buffer);
+	return FEATURE_BUFFER_SIZE;
+}
+
+const fuzz_target fuzz_targets_nolo[] = {
+	{ "nolo_report", "nolo", decode_report, seed_report, true },
+	{ NULL }
+};
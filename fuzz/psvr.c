@@ -0,0 +1,58 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Sony PSVR */
+
+#include <string.h>
+#include "fuzz.h"
+#include "drv_psvr/psvr.h"
+
+static volatile float sink;
+
+static imu_ring samples;
+
+static void decode_sensor(const unsigned char* data, size_t size)
+{
+	if(!psvr_decode_sensor_samples(&samples, data, size))
+		return;
+
+	for(imu_sample* s = imu_ring_pop(&samples); s; s = imu_ring_pop(&samples))
+		sink = s->gyro.x + s->accel.z;
+}
+
+// two samples 500 us apart, seed 1 with the tick wrapping in between
+static int seed_sensor(int idx, unsigned char* buffer)
+{
+	if(idx > 1)
+		return 0;
+
+	uint32_t tick = idx ? 0xffffff00 : 1000000;
+
+	fuzz_fill(buffer, 64, idx);
+	buffer[0] = PSVR_IRQ_SENSORS;
+	fuzz_write16(buffer + 2, 12);
+
+	for(int i = 0; i < PSVR_SAMPLES; i++){
+		unsigned char* s = buffer + 16 + 16 * i;
+		fuzz_write32(s, tick + 500 * i);
+		fuzz_write16(s + 4, 3);
+		fuzz_write16(s + 6, -5);
+		fuzz_write16(s + 8, 1);
+		fuzz_write16(s + 10, 16);
+		fuzz_write16(s + 12, 4096);
+		fuzz_write16(s + 14, -40);
+	}
+
+	buffer[55] = 255;
+	buffer[56] = 3;
+	return 64;
+}
+
+const fuzz_target fuzz_targets_psvr[] = {
+	{ "psvr_sensor", "psvr", decode_sensor, seed_sensor, true },
+	{ NULL }
+};
@@ -0,0 +1,157 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Oculus Rift */
+
+#include <string.h>
+#include "fuzz.h"
+#include "drv_oculus_rift/rift.h"
+
+static volatile float sink;
+
+static void decode_range(const unsigned char* data, size_t size)
+{
+	pkt_sensor_range range;
+	if(decode_sensor_range(&range, data, size))
+		sink = range.accel_scale;
+}
+
+static void decode_display_info(const unsigned char* data, size_t size)
+{
+	pkt_sensor_display_info info;
+	if(decode_sensor_display_info(&info, data, size))
+		sink = info.lens_separation;
+}
+
+static void decode_config(const unsigned char* data, size_t size)
+{
+	pkt_sensor_config config;
+	if(decode_sensor_config(&config, data, size))
+		sink = config.packet_interval;
+}
+
+static imu_ring samples;
+
+// as handle_tracker_sensor_msg drains the ring
+static void use_samples(void)
+{
+	for(imu_sample* s = imu_ring_pop(&samples); s; s = imu_ring_pop(&samples))
+		sink = s->accel.x + s->gyro.z + s->mag.y;
+}
+
+static void decode_tracker(const unsigned char* data, size_t size)
+{
+	if(decode_tracker_sensor_samples(&samples, data, size))
+		use_samples();
+}
+
+static void decode_tracker_dk2(const unsigned char* data, size_t size)
+{
+	if(decode_tracker_sensor_samples_dk2(&samples, data, size))
+		use_samples();
+}
+
+static int seed_range(int idx, unsigned char* buffer)
+{
+	if(idx > 0)
+		return 0;
+
+	buffer[0] = RIFT_CMD_RANGE;
+	fuzz_write16(buffer + 1, 0);
+	buffer[3] = 4;
+	fuzz_write16(buffer + 4, 250);
+	fuzz_write16(buffer + 6, 1000);
+	return 8;
+}
+
+static int seed_display_info(int idx, unsigned char* buffer)
+{
+	if(idx > 0)
+		return 0;
+
+	memset(buffer, 0, 56);
+	buffer[0] = RIFT_CMD_DISPLAY_INFO;
+	buffer[3] = 1;
+	fuzz_write16(buffer + 4, 1280);
+	fuzz_write16(buffer + 6, 800);
+	fuzz_write32(buffer + 8, 149760);
+	fuzz_write32(buffer + 12, 93600);
+	fuzz_write32(buffer + 16, 46800);
+	fuzz_write32(buffer + 20, 63500);
+	fuzz_write32(buffer + 24, 41000);
+	fuzz_write32(buffer + 28, 41000);
+	return 56;
+}
+
+static int seed_config(int idx, unsigned char* buffer)
+{
+	if(idx > 0)
+		return 0;
+
+	buffer[0] = RIFT_CMD_SENSOR_CONFIG;
+	fuzz_write16(buffer + 1, 0);
+	buffer[3] = 0x20;
+	buffer[4] = 0;
+	fuzz_write16(buffer + 5, 10000);
+	return 7;
+}
+
+// one to three samples of a headset lying still
+static int seed_tracker(int idx, unsigned char* buffer)
+{
+	if(idx > 2)
+		return 0;
+
+	fuzz_fill(buffer, 62, idx);
+	buffer[0] = RIFT_IRQ_SENSORS;
+	buffer[1] = idx + 1;
+	fuzz_write16(buffer + 2, 1000 * idx);
+	fuzz_write16(buffer + 4, 0);
+	fuzz_write16(buffer + 6, 2500);
+
+	for(int i = 0; i < 3; i++){
+		fuzz_write_sample21(buffer + 8 + 16 * i, 120, 98100, -340);
+		fuzz_write_sample21(buffer + 16 + 16 * i, -12, 30, 7);
+	}
+
+	fuzz_write16(buffer + 56, 120);
+	fuzz_write16(buffer + 58, -2200);
+	fuzz_write16(buffer + 60, 431);
+	return 62;
+}
+
+static int seed_tracker_dk2(int idx, unsigned char* buffer)
+{
+	if(idx > 1)
+		return 0;
+
+	fuzz_fill(buffer, 64, idx);
+	buffer[0] = RIFT_IRQ_SENSORS_DK2;
+	fuzz_write16(buffer + 1, 0);
+	buffer[3] = idx + 1;
+	fuzz_write16(buffer + 6, 2500);
+	fuzz_write32(buffer + 8, 1000000 + 1000 * idx);
+
+	for(int i = 0; i < 2; i++){
+		fuzz_write_sample21(buffer + 12 + 16 * i, 120, 98100, -340);
+		fuzz_write_sample21(buffer + 20 + 16 * i, -12, 30, 7);
+	}
+
+	fuzz_write16(buffer + 44, 120);
+	fuzz_write16(buffer + 46, -2200);
+	fuzz_write16(buffer + 48, 431);
+	return 64;
+}
+
+const fuzz_target fuzz_targets_rift[] = {
+	{ "rift_sensor_range", "rift", decode_range, seed_range, false },
+	{ "rift_display_info", "rift", decode_display_info, seed_display_info, false },
+	{ "rift_sensor_config", "rift", decode_config, seed_config, false },
+	{ "rift_tracker_sensor", "rift", decode_tracker, seed_tracker, true },
+	{ "rift_tracker_sensor_dk2", "rift", decode_tracker_dk2, seed_tracker_dk2, true },
+	{ NULL }
+};
@@ -0,0 +1,48 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Standalone Main */
+
+#include <stdio.h>
+#include "fuzz.h"
+
+/*
+ * Stands in for the fuzzing engine's main when there is none to link: runs
+ * every file given on the command line through the target, or standard input
+ * when there are none, which is how AFL feeds a target.
+ */
+
+static int run_file(FILE* f)
+{
+	static unsigned char data[FUZZ_MAX_REPORT_SIZE + 1];
+	size_t size = fread(data, 1, sizeof(data), f);
+
+	if(ferror(f))
+		return -1;
+
+	LLVMFuzzerTestOneInput(data, size);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+		return run_file(stdin) ? 1 : 0;
+
+	for(int i = 1; i < argc; i++){
+		FILE* f = fopen(argv[i], "rb");
+
+		if(!f || run_file(f)){
+			fprintf(stderr, "could not read %s\n", argv[i]);
+			return 1;
+		}
+
+		fclose(f);
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - Target Registry */
+
+#include <string.h>
+#include "fuzz.h"
+
+static const fuzz_target* const driver_targets[] = {
+#ifdef DRIVER_OCULUS_RIFT
+	fuzz_targets_rift,
+#endif
+#ifdef DRIVER_DEEPOON
+	fuzz_targets_deepoon,
+#endif
+#ifdef DRIVER_PSVR
+	fuzz_targets_psvr,
+#endif
+#ifdef DRIVER_HTC_VIVE
+	fuzz_targets_vive,
+#endif
+#ifdef DRIVER_NOLO
+	fuzz_targets_nolo,
+#endif
+	NULL
+};
+
+const fuzz_target* fuzz_get_target(int idx)
+{
+	for(int i = 0; driver_targets[i]; i++){
+		for(const fuzz_target* t = driver_targets[i]; t->name; t++){
+			if(idx-- == 0)
+				return t;
+		}
+	}
+
+	return NULL;
+}
+
+const fuzz_target* fuzz_find_target(const char* name)
+{
+	const fuzz_target* t;
+
+	for(int i = 0; (t = fuzz_get_target(i)); i++){
+		if(strcmp(t->name, name) == 0)
+			return t;
+	}
+
+	return NULL;
+}
+
+void fuzz_write16(unsigned char* p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+void fuzz_write32(unsigned char* p, uint32_t v)
+{
+	fuzz_write16(p, v);
+	fuzz_write16(p + 2, v >> 16);
+}
+
+// deterministic filler for the bytes a decoder doesn't look at
+void fuzz_fill(unsigned char* p, int size, uint32_t seed)
+{
+	for(int i = 0; i < size; i++){
+		seed = seed * 1103515245 + 12345;
+		p[i] = seed >> 16;
+	}
+}
+
+// three 21 bit values packed big endian into 8 bytes, as the Rift sends its samples
+void fuzz_write_sample21(unsigned char* p, int32_t x, int32_t y, int32_t z)
+{
+	uint64_t v = ((uint64_t)(x & 0x1fffff) << 43) | ((uint64_t)(y & 0x1fffff) << 22) | ((uint64_t)(z & 0x1fffff) << 1);
+
+	for(int i = 0; i < 8; i++)
+		p[i] = v >> (56 - 8 * i);
+}
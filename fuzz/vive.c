@@ -0,0 +1,255 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Decoder Fuzzing - HTC Vive */
+
+#include <string.h>
+#include "fuzz.h"
+#include "drv_htc_vive/vive.h"
+
+static volatile float sink;
+
+static imu_ring samples;
+
+static void decode_sensor(const unsigned char* data, size_t size)
+{
+	if(!vive_decode_sensor_samples(&samples, data, size))
+		return;
+
+	for(imu_sample* s = imu_ring_pop(&samples); s; s = imu_ring_pop(&samples))
+		sink = s->gyro.x + s->accel.z;
+}
+
+// as handle_controller_message reads a message
+static void decode_controller(const unsigned char* data, size_t size)
+{
+	vive_controller_packet pkt;
+	vec3f accel, gyro;
+
+	if(!vive_decode_controller_packet(&pkt, data, size))
+		return;
+
+	sink = pkt.message.buttons + pkt.message.trigger + pkt.message.trackpad[0];
+
+	if(pkt.message.flags & VIVE_CONTROLLER_HAS_IMU){
+		vec3f_from_vive_vec_accel(pkt.message.acc, &accel);
+		vec3f_from_vive_vec_gyro(pkt.message.rot, &gyro);
+		sink = accel.y + gyro.x;
+	}
+}
+
+static void decode_lighthouse(const unsigned char* data, size_t size)
+{
+	// from a clean state, every input decodes the same
+	vive_lighthouse_decoder d = { 0 };
+	ohmd_sweep_sample sweeps[VIVE_LIGHTHOUSE_PULSES];
+
+	int count = vive_decode_lighthouse_report(&d, data, size, sweeps);
+	for(int i = 0; i < count; i++)
+		sink = sweeps[i].angle;
+}
+
+static void decode_config(const unsigned char* data, size_t size)
+{
+	// too large for the stack
+	static vive_config_packet pkt;
+
+	if(size <= UINT16_MAX)
+		vive_decode_config_packet(&pkt, data, size);
+}
+
+// three samples, in order, rotated as the device sends them, and with the sequence wrapping
+static int seed_sensor(int idx, unsigned char* buffer)
+{
+	static const uint8_t seqs[3][3] = { { 10, 11, 12 }, { 12, 10, 11 }, { 0, 254, 255 } };
+
+	if(idx > 2)
+		return 0;
+
+	buffer[0] = VIVE_IRQ_SENSORS;
+
+	for(int i = 0; i < 3; i++){
+		unsigned char* s = buffer + 1 + 17 * i;
+		uint8_t seq = seqs[idx][i];
+
+		fuzz_write16(s, 12);
+		fuzz_write16(s + 2, 4096);
+		fuzz_write16(s + 4, -30);
+		fuzz_write16(s + 6, 2);
+		fuzz_write16(s + 8, -3);
+		fuzz_write16(s + 10, 1);
+		fuzz_write32(s + 12, 48000u * seq);
+		s[16] = seq;
+	}
+
+	return 52;
+}
+
+static unsigned char* write_controller_imu(unsigned char* p)
+{
+	*p++ = 0x9c; // low time code byte
+	fuzz_write16(p, 40);
+	fuzz_write16(p + 2, -8192);
+	fuzz_write16(p + 4, 120);
+	fuzz_write16(p + 6, -4);
+	fuzz_write16(p + 8, 7);
+	fuzz_write16(p + 10, 2);
+	return p + 12;
+}
+
+/*
+ * A controller report of each type: buttons alone, every input with an IMU
+ * sample, the battery state followed by an IMU sample and a lone IMU sample.
+ * Reports are 30 bytes, the light sensor data after the message is zero.
+ */
+static int seed_controller(int idx, unsigned char* buffer)
+{
+	unsigned char* p = buffer + 5;
+
+	if(idx > 3)
+		return 0;
+
+	memset(buffer, 0, 30);
+	buffer[0] = VIVE_CONTROLLER_REPORT;
+	buffer[1] = 0x12;
+	buffer[3] = 0x34 + idx;
+
+	switch(idx){
+	case 0:
+		buffer[4] = 0xf1;
+		*p++ = 1 << VIVE_CONTROLLER_TRIGGER | 1 << VIVE_CONTROLLER_TRACKPAD_TOUCH;
+		break;
+
+	case 1:
+		buffer[4] = 0xff;
+		*p++ = 1 << VIVE_CONTROLLER_GRIP;
+		*p++ = 0xc0; // trigger
+		fuzz_write16(p, -1200);
+		fuzz_write16(p + 2, 9000);
+		p = write_controller_imu(p + 4);
+		break;
+
+	case 2:
+		buffer[4] = 0xe1;
+		*p++ = 0x80 | 64; // charging, battery
+		*p++ = 0xe8;
+		p = write_controller_imu(p);
+		break;
+
+	case 3:
+		buffer[4] = 0xe8;
+		p = write_controller_imu(p);
+		break;
+	}
+
+	// counted from the second time code byte
+	buffer[2] = p - (buffer + 3);
+
+	return 30;
+}
+
+static unsigned char* write_pulse(unsigned char* p, uint8_t sensor, uint16_t length, uint32_t time)
+{
+	p[0] = sensor;
+	fuzz_write16(p + 1, length);
+	fuzz_write32(p + 3, time);
+	return p + 7;
+}
+
+/*
+ * Sweeps following sync flashes within a report: one station sweeping the
+ * horizontal axis, two stations where the second one sweeps the vertical
+ * axis, and sweeps without a sync that decode to nothing. Sync pulse lengths
+ * are 3000 ticks plus 500 per code, bit 2 is skip and bit 0 the axis.
+ */
+static int seed_lighthouse(int idx, unsigned char* buffer)
+{
+	const uint32_t t0 = 0xfffe0000; // wraps around during the sweep
+	unsigned char* p = buffer + 1;
+
+	if(idx > 2)
+		return 0;
+
+	memset(buffer, 0xff, 64);
+	buffer[0] = VIVE_LIGHTHOUSE_REPORT;
+
+	switch(idx){
+	case 0:
+		for(int i = 0; i < 4; i++)
+			p = write_pulse(p, i, 3000 - 10 * i, t0 + 3 * i);
+		break;
+
+	case 1:
+		p = write_pulse(p, 0, 5000, t0);
+		p = write_pulse(p, 1, 4990, t0 + 4);
+		p = write_pulse(p, 0, 3500, t0 + 20000);
+		p = write_pulse(p, 1, 3480, t0 + 20002);
+		break;
+
+	case 2:
+		break;
+	}
+
+	// hits from -30 to 30 degrees
+	for(int i = 0; p < buffer + 64; i++)
+		p = write_pulse(p, 8 + i, 150 + 20 * i, t0 + 200000 + (i - 2) * 33333 - 75 - 10 * i);
+
+	return 64;
+}
+
+// zlib stream of stored deflate blocks, the config is sent compressed
+static int write_zlib_stored(unsigned char* buffer, const char* text)
+{
+	int len = strlen(text), pos = 0;
+	uint32_t a = 1, b = 0;
+
+	buffer[pos++] = 0x78;
+	buffer[pos++] = 0x01;
+
+	// a single final stored block, the text is far below its 65535 byte limit
+	buffer[pos++] = 0x01;
+	fuzz_write16(buffer + pos, len);
+	fuzz_write16(buffer + pos + 2, ~len);
+	pos += 4;
+
+	for(int i = 0; i < len; i++){
+		buffer[pos++] = text[i];
+		a = (a + (unsigned char)text[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	// adler32, big endian
+	uint32_t adler = (b << 16) | a;
+	for(int i = 0; i < 4; i++)
+		buffer[pos++] = adler >> (24 - 8 * i);
+
+	return pos;
+}
+
+static int seed_config(int idx, unsigned char* buffer)
+{
+	static const char* configs[] = {
+		"{\"acc_bias\": [0.02, -0.13, 0.04], \"acc_scale\": [0.998, 1.001, 1.0],"
+		" \"device\": {\"eye_target_height_in_pixels\": 1080, \"eye_target_width_in_pixels\": 1200},"
+		" \"device_class\": \"generic_hmd\", \"device_pid\": 8192, \"device_serial_number\": \"LHR-00000000\","
+		" \"device_vid\": 10462, \"gyro_bias\": [0.001, -0.002, 0.0], \"gyro_scale\": [1.0, 1.0, 1.0]}",
+		"{\"acc_bias\": [0, 0, 0], \"gyro_scale\": [1, 1, 1]}",
+	};
+
+	if(idx >= (int)(sizeof(configs) / sizeof(configs[0])))
+		return 0;
+
+	return write_zlib_stored(buffer, configs[idx]);
+}
+
+const fuzz_target fuzz_targets_vive[] = {
+	{ "vive_sensor", "vive", decode_sensor, seed_sensor, true },
+	{ "vive_controller", "vive", decode_controller, seed_controller, true },
+	{ "vive_lighthouse", "vive", decode_lighthouse, seed_lighthouse, true },
+	{ "vive_config", "vive", decode_config, seed_config, false },
+	{ NULL }
+};
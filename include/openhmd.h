@@ -77,10 +77,10 @@ typedef enum {
 	OHMD_RIGHT_EYE_GL_MODELVIEW_MATRIX    =  3,
 
 	/** float[16] (get): A "ready to use" OpenGL style 4x4 matrix with a projection matrix for the
-	    left eye of the HMD. */
+	    left eye of the HMD, see OHMD_PROJECTION_FLAGS for other depth ranges and layouts. */
 	OHMD_LEFT_EYE_GL_PROJECTION_MATRIX    =  4,
 	/** float[16] (get): A "ready to use" OpenGL style 4x4 matrix with a projection matrix for the
-	    right eye of the HMD. */
+	    right eye of the HMD, see OHMD_PROJECTION_FLAGS for other depth ranges and layouts. */
 	OHMD_RIGHT_EYE_GL_PROJECTION_MATRIX   =  5,
 
 	/** float[3] (get): A 3-D vector representing the absolute position of the device, in space. */
@@ -129,6 +129,19 @@ typedef enum {
 	/** float[3] (get): Universal shader aberration coefficients (post warp scaling <r,g,b>. */
 	OHMD_UNIVERSAL_ABERRATION_K           = 21,
 
+	/** float[32] (get): The left and right eye OHMD_*_EYE_GL_MODELVIEW_MATRIX values, left first,
+	    computed together. */
+	OHMD_EYES_GL_MODELVIEW_MATRICES       = 22,
+
+	/** float[24] (get): Modelview matrices for the left and right eye, left first, as row major
+	    3x4 affine matrices (the upper three rows of the 4x4 matrix). */
+	OHMD_EYES_MODELVIEW_AFFINE            = 23,
+
+	/** float[1] (get, set, default: 0): Gain of the magnetometer yaw correction, from 0 (off) to 1. Only devices
+	    with a magnetometer support it, and it is off by default since the field is used without hard or soft iron
+	    calibration, turn it on where the device's own field is known to be small. */
+	OHMD_MAG_CORRECTION_GAIN              = 24,
+
 } ohmd_float_value;
 
 /** A collection of int value information types used for getting information with ohmd_device_geti(). */
@@ -146,6 +159,20 @@ typedef enum {
 	OHMD_BUTTON_COUNT                     =  4,
 	/** int[2] (get): Performs an event pop action. Format: [button_index, button_state], where button_state is either OHMD_BUTTON_DOWN or OHMD_BUTTON_UP */
 	OHMD_BUTTON_POP_EVENT                 =  5,
+
+	/** int[1] (get, set): Sensor fusion algorithm used for the device orientation, see ohmd_fusion_algorithm. */
+	OHMD_FUSION_ALGORITHM                 =  6,
+
+	/** int[1] (get, set, default: 0): How the *_GL_PROJECTION_MATRIX values are built, a combination of ohmd_projection_flags. */
+	OHMD_PROJECTION_FLAGS                 =  7,
+
+	/** int[1] (get): Number of IMU samples lost in transfer since the device was opened. */
+	OHMD_SENSOR_SAMPLES_DROPPED           =  8,
+	/** int[1] (get): Number of IMU samples received more than once since the device was opened, devices that repeat samples across reports count up in normal operation. */
+	OHMD_SENSOR_SAMPLES_DUPLICATED        =  9,
+
+	/** int[1] (get, set): Time between IMU reports in microseconds. Devices round a requested interval to one they support, read it back to get the interval in use. */
+	OHMD_SENSOR_REPORT_INTERVAL           = 10,
 } ohmd_int_value;
 
 /** A collection of data information types used for setting information with ohmd_set_data(). */
@@ -165,8 +192,40 @@ typedef enum {
 	/** int[1] (set, default: 1): Set this to 0 to prevent OpenHMD from creating background threads to do automatic device ticking.
 	    Call ohmd_update(); must be called frequently, at least 10 times per second, if the background threads are disabled. */
 	OHMD_IDS_AUTOMATIC_UPDATE = 0,
+	/** int[1] (set, default: OHMD_FUSION_COMPLEMENTARY): Sensor fusion algorithm to open the device with, see ohmd_fusion_algorithm. */
+	OHMD_IDS_FUSION_ALGORITHM = 1,
 } ohmd_int_settings;
 
+/** Sensor fusion algorithms for devices with an IMU, used with OHMD_FUSION_ALGORITHM and OHMD_IDS_FUSION_ALGORITHM. */
+typedef enum {
+	/** Gyro integration with tilt correction from averaged gravity while the device is level. */
+	OHMD_FUSION_COMPLEMENTARY = 0,
+	/** Madgwick gradient descent filter, continuous gravity correction. */
+	OHMD_FUSION_MADGWICK      = 1,
+	/** Mahony nonlinear complementary filter, gravity error fed back into the gyro rate. */
+	OHMD_FUSION_MAHONY        = 2,
+} ohmd_fusion_algorithm;
+
+/** Flags for OHMD_PROJECTION_FLAGS, the default of 0 is an OpenGL style column major matrix with depth in [-1, 1]. */
+typedef enum {
+	/** Map the near plane to depth 1 and the far plane to the lowest depth, for better precision with floating point depth buffers. */
+	OHMD_PROJECTION_REVERSE_Z         = 1,
+	/** No far plane, OHMD_PROJECTION_ZFAR is ignored. */
+	OHMD_PROJECTION_INFINITE_FAR      = 2,
+	/** Clip space depth in [0, 1] as used by Direct3D and Vulkan, instead of [-1, 1]. */
+	OHMD_PROJECTION_DEPTH_ZERO_TO_ONE = 4,
+	/** Return the matrices row major instead of column major. */
+	OHMD_PROJECTION_ROW_MAJOR         = 8,
+} ohmd_projection_flags;
+
+/** Memory layouts for point arrays passed to ohmd_device_transform_points(). */
+typedef enum {
+	/** Interleaved points: x0, y0, z0, x1, y1, z1, ... */
+	OHMD_POINTS_AOS = 0,
+	/** Separate arrays back to back: count x values, then count y values, then count z values. */
+	OHMD_POINTS_SOA = 1,
+} ohmd_point_layout;
+
 /** Button states for digital input events. */
 typedef enum {
 	/** Button was pressed. */
@@ -175,6 +234,28 @@ typedef enum {
 	OHMD_BUTTON_UP   = 1
 } ohmd_button_state;
 
+/** Sample streams a device can publish, read with ohmd_device_read_stream(). */
+typedef enum {
+	/** ohmd_sweep_sample: Lighthouse base station laser sweeps over the photodiodes of the device. */
+	OHMD_STREAM_LIGHTHOUSE_SWEEPS = 0,
+} ohmd_stream_type;
+
+/** A lighthouse laser sweep hitting one photodiode. */
+typedef struct {
+	/** Device clock time of the middle of the hit, 48 MHz ticks on the HTC Vive, wraps around. */
+	unsigned int timestamp;
+	/** Angle of the sweep in radians, 0 is straight out of the base station. */
+	float angle;
+	/** Duration of the hit in device clock ticks. */
+	unsigned short length;
+	/** Photodiode index on the device. */
+	unsigned char sensor;
+	/** Base station, 0 or 1 in the order of their sync flashes. */
+	unsigned char station;
+	/** Sweep axis, 0 for the horizontal and 1 for the vertical sweep. */
+	unsigned char axis;
+} ohmd_sweep_sample;
+
 /** An opaque pointer to a context structure. */
 typedef struct ohmd_context ohmd_context;
 
@@ -374,6 +455,40 @@ OHMD_APIENTRYDLL int OHMD_APIENTRY ohmd_device_geti(ohmd_device* device, ohmd_in
  **/
 OHMD_APIENTRYDLL int OHMD_APIENTRY ohmd_device_seti(ohmd_device* device, ohmd_int_value type, const int* in);
 
+/**
+ * Transform an array of points by a device pose.
+ *
+ * Rotates each point and then translates it, the same as applying the pose reported by
+ * OHMD_ROTATION_QUAT and OHMD_POSITION_VECTOR, including any corrections set on the device.
+ *
+ * @param device An open device.
+ * @param pose The pose to use as float[7], a rotation quaternion (x, y, z, w) followed by a position (x, y, z),
+ *   or NULL to use the current pose of the device.
+ * @param layout How the points are laid out in memory, see ohmd_point_layout.
+ * @param in The points to transform, 3 * count floats.
+ * @param[out] out Where the transformed points are written, 3 * count floats in the same layout, may be the same as in.
+ * @param count The number of points.
+ * @return 0 on success, <0 on failure.
+ **/
+OHMD_APIENTRYDLL int OHMD_APIENTRY ohmd_device_transform_points(ohmd_device* device, const float* pose, ohmd_point_layout layout,
+                                                                 const float* in, float* out, int count);
+
+/**
+ * Read samples from a stream of a device.
+ *
+ * Samples are buffered from one update to the next, a device keeps a limited
+ * number and drops the oldest unread ones first, so read the stream at least
+ * once per ohmd_ctx_update().
+ *
+ * @param device An open device.
+ * @param type The stream to read, see ohmd_stream_type for the sample type of each.
+ * @param[out] out Where up to max samples are written.
+ * @param max The number of samples out has room for.
+ * @return the number of samples read, 0 when there are none, or <0 on failure,
+ *   OHMD_S_UNSUPPORTED if the device doesn't publish the stream.
+ **/
+OHMD_APIENTRYDLL int OHMD_APIENTRY ohmd_device_read_stream(ohmd_device* device, ohmd_stream_type type, void* out, int max);
+
 /**
  * Set an void* data value for a device.
  *
@@ -15,6 +15,7 @@
 #include <assert.h>
 
 #include "deepoon.h"
+#include "../hid_reader.h"
 
 #define TICK_LEN (1.0f / 1000000.0f) // 1000 Hz ticks
 #define KEEP_ALIVE_VALUE (10 * 1000)
@@ -27,14 +28,15 @@ typedef struct {
 	ohmd_device base;
 
 	hid_device* handle;
+	ohmd_hid_reader reader;
 	pkt_sensor_range sensor_range;
 	pkt_sensor_display_info display_info;
 	rift_coordinate_frame coordinate_frame, hw_coordinate_frame;
 	pkt_sensor_config sensor_config;
-	pkt_tracker_sensor sensor;
+	imu_ring samples;
+	uint32_t last_tick;
 	double last_keep_alive;
 	fusion sensor_fusion;
-	vec3f raw_mag, raw_accel, raw_gyro;
 } rift_priv;
 
 static rift_priv* rift_priv_get(ohmd_device* device)
@@ -87,32 +89,28 @@ static void set_coordinate_frame(rift_priv* priv, rift_coordinate_frame coordfra
 
 static void handle_tracker_sensor_msg(rift_priv* priv, unsigned char* buffer, int size)
 {
-	uint32_t last_sample_tick = priv->sensor.tick;
+	uint32_t last_sample_tick = priv->last_tick;
 
-	if(!dp_decode_tracker_sensor_msg(&priv->sensor, buffer, size)){
+	if(!dp_decode_tracker_sensor_samples(&priv->samples, buffer, size)){
 		LOGE("couldn't decode tracker sensor message");
+		return;
 	}
 
-	pkt_tracker_sensor* s = &priv->sensor;
+	//just use 1 sample since we don't have sample order for this frame
+	imu_sample* s = imu_ring_pop(&priv->samples);
+	dp_dump_tracker_sensor_sample(s);
+	while(imu_ring_pop(&priv->samples))
+		;
 
-	dp_dump_packet_tracker_sensor(s);
+	priv->last_tick = s->tick;
 
 	uint32_t tick_delta = 1000;
 	if(last_sample_tick > 0) //startup correction
 		tick_delta = s->tick - last_sample_tick;
 
 	float dt = tick_delta * TICK_LEN;
-	vec3f mag = {{0.0f, 0.0f, 0.0f}};
-
-	for(int i = 0; i < 1; i++){ //just use 1 sample since we don't have sample order for this frame
-		vec3f_from_dp_vec(s->samples[i].accel, &priv->raw_accel);
-		vec3f_from_dp_vec(s->samples[i].gyro, &priv->raw_gyro);
 
-		ofusion_update(&priv->sensor_fusion, dt, &priv->raw_gyro, &priv->raw_accel, &mag);
-
-		// reset dt to tick_len for the last samples if there were more than one sample
-		dt = TICK_LEN;
-	}
+	ofusion_update(&priv->sensor_fusion, dt, &s->gyro, &s->accel, &s->mag);
 }
 
 static void update_device(ohmd_device* device)
@@ -134,7 +132,7 @@ static void update_device(ohmd_device* device)
 
 	// Read all the messages from the device.
 	while(true){
-		int size = hid_read(priv->handle, buffer, FEATURE_BUFFER_SIZE);
+		int size = ohmd_hid_reader_read(&priv->reader, buffer, FEATURE_BUFFER_SIZE);
 		if(size < 0){
 			LOGE("error reading from device");
 			return;
@@ -181,10 +179,24 @@ static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 	return 0;
 }
 
+static int seti(ohmd_device* device, ohmd_int_value type, const int* in)
+{
+	rift_priv* priv = rift_priv_get(device);
+
+	switch(type){
+	case OHMD_FUSION_ALGORITHM:
+		return ofusion_set_algorithm(&priv->sensor_fusion, in[0]) == 0 ? OHMD_S_OK : OHMD_S_INVALID_PARAMETER;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
 static void close_device(ohmd_device* device)
 {
 	LOGD("closing device");
 	rift_priv* priv = rift_priv_get(device);
+	ohmd_hid_reader_close(&priv->reader);
 	hid_close(priv->handle);
 	free(priv);
 }
@@ -271,10 +283,14 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	priv->base.update = update_device;
 	priv->base.close = close_device;
 	priv->base.getf = getf;
+	priv->base.seti = seti;
 
 	// initialize sensor fusion
 	ofusion_init(&priv->sensor_fusion);
 
+	// read the sensor reports from the hidraw node when there is one
+	ohmd_hid_reader_init(&priv->reader, &priv->base, priv->handle, desc->path);
+
 	return &priv->base;
 
 cleanup:
@@ -54,17 +54,17 @@ typedef struct {
 	uint16_t mag_scale;
 } pkt_sensor_range;
 
-typedef struct {
-	int32_t accel[3];
-	int32_t gyro[3];
-} pkt_tracker_sample;
+// an accelerometer and a gyro vector for each of the 2 samples
+#define DP_SAMPLE_VECTORS 4
 
 typedef struct {
 	uint8_t report_id;
 	uint8_t sample_delta;
 	uint16_t sample_number;
 	uint32_t tick;
-	pkt_tracker_sample samples[2];
+	// sample vectors in m/s^2 and rad/s as a structure of arrays, vector
+	// 2 * i is the accelerometer and 2 * i + 1 the gyro of sample i
+	float smp_x[DP_SAMPLE_VECTORS], smp_y[DP_SAMPLE_VECTORS], smp_z[DP_SAMPLE_VECTORS];
 	int16_t mag[3];
 } pkt_tracker_sensor;
 
@@ -97,8 +97,10 @@ bool dp_decode_sensor_range(pkt_sensor_range* range, const unsigned char* buffer
 bool dp_decode_sensor_display_info(pkt_sensor_display_info* info, const unsigned char* buffer, int size);
 bool dp_decode_sensor_config(pkt_sensor_config* config, const unsigned char* buffer, int size);
 bool dp_decode_tracker_sensor_msg(pkt_tracker_sensor* msg, const unsigned char* buffer, int size);
+// the samples of a tracker sensor report, straight into the ring without the packet struct
+bool dp_decode_tracker_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size);
 
-void vec3f_from_dp_vec(const int32_t* smp, vec3f* out_vec);
+void vec3f_from_dp_sample(const pkt_tracker_sensor* msg, int idx, vec3f* out_vec);
 
 int dp_encode_sensor_config(unsigned char* buffer, const pkt_sensor_config* config);
 int dp_encode_keep_alive(unsigned char* buffer, const pkt_keep_alive* keep_alive);
@@ -106,6 +108,6 @@ int dp_encode_keep_alive(unsigned char* buffer, const pkt_keep_alive* keep_alive
 void dp_dump_packet_sensor_range(const pkt_sensor_range* range);
 void dp_dump_packet_sensor_config(const pkt_sensor_config* config);
 void dp_dump_packet_sensor_display_info(const pkt_sensor_display_info* info);
-void dp_dump_packet_tracker_sensor(const pkt_tracker_sensor* sensor);
+void dp_dump_tracker_sensor_sample(const imu_sample* sample);
 
 #endif
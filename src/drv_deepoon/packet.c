@@ -8,127 +8,116 @@
 /* Deepoon Driver - Packet Decoding and Utilities */
 
 #include <stdio.h>
+#include <string.h>
 #include "deepoon.h"
-
-#define SKIP_CMD (buffer++)
-#define READ8 *(buffer++);
-#define READ16 *buffer | (*(buffer + 1) << 8); buffer += 2;
-#define READ32 *buffer | (*(buffer + 1) << 8) | (*(buffer + 2) << 16) | (*(buffer + 3) << 24); buffer += 4;
-#define READFLOAT ((float)(*buffer)); buffer += 4;
-#define READFIXED (float)(*buffer | (*(buffer + 1) << 8) | (*(buffer + 2) << 16) | (*(buffer + 3) << 24)) / 1000000.0f; buffer += 4;
+#include "../packet_layout.h"
+#include "../packet_vec21.h"
 
 #define WRITE8(_val) *(buffer++) = (_val);
 #define WRITE16(_val) WRITE8((_val) & 0xff); WRITE8(((_val) >> 8) & 0xff);
 #define WRITE32(_val) WRITE16((_val) & 0xffff) *buffer; WRITE16(((_val) >> 16) & 0xffff);
 
-bool dp_decodesensor_range(pkt_sensor_range* range, const unsigned char* buffer, int size)
+#define DP_SENSOR_RANGE_LAYOUT(F) \
+	F(command_id, 1, u16) \
+	F(accel_scale, 3, u8) \
+	F(gyro_scale, 4, u16) \
+	F(mag_scale, 6, u16)
+
+#define DP_SENSOR_DISPLAY_INFO_LAYOUT(F) \
+	F(command_id, 1, u16) \
+	F(distortion_type, 3, u8) \
+	F(h_resolution, 4, u16) \
+	F(v_resolution, 6, u16) \
+	F(h_screen_size, 8, fixed) \
+	F(v_screen_size, 12, fixed) \
+	F(v_center, 16, fixed) \
+	F(lens_separation, 20, fixed) \
+	F(eye_to_screen_distance[0], 24, fixed) \
+	F(eye_to_screen_distance[1], 28, fixed) \
+	F(distortion_k[0], 32, float) \
+	F(distortion_k[1], 36, float) \
+	F(distortion_k[2], 40, float) \
+	F(distortion_k[3], 44, float) \
+	F(distortion_k[4], 48, float) \
+	F(distortion_k[5], 52, float)
+
+#define DP_SENSOR_CONFIG_LAYOUT(F) \
+	F(command_id, 1, u16) \
+	F(flags, 3, u8) \
+	F(packet_interval, 4, u8) \
+	F(keep_alive_interval, 5, u16)
+
+#define DP_TRACKER_SENSOR_LAYOUT(F) \
+	F(report_id, 0, u8) \
+	F(sample_delta, 3, u8) \
+	F(sample_number, 4, u16) \
+	F(tick, 8, u32)
+
+PL_DECODER(dp_decode_sensor_range, pkt_sensor_range, DP_SENSOR_RANGE_LAYOUT, 8, 9)
+PL_DECODER(dp_decode_sensor_config, pkt_sensor_config, DP_SENSOR_CONFIG_LAYOUT, 7, 8)
+
+// the display info size is not checked against the 56 or 57 bytes of the Rift
+static PL_DECODER(dp_decode_sensor_display_info_fields, pkt_sensor_display_info, DP_SENSOR_DISPLAY_INFO_LAYOUT, 56, FEATURE_BUFFER_SIZE)
+static PL_DECODER_SIZES(dp_decode_tracker_sensor_fields, pkt_tracker_sensor, DP_TRACKER_SENSOR_LAYOUT, 62, 64)
+
+bool dp_decode_sensor_display_info(pkt_sensor_display_info* info, const unsigned char* buffer, int size)
 {
-	if(!(size == 8 || size == 9)){
-		LOGE("invalid packet size (expected 8 or 9 but got %d)", size);
+	if(!dp_decode_sensor_display_info_fields(info, buffer, size))
 		return false;
-	}
-
-	SKIP_CMD;
-	range->command_id = READ16;
-	range->accel_scale = READ8;
-	range->gyro_scale = READ16;
-	range->mag_scale = READ16;
-
-	return true;
-}
-
-bool dp_decodesensor_display_info(pkt_sensor_display_info* info, const unsigned char* buffer, int size)
-{
-	if(!(size == 56 || size == 57)){
-		LOGE("invalid packet size (expected 56 or 57 but got %d)", size);
-		//return false;
-	}
-
-	SKIP_CMD;
-	info->command_id = READ16;
-	info->distortion_type = READ8;
-	info->h_resolution = READ16;
-	info->v_resolution = READ16;
-	info->h_screen_size = READFIXED;
-	info->v_screen_size = READFIXED;
-	info->v_center = READFIXED;
-	info->lens_separation = READFIXED;
-	info->eye_to_screen_distance[0] = READFIXED;
-	info->eye_to_screen_distance[1] = READFIXED;
 
 	info->distortion_type_opts = 0;
 
-	for(int i = 0; i < 6; i++){
-		info->distortion_k[i] = READFLOAT;
-	}
-
 	return true;
 }
 
-bool dp_decodesensor_config(pkt_sensor_config* config, const unsigned char* buffer, int size)
+// raw sample values to m/s^2 and rad/s
+#define SAMPLE_SCALE 0.0001f
+
+bool dp_decode_tracker_sensor_msg(pkt_tracker_sensor* msg, const unsigned char* buffer, int size)
 {
-	if(!(size == 7 || size == 8)){
-		LOGE("invalid packet size (expected 7 or 8 but got %d)", size);
+	if(!dp_decode_tracker_sensor_fields(msg, buffer, size))
 		return false;
-	}
 
-	SKIP_CMD;
-	config->command_id = READ16;
-	config->flags = READ8;
-	config->packet_interval = READ8;
-	config->keep_alive_interval = READ16;
+	pl_unpack_vec21(buffer + 12, DP_SAMPLE_VECTORS, SAMPLE_SCALE, msg->smp_x, msg->smp_y, msg->smp_z);
 
 	return true;
 }
 
-static void dp_decodesample(const unsigned char* buffer, int32_t* smp)
+bool dp_decode_tracker_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size)
 {
-	/*
-	 * Decode 3 tightly packed 21 bit values from 4 bytes.
-	 * We unpack them in the higher 21 bit values first and then shift
-	 * them down to the lower in order to get the sign bits correct.
-	 */
-
-	int x = (buffer[0] << 24)          | (buffer[1] << 16) | ((buffer[2] & 0xF8) << 8);
-	int y = ((buffer[2] & 0x07) << 29) | (buffer[3] << 21) | (buffer[4] << 13) | ((buffer[5] & 0xC0) << 5);
-	int z = ((buffer[5] & 0x3F) << 26) | (buffer[6] << 18) | (buffer[7] << 10);
-
-	smp[0] = x >> 11;
-	smp[1] = y >> 11;
-	smp[2] = z >> 11;
-}
+	pkt_tracker_sensor msg;
 
-bool dp_decode_tracker_sensor_msg(pkt_tracker_sensor* msg, const unsigned char* buffer, int size)
-{
-	if(!(size == 62 || size == 64)){
-		LOGE("invalid packet size (expected 62 or 64 but got %d)", size);
+	if(!dp_decode_tracker_sensor_fields(&msg, buffer, size))
 		return false;
-	}
 
-	msg->report_id = READ8;
-	buffer += 2;
-	msg->sample_delta = READ8;
-	msg->sample_number = READ16;
-	buffer += 2;
-	msg->tick = READ32;
+	// decoded straight into the ring entries, no magnetometer, and the same axis remap as vec3f_from_dp_sample
+	for(int i = 0; i < DP_SAMPLE_VECTORS / 2; i++){
+		imu_sample* s = imu_ring_push(ring);
+		float v[3];
 
-	for(int i = 0; i < 2; i++){
-		dp_decodesample(buffer, msg->samples[i].accel);
-		buffer += 8;
+		pl_read_vec21(buffer + 12 + i * 16, SAMPLE_SCALE, v);
+		s->accel.x = v[0];
+		s->accel.y = -v[2];
+		s->accel.z = v[1];
 
-		dp_decodesample(buffer, msg->samples[i].gyro);
-		buffer += 8;
+		pl_read_vec21(buffer + 12 + i * 16 + 8, SAMPLE_SCALE, v);
+		s->gyro.x = v[0];
+		s->gyro.y = -v[2];
+		s->gyro.z = v[1];
+
+		s->mag.x = s->mag.y = s->mag.z = 0.0f;
+		s->tick = msg.tick;
+		s->seq = i;
 	}
 
 	return true;
 }
 
-// TODO do we need to consider HMD vs sensor "centric" values
-void vec3f_from_dp_vec(const int32_t* smp, vec3f* out_vec)
+void vec3f_from_dp_sample(const pkt_tracker_sensor* msg, int idx, vec3f* out_vec)
 {
-	out_vec->x = (float)smp[0] * 0.0001f;
-	out_vec->y = ((float)smp[2] * 0.0001f) * -1;
-	out_vec->z = (float)smp[1] * 0.0001f;
+	out_vec->x = msg->smp_x[idx];
+	out_vec->y = -msg->smp_z[idx];
+	out_vec->z = msg->smp_y[idx];
 }
 
 int dp_encode_sensor_config(unsigned char* buffer, const pkt_sensor_config* config)
@@ -167,16 +156,11 @@ void dp_dump_packet_sensor_config(const pkt_sensor_config* config)
 	LOGD("  keep alive interval: %u", config->keep_alive_interval);
 }
 
-void dp_dump_packet_tracker_sensor(const pkt_tracker_sensor* sensor)
+void dp_dump_tracker_sensor_sample(const imu_sample* sample)
 {
-	(void)sensor;
-	LOGD("TEST: deepoon sensor data");
-	LOGD("  report id: 	%u", sensor->report_id);
-	LOGD("  sample delta: 	%u", sensor->sample_delta);
-	LOGD("  sample number: 	%d", sensor->sample_number);
-	LOGD("  tick: 		%u", sensor->tick);
-	for(int i = 0; i < 2; i++){
-		LOGD("    accel: %d %d %d", sensor->samples[i].accel[0], sensor->samples[i].accel[1], sensor->samples[i].accel[2]);
-		LOGD("    gyro:  %d %d %d", sensor->samples[i].gyro[0], sensor->samples[i].gyro[1], sensor->samples[i].gyro[2]);
-	}
+	(void)sample;
+	LOGD("deepoon sensor sample %u:", sample->seq);
+	LOGD("  tick: 	%u", sample->tick);
+	LOGD("  accel: 	%f %f %f", sample->accel.x, sample->accel.y, sample->accel.z);
+	LOGD("  gyro: 	%f %f %f", sample->gyro.x, sample->gyro.y, sample->gyro.z);
 }
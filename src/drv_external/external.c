@@ -9,15 +9,66 @@
 /* External Driver */
 
 #include "../openhmdi.h"
+#include "../fusion_batch.h"
 #include "string.h"
 
+typedef struct external_drv external_drv;
+
 typedef struct {
 	ohmd_device base;
 	fusion sensor_fusion;
+	external_drv* drv;
+	int batch_idx; // -1 once the device needs more than the batch offers and runs sensor_fusion
 } external_priv;
 
+/*
+ * Devices running the default complementary filter without a magnetometer are
+ * fused together, one batch update advances every device with a new sample.
+ */
+struct external_drv {
+	ohmd_driver base;
+	fusion_batch batch;
+	external_priv* batch_devices[FUSION_BATCH_MAX_SIZE];
+	bool pending;
+};
+
+static void update_batch(external_drv* drv)
+{
+	if(drv->pending){
+		ofusion_batch_update(&drv->batch);
+		drv->pending = false;
+	}
+}
+
+static void remove_from_batch(external_priv* priv)
+{
+	external_drv* drv = priv->drv;
+	int idx = priv->batch_idx;
+
+	if(idx < 0)
+		return;
+
+	// take over the orientation, and any sample still waiting, before leaving
+	update_batch(drv);
+	ofusion_batch_get_orient(&drv->batch, idx, &priv->sensor_fusion.orient);
+	priv->sensor_fusion.orient_d.x = priv->sensor_fusion.orient.x;
+	priv->sensor_fusion.orient_d.y = priv->sensor_fusion.orient.y;
+	priv->sensor_fusion.orient_d.z = priv->sensor_fusion.orient.z;
+	priv->sensor_fusion.orient_d.w = priv->sensor_fusion.orient.w;
+
+	ofusion_batch_remove(&drv->batch, idx);
+	priv->batch_idx = -1;
+
+	if(idx < drv->batch.size){
+		drv->batch_devices[idx] = drv->batch_devices[drv->batch.size];
+		drv->batch_devices[idx]->batch_idx = idx;
+	}
+}
+
 static void update_device(ohmd_device* device)
 {
+	external_priv* priv = (external_priv*)device;
+	update_batch(priv->drv);
 }
 
 static int getf(ohmd_device* device, ohmd_float_value type, float* out)
@@ -26,7 +77,12 @@ static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 
 	switch(type){
 		case OHMD_ROTATION_QUAT: {
-				*(quatf*)out = priv->sensor_fusion.orient;
+				if(priv->batch_idx >= 0){
+					update_batch(priv->drv);
+					ofusion_batch_get_orient(&priv->drv->batch, priv->batch_idx, (quatf*)out);
+				}else{
+					*(quatf*)out = priv->sensor_fusion.orient;
+				}
 				break;
 			}
 
@@ -34,6 +90,10 @@ static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 			out[0] = out[1] = out[2] = 0;
 			break;
 
+		case OHMD_MAG_CORRECTION_GAIN:
+			*out = ofusion_get_mag_gain(&priv->sensor_fusion);
+			break;
+
 		default:
 			ohmd_set_error(priv->base.ctx, "invalid type given to getf (%d)", type);
 			return -1;
@@ -49,10 +109,31 @@ static int setf(ohmd_device* device, ohmd_float_value type, const float* in)
 
 	switch(type){
 		case OHMD_EXTERNAL_SENSOR_FUSION: {
-				ofusion_update(&priv->sensor_fusion, *in, (vec3f*)(in + 1), (vec3f*)(in + 4), (vec3f*)(in + 7));
+				if(priv->batch_idx >= 0){
+					fusion_batch* batch = &priv->drv->batch;
+
+					// a second sample before the next pass, fuse the pending ones first
+					if(batch->dt[priv->batch_idx] > 0)
+						update_batch(priv->drv);
+
+					ofusion_batch_set_sample(batch, priv->batch_idx, *in, (vec3f*)(in + 1), (vec3f*)(in + 4));
+					priv->drv->pending = true;
+				}else{
+					ofusion_update(&priv->sensor_fusion, *in, (vec3f*)(in + 1), (vec3f*)(in + 4), (vec3f*)(in + 7));
+				}
 			}
 			break;
 
+		case OHMD_MAG_CORRECTION_GAIN:
+			if(ofusion_set_mag_gain(&priv->sensor_fusion, *in) != 0)
+				return OHMD_S_INVALID_PARAMETER;
+
+			// the batch has no magnetometer correction
+			if(*in > 0)
+				remove_from_batch(priv);
+
+			return OHMD_S_OK;
+
 		default:
 			ohmd_set_error(priv->base.ctx, "invalid type given to setf (%d)", type);
 			return -1;
@@ -62,9 +143,29 @@ static int setf(ohmd_device* device, ohmd_float_value type, const float* in)
 	return 0;
 }
 
+static int seti(ohmd_device* device, ohmd_int_value type, const int* in)
+{
+	external_priv* priv = (external_priv*)device;
+
+	switch(type){
+	case OHMD_FUSION_ALGORITHM:
+		if(ofusion_set_algorithm(&priv->sensor_fusion, in[0]) != 0)
+			return OHMD_S_INVALID_PARAMETER;
+
+		if(in[0] != OHMD_FUSION_COMPLEMENTARY)
+			remove_from_batch(priv);
+
+		return OHMD_S_OK;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
 static void close_device(ohmd_device* device)
 {
 	LOGD("closing external device");
+	remove_from_batch((external_priv*)device);
 	free(device);
 }
 
@@ -96,10 +197,22 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	priv->base.update = update_device;
 	priv->base.close = close_device;
 	priv->base.getf = getf;
+	priv->base.seti = seti;
 	priv->base.setf = setf;
 	
 	ofusion_init(&priv->sensor_fusion);
 
+	external_drv* drv = (external_drv*)driver;
+	priv->drv = drv;
+	priv->batch_idx = -1;
+
+	// the batch is single precision only
+	if(!(priv->sensor_fusion.flags & FF_DOUBLE_PRECISION)){
+		priv->batch_idx = ofusion_batch_add(&drv->batch);
+		if(priv->batch_idx >= 0)
+			drv->batch_devices[priv->batch_idx] = priv;
+	}
+
 	return (ohmd_device*)priv;
 }
 
@@ -124,16 +237,18 @@ static void destroy_driver(ohmd_driver* drv)
 
 ohmd_driver* ohmd_create_external_drv(ohmd_context* ctx)
 {
-	ohmd_driver* drv = ohmd_alloc(ctx, sizeof(ohmd_driver));
+	external_drv* drv = ohmd_alloc(ctx, sizeof(external_drv));
 	if(!drv)
 		return NULL;
 
-	drv->get_device_list = get_device_list;
-	drv->open_device = open_device;
-	drv->destroy = destroy_driver;
-	drv->ctx = ctx;
+	drv->base.get_device_list = get_device_list;
+	drv->base.open_device = open_device;
+	drv->base.destroy = destroy_driver;
+	drv->base.ctx = ctx;
+
+	ofusion_batch_init(&drv->batch);
 
-	return drv;
+	return (ohmd_driver*)drv;
 }
 
 /* external specific functions */
@@ -0,0 +1,122 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* HTC Vive Driver - Lighthouse Sweeps */
+
+#include "vive.h"
+
+#include "../packet_layout.h"
+
+/*
+ * A lighthouse report holds up to nine photodiode pulses, each the sensor
+ * index, the pulse length and its start time in 48 MHz ticks. Unused slots
+ * have a sensor index of 0xfe or 0xff.
+ *
+ * Every 1/120 s the base stations flash their sync LEDs, one after the
+ * other, and every photodiode in view sees a long pulse. Its length encodes
+ * three bits in steps of 500 ticks from 3000: the axis that is swept next,
+ * a data bit, and a skip bit that is clear for the one station that sweeps
+ * in this cycle. The sweep follows, its rotor turns at 60 Hz so half a turn,
+ * -90 to 90 degrees, takes 400000 ticks, and every photodiode it crosses
+ * sees a short pulse. The angle is the time from the start of the sync flash
+ * to the middle of that pulse.
+ */
+#define VIVE_LIGHTHOUSE_SIZE 64
+#define VIVE_LIGHTHOUSE_PULSE_SIZE 7
+
+#define VIVE_LH_SYNC_MIN_LENGTH 2750
+#define VIVE_LH_SYNC_STEP 500
+#define VIVE_LH_SYNC_WINDOW 2000   // the photodiodes see one flash within this
+#define VIVE_LH_STATION_GAP 48000  // the second station flashes within this of the first
+#define VIVE_LH_SWEEP_TICKS 400000
+
+#define VIVE_LH_SKIP 4
+#define VIVE_LH_AXIS 1
+
+static void handle_sync(vive_lighthouse_decoder* d, uint32_t time, uint16_t length)
+{
+	uint32_t since = time - d->sync_time;
+
+	if(d->have_sync && since < VIVE_LH_SYNC_WINDOW){
+		// another photodiode seeing the same flash, the longest pulse is the least clipped
+		if(length <= d->sync_length)
+			return;
+
+		d->sync_length = length;
+	}else{
+		d->sync_station = d->have_sync && since < VIVE_LH_STATION_GAP;
+		d->sync_time = time;
+		d->sync_length = length;
+		d->have_sync = true;
+
+		// the first flash of a cycle ends the last cycle's sweep
+		if(d->sync_station == 0)
+			d->sweeping = false;
+	}
+
+	int code = OHMD_MIN((d->sync_length - VIVE_LH_SYNC_MIN_LENGTH) / VIVE_LH_SYNC_STEP, 7);
+
+	if(!(code & VIVE_LH_SKIP)){
+		d->sweeping = true;
+		d->sweep_start = d->sync_time;
+		d->sweep_station = d->sync_station;
+		d->sweep_axis = code & VIVE_LH_AXIS;
+	}else if(d->sweeping && d->sweep_start == d->sync_time){
+		// a longer pulse of the same flash turned the skip bit on
+		d->sweeping = false;
+	}
+}
+
+static bool handle_sweep(vive_lighthouse_decoder* d, uint8_t sensor, uint32_t time, uint16_t length, ohmd_sweep_sample* out)
+{
+	if(!d->sweeping)
+		return false;
+
+	uint32_t ticks = time + length / 2 - d->sweep_start;
+
+	if(ticks >= VIVE_LH_SWEEP_TICKS){
+		d->sweeping = false;
+		return false;
+	}
+
+	out->timestamp = time + length / 2;
+	out->angle = ((int32_t)ticks - VIVE_LH_SWEEP_TICKS / 2) * (float)(M_PI / VIVE_LH_SWEEP_TICKS);
+	out->length = length;
+	out->sensor = sensor;
+	out->station = d->sweep_station;
+	out->axis = d->sweep_axis;
+
+	return true;
+}
+
+int vive_decode_lighthouse_report(vive_lighthouse_decoder* d, const unsigned char* buffer, int size, ohmd_sweep_sample* out)
+{
+	if(size != VIVE_LIGHTHOUSE_SIZE){
+		LOGE("invalid vive lighthouse report size (expected %d but got %d)", VIVE_LIGHTHOUSE_SIZE, size);
+		return -1;
+	}
+
+	int count = 0;
+
+	for(int i = 0; i < VIVE_LIGHTHOUSE_PULSES; i++){
+		const unsigned char* p = buffer + 1 + VIVE_LIGHTHOUSE_PULSE_SIZE * i;
+		uint8_t sensor = p[0];
+
+		if(sensor >= 0xfe)
+			continue;
+
+		uint16_t length = pl_read_u16(p + 1);
+		uint32_t time = pl_read_u32(p + 3);
+
+		if(length >= VIVE_LH_SYNC_MIN_LENGTH)
+			handle_sync(d, time, length);
+		else if(handle_sweep(d, sensor, time, length, out + count))
+			count++;
+	}
+
+	return count;
+}
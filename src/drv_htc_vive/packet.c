@@ -1,56 +1,294 @@
 #include "vive.h"
 #include "vive_config.h"
 
-#ifdef _MSC_VER
-#define inline __inline
-#endif
+#include "../packet_layout.h"
 
-inline static uint8_t read8(const unsigned char** buffer)
+// a sensor report is the report id followed by three samples
+#define VIVE_SENSOR_SIZE 52
+#define VIVE_SMP_OFFSET(_i) (1 + 17 * (_i))
+#define VIVE_SMP_ACC 0
+#define VIVE_SMP_ROT 6
+#define VIVE_SMP_TIME 12
+#define VIVE_SMP_SEQ 16
+
+#define VIVE_SAMPLE_LAYOUT(F, _i) \
+	PL_VEC3(F, samples[_i].acc, VIVE_SMP_OFFSET(_i) + VIVE_SMP_ACC, s16) \
+	PL_VEC3(F, samples[_i].rot, VIVE_SMP_OFFSET(_i) + VIVE_SMP_ROT, s16) \
+	F(samples[_i].time_ticks, VIVE_SMP_OFFSET(_i) + VIVE_SMP_TIME, u32) \
+	F(samples[_i].seq, VIVE_SMP_OFFSET(_i) + VIVE_SMP_SEQ, u8)
+
+#define VIVE_SENSOR_LAYOUT(F) \
+	F(report_id, 0, u8) \
+	VIVE_SAMPLE_LAYOUT(F, 0) \
+	VIVE_SAMPLE_LAYOUT(F, 1) \
+	VIVE_SAMPLE_LAYOUT(F, 2)
+
+PL_DECODER(vive_decode_sensor_packet, vive_sensor_packet, VIVE_SENSOR_LAYOUT, VIVE_SENSOR_SIZE, VIVE_SENSOR_SIZE)
+
+static inline void read_vec3(const unsigned char* p, int16_t* out)
+{
+	out[0] = pl_read_s16(p);
+	out[1] = pl_read_s16(p + 2);
+	out[2] = pl_read_s16(p + 4);
+}
+
+void vec3f_from_vive_vec_accel(const int16_t* smp, vec3f* out_vec)
+{
+	float gravity = 9.81f;
+	float scaler = 4.0f * gravity / 32768.0f;
+
+	out_vec->x = (float)smp[0] * scaler;
+	out_vec->y = (float)smp[1] * scaler * -1;
+	out_vec->z = (float)smp[2] * scaler * -1;
+}
+
+void vec3f_from_vive_vec_gyro(const int16_t* smp, vec3f* out_vec)
 {
-	uint8_t ret = **buffer;
-	*buffer += 1;
-	return ret;
+	float scaler = 8.7f / 32768.0f;
+	out_vec->x = (float)smp[0] * scaler;
+	out_vec->y = (float)smp[1] * scaler * -1;
+	out_vec->z = (float)smp[2] * scaler * -1;
 }
 
-inline static int16_t read16(const unsigned char** buffer)
+bool vive_decode_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size)
 {
-	int16_t ret = **buffer | (*(*buffer + 1) << 8);
-	*buffer += 2;
-	return ret;
+	if(size != VIVE_SENSOR_SIZE){
+		LOGE("invalid vive sensor report size (expected %d but got %d)", VIVE_SENSOR_SIZE, size);
+		return false;
+	}
+
+	for(int i = 0; i < VIVE_SAMPLES; i++){
+		const unsigned char* p = buffer + VIVE_SMP_OFFSET(i);
+		imu_sample* s = imu_ring_push(ring);
+		int16_t acc[3], rot[3];
+
+		read_vec3(p + VIVE_SMP_ACC, acc);
+		read_vec3(p + VIVE_SMP_ROT, rot);
+
+		vec3f_from_vive_vec_accel(acc, &s->accel);
+		vec3f_from_vive_vec_gyro(rot, &s->gyro);
+		s->mag.x = s->mag.y = s->mag.z = 0;
+		s->tick = pl_read_u32(p + VIVE_SMP_TIME);
+		s->seq = p[VIVE_SMP_SEQ];
+	}
+
+	return true;
 }
 
-inline static uint32_t read32(const unsigned char** buffer)
+// sorts the samples by their sequence number distance from ref, oldest first
+static void sort_samples(imu_sample** smp, uint8_t ref)
 {
-	uint32_t ret = **buffer | (*(*buffer + 1) << 8) | (*(*buffer + 2) << 16) | (*(*buffer + 3) << 24);
-	*buffer += 4;
-	return ret;
+	for(int i = 1; i < VIVE_SAMPLES; i++){
+		for(int j = i; j > 0 && (uint8_t)(smp[j]->seq - ref) < (uint8_t)(smp[j - 1]->seq - ref); j--){
+			imu_sample* tmp = smp[j];
+			smp[j] = smp[j - 1];
+			smp[j - 1] = tmp;
+		}
+	}
+}
+
+static void add_step(vive_fusion_step* out, int* count, float dt, const vec3f* gyro, const imu_sample* s)
+{
+	out[*count].dt = dt;
+	out[*count].gyro = *gyro;
+	out[*count].sample = s;
+	(*count)++;
+}
+
+/*
+ * The IMU repeats each sample in up to three consecutive packets. The samples
+ * of a packet are sorted once by sequence number, relative to the last sample
+ * used, so the new ones come first and in order. Samples that were already
+ * used are counted as duplicates. Gaps in the sequence are counted as dropped
+ * samples, and the rotation over a gap is integrated with the angular
+ * velocity interpolated between the samples on either side of it.
+ *
+ * Sequence numbers wrap at 256. On the first packet, and after a gap too
+ * long to tell from the sequence numbers alone, the samples are ordered among
+ * themselves and the gap is measured in ticks instead.
+ *
+ * Fills out with the time spans to integrate, in order, and returns how many.
+ */
+int vive_order_samples(vive_sample_order* order, imu_sample** smp, vive_fusion_step* out)
+{
+	int count = 0;
+
+	uint8_t report_seq = smp[0]->seq;
+
+	sort_samples(smp, order->last_seq);
+
+	uint8_t first_diff = smp[0]->seq - order->last_seq;
+	int32_t first_ticks = smp[0]->tick - order->last_ticks;
+
+	bool stale = first_diff == 0 || first_diff >= 128;
+
+	if(!order->have_sample || (stale && (first_ticks >= 128 * VIVE_SAMPLE_TICKS || first_ticks <= -128 * VIVE_SAMPLE_TICKS))){
+		// order the samples among themselves and start just before the oldest one
+		sort_samples(smp, report_seq - 128);
+
+		uint32_t start_ticks = smp[0]->tick - VIVE_SAMPLE_TICKS;
+		int32_t gap_ticks = start_ticks - order->last_ticks;
+
+		if(order->have_sample && gap_ticks > 0){
+			vec3f mean;
+			for(int j = 0; j < 3; j++)
+				mean.arr[j] = 0.5f * (order->last_gyro.arr[j] + smp[0]->gyro.arr[j]);
+
+			add_step(out, &count, gap_ticks / VIVE_TIME_DIV, &mean, smp[0]);
+			order->dropped_samples += (gap_ticks + VIVE_SAMPLE_TICKS / 2) / VIVE_SAMPLE_TICKS;
+		}
+
+		order->last_seq = smp[0]->seq - 1;
+		order->last_ticks = start_ticks;
+		order->have_sample = true;
+	}
+
+	for(int i = 0; i < VIVE_SAMPLES; i++){
+		uint8_t diff = smp[i]->seq - order->last_seq;
+
+		if(diff == 0 || diff >= 128){
+			order->duplicate_samples++;
+			continue;
+		}
+
+		uint32_t ticks = smp[i]->tick - order->last_ticks;
+		float dt = ticks / VIVE_TIME_DIV;
+
+		// sequence numbers alias after 256 samples, longer gaps are measured in ticks
+		int steps = ticks >= 128 * VIVE_SAMPLE_TICKS ? (int)((ticks + VIVE_SAMPLE_TICKS / 2) / VIVE_SAMPLE_TICKS) : diff;
+
+		if(steps > 1){
+			vec3f mean;
+			for(int j = 0; j < 3; j++)
+				mean.arr[j] = 0.5f * (order->last_gyro.arr[j] + smp[i]->gyro.arr[j]);
+
+			add_step(out, &count, dt * (steps - 1) / steps, &mean, smp[i]);
+			dt /= steps;
+
+			order->dropped_samples += steps - 1;
+		}
+
+		add_step(out, &count, dt, &smp[i]->gyro, smp[i]);
+
+		order->last_gyro = smp[i]->gyro;
+		order->last_ticks = smp[i]->tick;
+		order->last_seq = smp[i]->seq;
+	}
+
+	return count;
 }
 
-bool vive_decode_sensor_packet(vive_sensor_packet* pkt, const unsigned char* buffer, int size)
+/*
+ * A controller report carries one message from the controller, relayed by
+ * the Watchman dongle: the high bytes of the time code, the message length
+ * counted from the second time code byte, and a type byte that says which
+ * parts follow. A type of 0xf0 and up is a set of input bits (buttons,
+ * trigger, trackpad) and may announce an IMU sample, 0xe1 is the battery
+ * state, followed by another type byte, and types with the 0xe8 bits set
+ * are an IMU sample. Light sensor data at the end is not decoded.
+ */
+#define VIVE_CONTROLLER_HEADER_SIZE 5
+#define VIVE_CONTROLLER_IMU_SIZE 13
+
+bool vive_decode_controller_packet(vive_controller_packet* pkt, const unsigned char* buffer, int size)
 {
-	if(size != 52){
-		LOGE("invalid vive sensor packet size (expected 52 but got %d)", size);
+	if(size < VIVE_CONTROLLER_HEADER_SIZE){
+		LOGE("invalid vive controller report size (expected at least %d but got %d)", VIVE_CONTROLLER_HEADER_SIZE, size);
+		return false;
+	}
+
+	vive_controller_message* msg = &pkt->message;
+	uint8_t time1 = buffer[1], time2 = buffer[3], type = buffer[4];
+	const unsigned char* p = buffer + VIVE_CONTROLLER_HEADER_SIZE;
+	const unsigned char* end = buffer + 3 + buffer[2];
+
+	if(end < p || end > buffer + size){
+		LOGE("invalid vive controller message length %d in a report of %d bytes", buffer[2], size);
 		return false;
 	}
 
-	pkt->report_id = read8(&buffer);
+	memset(msg, 0, sizeof(*msg));
+	pkt->report_id = buffer[0];
+
+	if((type & 0xf0) == 0xf0){
+		int need = !!(type & 0x01) + !!(type & 0x04) + ((type & 0x02) ? 4 : 0);
+		if(end - p < need)
+			goto short_message;
+
+		if(type & 0x01){
+			msg->buttons = *p++;
+			msg->flags |= VIVE_CONTROLLER_HAS_BUTTONS;
+		}
 
-	for(int j = 0; j < 3; j++){
-		// acceleration
-		for(int i = 0; i < 3; i++){
-			pkt->samples[j].acc[i] = read16(&buffer);
+		if(type & 0x04){
+			msg->trigger = *p++;
+			msg->flags |= VIVE_CONTROLLER_HAS_TRIGGER;
 		}
 
-		// rotation
-		for(int i = 0; i < 3; i++){
-			pkt->samples[j].rot[i] = read16(&buffer);
+		if(type & 0x02){
+			msg->trackpad[0] = pl_read_s16(p);
+			msg->trackpad[1] = pl_read_s16(p + 2);
+			msg->flags |= VIVE_CONTROLLER_HAS_TRACKPAD;
+			p += 4;
 		}
 
-		pkt->samples[j].time_ticks = read32(&buffer);
-		pkt->samples[j].seq = read8(&buffer);
+		if(type & 0x08)
+			type = 0xe8;
+		else
+			type = p < end ? *p++ : 0;
+	}
+
+	if(type == 0xe1){
+		if(end - p < 1)
+			goto short_message;
+
+		msg->battery = *p & 0x7f;
+		msg->charging = *p >> 7;
+		msg->flags |= VIVE_CONTROLLER_HAS_BATTERY;
+		p++;
+
+		type = p < end ? *p++ : 0;
+	}
+
+	if((type & 0xe8) == 0xe8){
+		if(end - p < VIVE_CONTROLLER_IMU_SIZE)
+			goto short_message;
+
+		// the low byte of the time code isn't sent
+		msg->time_ticks = ((uint32_t)time1 << 24) | (time2 << 16) | (p[0] << 8);
+		read_vec3(p + 1, msg->acc);
+		read_vec3(p + 7, msg->rot);
+		msg->flags |= VIVE_CONTROLLER_HAS_IMU;
 	}
 
 	return true;
+
+short_message:
+	LOGE("vive controller message too short for its type");
+	return false;
+}
+
+// the button changes a message makes to the state in buttons, returns the number of events
+int vive_controller_button_events(uint8_t* buttons, const vive_controller_message* msg, ohmd_digital_input_event* out)
+{
+	int count = 0;
+
+	if(!(msg->flags & VIVE_CONTROLLER_HAS_BUTTONS))
+		return 0;
+
+	uint8_t changed = *buttons ^ msg->buttons;
+
+	for(int i = 0; i < VIVE_CONTROLLER_BUTTON_COUNT; i++){
+		if(changed & (1 << i)){
+			out[count].idx = i;
+			out[count].state = (msg->buttons & (1 << i)) ? OHMD_BUTTON_DOWN : OHMD_BUTTON_UP;
+			count++;
+		}
+	}
+
+	*buttons = msg->buttons;
+
+	return count;
 }
 
 //Trim function for removing tabs and spaces from string buffers
@@ -81,21 +319,24 @@ bool vive_decode_config_packet(vive_config_packet* pkt, const unsigned char* buf
 	pkt->length = size;
 
 	unsigned char output[32768];
-	int output_size = 32768;
+	// leaves room for the terminator, the json parser needs one
+	mz_ulong output_size = sizeof(output) - 1;
 
 	//int cmp_status = uncompress(pUncomp, &uncomp_len, pCmp, cmp_len);
-	int cmp_status = uncompress(output, (mz_ulong*)&output_size, buffer, (mz_ulong)pkt->length);
+	int cmp_status = uncompress(output, &output_size, buffer, (mz_ulong)pkt->length);
 	if (cmp_status != Z_OK){
 		LOGE("invalid vive config, could not uncompress");
 		return false;
 	}
 
+	output[output_size] = '\0';
+
 	LOGE("Decompressed from %u to %u bytes\n", (mz_uint32)pkt->length, (mz_uint32)output_size);
 
 	//printf("Debug print all the RAW JSON things!\n%s", output);
 	//pUncomp should now be the uncompressed data, lets get the json from it
 	/** DEBUG JSON PARSER CODE **/
-	trim((char*)output,(char*)output,output_size);
+	trim((char*)output,(char*)output,output_size + 1);
 	//printf("%s\n",output);
 	/*
 	FILE* dfp;
@@ -16,7 +16,11 @@
 #define VIVE_WATCHMAN_DONGLE     0x2101
 #define VIVE_LIGHTHOUSE_FPGA_RX  0x2000
 
-#define VIVE_TIME_DIV 48000000.0f
+// sweeps kept for ohmd_device_read_stream, a power of two, a few frames' worth at tens of kHz
+#define VIVE_SWEEP_RING_SIZE 2048
+
+// time code gaps longer than this restart the controller fusion instead of integrating across them
+#define VIVE_CONTROLLER_MAX_DT 0.1f
 
 #include <string.h>
 #include <wchar.h>
@@ -27,127 +31,165 @@
 #include <stdbool.h>
 
 #include "vive.h"
+#include "../hid_reader.h"
 
 typedef struct {
 	ohmd_device base;
 
 	hid_device* hmd_handle;
 	hid_device* imu_handle;
+	hid_device* lighthouse_handle;
+	ohmd_hid_reader imu_reader, lighthouse_reader;
 	fusion sensor_fusion;
-	vec3f raw_accel, raw_gyro;
-	uint32_t last_ticks;
-	uint8_t last_seq;
+	imu_ring samples;
+	vive_sample_order sample_order;
+
+	vive_lighthouse_decoder lighthouse;
+	ohmd_sweep_sample sweeps[VIVE_SWEEP_RING_SIZE];
+	unsigned sweep_write, sweep_read; // free running, the oldest unread sweeps are overwritten
 
 	vive_config_packet vive_config;
-	vec3f gyro_error;
-	filter_queue gyro_q;
 } vive_priv;
 
-void vec3f_from_vive_vec_accel(const int16_t* smp, vec3f* out_vec)
-{
-	float gravity = 9.81f;
-	float scaler = 4.0f * gravity / 32768.0f;
+typedef struct {
+	ohmd_device base;
 
-	out_vec->x = (float)smp[0] * scaler;
-	out_vec->y = (float)smp[1] * scaler * -1;
-	out_vec->z = (float)smp[2] * scaler * -1;
-}
+	hid_device* handle;
+	ohmd_hid_reader reader;
+	fusion sensor_fusion;
+	uint32_t last_ticks;
+	bool have_sample;
+	uint8_t buttons;
+} vive_controller_priv;
 
-void vec3f_from_vive_vec_gyro(const int16_t* smp, vec3f* out_vec)
+typedef enum {
+	VIVE_DEVICE_HMD,
+	VIVE_DEVICE_CONTROLLER
+} vive_device_type;
+
+static void handle_sensor_samples(vive_priv* priv)
 {
-	float scaler = 8.7f / 32768.0f;
-	out_vec->x = (float)smp[0] * scaler;
-	out_vec->y = (float)smp[1] * scaler * -1;
-	out_vec->z = (float)smp[2] * scaler * -1;
+	imu_sample* smp[VIVE_SAMPLES];
+	vive_fusion_step steps[VIVE_MAX_FUSION_STEPS];
+
+	for(int i = 0; i < VIVE_SAMPLES; i++)
+		smp[i] = imu_ring_pop(&priv->samples);
+
+	int count = vive_order_samples(&priv->sample_order, smp, steps);
+
+	for(int i = 0; i < count; i++)
+		ofusion_update(&priv->sensor_fusion, steps[i].dt, &steps[i].gyro, &steps[i].sample->accel, &steps[i].sample->mag);
 }
 
-static bool process_error(vive_priv* priv)
+static void handle_lighthouse_report(vive_priv* priv, const unsigned char* buffer, int size)
 {
-	if(priv->gyro_q.at >= priv->gyro_q.size - 1)
-		return true;
+	ohmd_sweep_sample sweeps[VIVE_LIGHTHOUSE_PULSES];
+	int count = vive_decode_lighthouse_report(&priv->lighthouse, buffer, size, sweeps);
 
-	ofq_add(&priv->gyro_q, &priv->raw_gyro);
+	for(int i = 0; i < count; i++){
+		if(priv->sweep_write - priv->sweep_read == VIVE_SWEEP_RING_SIZE)
+			priv->sweep_read++;
 
-	if(priv->gyro_q.at >= priv->gyro_q.size - 1){
-		ofq_get_mean(&priv->gyro_q, &priv->gyro_error);
-		printf("gyro error: %f, %f, %f\n", priv->gyro_error.x, priv->gyro_error.y, priv->gyro_error.z);
+		priv->sweeps[priv->sweep_write++ & (VIVE_SWEEP_RING_SIZE - 1)] = sweeps[i];
 	}
-
-	return false;
 }
 
-vive_sensor_sample* get_next_sample(vive_sensor_packet* pkt, int last_seq)
+static void handle_report(vive_priv* priv, const unsigned char* buffer, int size)
 {
-	int diff[3];
+	switch(buffer[0]){
+	case VIVE_IRQ_SENSORS:
+		if(vive_decode_sensor_samples(&priv->samples, buffer, size))
+			handle_sensor_samples(priv);
+		break;
 
-	for(int i = 0; i < 3; i++)
-	{
-		diff[i] = (int)pkt->samples[i].seq - last_seq;
+	case VIVE_LIGHTHOUSE_REPORT:
+		handle_lighthouse_report(priv, buffer, size);
+		break;
 
-		if(diff[i] < -128){
-			diff[i] += 256;
-		}
+	default:
+		LOGE("unknown message type: %u", buffer[0]);
 	}
+}
 
-	int closest_diff = INT_MAX;
-	int closest_idx = -1;
+static void update_device(ohmd_device* device)
+{
+	vive_priv* priv = (vive_priv*)device;
 
-	for(int i = 0; i < 3; i++)
-	{
-		if(diff[i] < closest_diff && diff[i] > 0 && diff[i] < 128){
-			closest_diff = diff[i];
-			closest_idx = i;
-		}
+	int size = 0;
+	unsigned char buffer[FEATURE_BUFFER_SIZE];
+
+	while((size = ohmd_hid_reader_read(&priv->imu_reader, buffer, FEATURE_BUFFER_SIZE)) > 0)
+		handle_report(priv, buffer, size);
+
+	if(size < 0){
+		LOGE("error reading from device");
 	}
 
-	if(closest_idx != -1)
-		return pkt->samples + closest_idx;
+	if(!priv->lighthouse_handle)
+		return;
 
-	return NULL;
+	while((size = ohmd_hid_reader_read(&priv->lighthouse_reader, buffer, FEATURE_BUFFER_SIZE)) > 0)
+		handle_report(priv, buffer, size);
+
+	if(size < 0){
+		LOGE("error reading from device");
+	}
 }
 
-static void update_device(ohmd_device* device)
+static int read_stream(ohmd_device* device, ohmd_stream_type type, void* out, int max)
 {
 	vive_priv* priv = (vive_priv*)device;
+	ohmd_sweep_sample* sweeps = (ohmd_sweep_sample*)out;
+	int count = 0;
 
-	int size = 0;
-	unsigned char buffer[FEATURE_BUFFER_SIZE];
+	if(type != OHMD_STREAM_LIGHTHOUSE_SWEEPS)
+		return OHMD_S_UNSUPPORTED;
+
+	while(count < max && priv->sweep_read != priv->sweep_write)
+		sweeps[count++] = priv->sweeps[priv->sweep_read++ & (VIVE_SWEEP_RING_SIZE - 1)];
 
-	while((size = hid_read(priv->imu_handle, buffer, FEATURE_BUFFER_SIZE)) > 0){
-		if(buffer[0] == VIVE_IRQ_SENSORS){
-			vive_sensor_packet pkt;
-			vive_decode_sensor_packet(&pkt, buffer, size);
+	return count;
+}
+
+static void handle_controller_message(vive_controller_priv* priv, const vive_controller_message* msg)
+{
+	ohmd_digital_input_event events[VIVE_CONTROLLER_BUTTON_COUNT];
+	int count = vive_controller_button_events(&priv->buttons, msg, events);
 
-			vive_sensor_sample* smp = NULL;
+	for(int i = 0; i < count; i++)
+		ohmdq_push(priv->base.digital_input_event_queue, &events[i]);
 
-			while((smp = get_next_sample(&pkt, priv->last_seq)) != NULL)
-			{
-				if(priv->last_ticks == 0)
-					priv->last_ticks = smp->time_ticks;
+	if(msg->flags & VIVE_CONTROLLER_HAS_IMU){
+		float dt = (int32_t)(msg->time_ticks - priv->last_ticks) / VIVE_TIME_DIV;
 
-				uint32_t t1, t2;
-				t1 = smp->time_ticks;
-				t2 = priv->last_ticks;
+		// start over on the first sample, and on time codes that went backwards or skipped far ahead
+		if(priv->have_sample && dt > 0 && dt <= VIVE_CONTROLLER_MAX_DT){
+			vec3f accel, gyro, mag = {{0, 0, 0}};
 
-				float dt = (t1 - t2) / VIVE_TIME_DIV;
+			vec3f_from_vive_vec_accel(msg->acc, &accel);
+			vec3f_from_vive_vec_gyro(msg->rot, &gyro);
 
-				priv->last_ticks = smp->time_ticks;
+			ofusion_update(&priv->sensor_fusion, dt, &gyro, &accel, &mag);
+		}
 
-				vec3f_from_vive_vec_accel(smp->acc, &priv->raw_accel);
-				vec3f_from_vive_vec_gyro(smp->rot, &priv->raw_gyro);
+		priv->last_ticks = msg->time_ticks;
+		priv->have_sample = true;
+	}
+}
 
-				if(process_error(priv)){
-					vec3f mag = {{0.0f, 0.0f, 0.0f}};
-					vec3f gyro;
-					ovec3f_subtract(&priv->raw_gyro, &priv->gyro_error, &gyro);
+static void update_controller(ohmd_device* device)
+{
+	vive_controller_priv* priv = (vive_controller_priv*)device;
 
-					ofusion_update(&priv->sensor_fusion, dt, &gyro, &priv->raw_accel, &mag);
-				}
+	int size = 0;
+	unsigned char buffer[FEATURE_BUFFER_SIZE];
 
-				priv->last_seq = smp->seq;
-			}
-		}else{
-			LOGE("unknown message type: %u", buffer[0]);
+	while((size = ohmd_hid_reader_read(&priv->reader, buffer, FEATURE_BUFFER_SIZE)) > 0){
+		// the dongle sends status and light sensor reports as well, only controller reports are decoded
+		if(buffer[0] == VIVE_CONTROLLER_REPORT){
+			vive_controller_packet pkt;
+			if(vive_decode_controller_packet(&pkt, buffer, size))
+				handle_controller_message(priv, &pkt.message);
 		}
 	}
 
@@ -156,6 +198,52 @@ static void update_device(ohmd_device* device)
 	}
 }
 
+static int getf_controller(ohmd_device* device, ohmd_float_value type, float* out)
+{
+	vive_controller_priv* priv = (vive_controller_priv*)device;
+
+	switch(type){
+	case OHMD_ROTATION_QUAT:
+		*(quatf*)out = priv->sensor_fusion.orient;
+		break;
+
+	case OHMD_POSITION_VECTOR:
+		out[0] = out[1] = out[2] = 0;
+		break;
+
+	default:
+		ohmd_set_error(priv->base.ctx, "invalid type given to getf (%ud)", type);
+		return -1;
+		break;
+	}
+
+	return 0;
+}
+
+static int seti_controller(ohmd_device* device, ohmd_int_value type, const int* in)
+{
+	vive_controller_priv* priv = (vive_controller_priv*)device;
+
+	switch(type){
+	case OHMD_FUSION_ALGORITHM:
+		return ofusion_set_algorithm(&priv->sensor_fusion, in[0]) == 0 ? OHMD_S_OK : OHMD_S_INVALID_PARAMETER;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
+static void close_controller(ohmd_device* device)
+{
+	vive_controller_priv* priv = (vive_controller_priv*)device;
+
+	LOGD("closing HTC Vive controller");
+
+	ohmd_hid_reader_close(&priv->reader);
+	hid_close(priv->handle);
+	free(device);
+}
+
 static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 {
 	vive_priv* priv = (vive_priv*)device;
@@ -183,6 +271,37 @@ static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 	return 0;
 }
 
+static int geti(ohmd_device* device, ohmd_int_value type, int* out)
+{
+	vive_priv* priv = (vive_priv*)device;
+
+	switch(type){
+	case OHMD_SENSOR_SAMPLES_DROPPED:
+		*out = priv->sample_order.dropped_samples;
+		return OHMD_S_OK;
+
+	case OHMD_SENSOR_SAMPLES_DUPLICATED:
+		*out = priv->sample_order.duplicate_samples;
+		return OHMD_S_OK;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
+static int seti(ohmd_device* device, ohmd_int_value type, const int* in)
+{
+	vive_priv* priv = (vive_priv*)device;
+
+	switch(type){
+	case OHMD_FUSION_ALGORITHM:
+		return ofusion_set_algorithm(&priv->sensor_fusion, in[0]) == 0 ? OHMD_S_OK : OHMD_S_INVALID_PARAMETER;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
 static void close_device(ohmd_device* device)
 {
 	int hret = 0;
@@ -197,9 +316,15 @@ static void close_device(ohmd_device* device)
 	hret = hid_send_feature_report(priv->hmd_handle, vive_magic_power_off2, sizeof(vive_magic_power_off2));
 	printf("power off magic 2: %d\n", hret);
 
+	ohmd_hid_reader_close(&priv->imu_reader);
+	ohmd_hid_reader_close(&priv->lighthouse_reader);
+
 	hid_close(priv->hmd_handle);
 	hid_close(priv->imu_handle);
 
+	if(priv->lighthouse_handle)
+		hid_close(priv->lighthouse_handle);
+
 	free(device);
 }
 
@@ -244,7 +369,8 @@ static void dumpbin(const char* label, const unsigned char* data, int length)
 }
 #endif
 
-static hid_device* open_device_idx(int manufacturer, int product, int iface, int iface_tot, int device_index)
+// path receives the opened device's path, OHMD_STR_SIZE bytes
+static hid_device* open_device_idx(int manufacturer, int product, int iface, int iface_tot, int device_index, char* path)
 {
 	struct hid_device_info* devs = hid_enumerate(manufacturer, product);
 	struct hid_device_info* cur_dev = devs;
@@ -258,6 +384,8 @@ static hid_device* open_device_idx(int manufacturer, int product, int iface, int
 
 		if(idx == device_index && iface == iface_cur){
 			ret = hid_open_path(cur_dev->path);
+			strncpy(path, cur_dev->path, OHMD_STR_SIZE - 1);
+			path[OHMD_STR_SIZE - 1] = '\0';
 			printf("opening\n");
 		}
 
@@ -276,8 +404,62 @@ static hid_device* open_device_idx(int manufacturer, int product, int iface, int
 	return ret;
 }
 
+static ohmd_device* open_controller(ohmd_driver* driver, ohmd_device_desc* desc)
+{
+	vive_controller_priv* priv = ohmd_alloc(driver->ctx, sizeof(vive_controller_priv));
+
+	if(!priv)
+		return NULL;
+
+	priv->base.ctx = driver->ctx;
+
+	// the path is the dongle's HID path
+	priv->handle = hid_open_path(desc->path);
+
+	if(!priv->handle){
+		ohmd_set_error(driver->ctx, "Could not open %.200s", desc->path);
+		goto cleanup;
+	}
+
+	if(hid_set_nonblocking(priv->handle, 1) == -1){
+		ohmd_set_error(driver->ctx, "failed to set non-blocking on device");
+		goto cleanup;
+	}
+
+	// Set default device properties
+	ohmd_set_default_device_properties(&priv->base.properties);
+
+	priv->base.properties.digital_button_count = VIVE_CONTROLLER_BUTTON_COUNT;
+
+	// set up device callbacks
+	priv->base.update = update_controller;
+	priv->base.close = close_controller;
+	priv->base.getf = getf_controller;
+	priv->base.seti = seti_controller;
+
+	ofusion_init(&priv->sensor_fusion);
+
+	// like the HMD's, the controller IMU's gyro bias isn't compensated by the hardware
+	priv->sensor_fusion.flags |= FF_USE_GYRO_BIAS;
+
+	ohmd_hid_reader_init(&priv->reader, &priv->base, priv->handle, desc->path);
+
+	return (ohmd_device*)priv;
+
+cleanup:
+	if(priv->handle)
+		hid_close(priv->handle);
+
+	free(priv);
+
+	return NULL;
+}
+
 static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 {
+	if(desc->revision == VIVE_DEVICE_CONTROLLER)
+		return open_controller(driver, desc);
+
 	vive_priv* priv = ohmd_alloc(driver->ctx, sizeof(vive_priv));
 
 	if(!priv)
@@ -288,9 +470,10 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	priv->base.ctx = driver->ctx;
 
 	int idx = atoi(desc->path);
+	char hmd_path[OHMD_STR_SIZE], imu_path[OHMD_STR_SIZE], lighthouse_path[OHMD_STR_SIZE];
 
 	// Open the HMD device
-	priv->hmd_handle = open_device_idx(HTC_ID, VIVE_HMD, 0, 1, idx);
+	priv->hmd_handle = open_device_idx(HTC_ID, VIVE_HMD, 0, 1, idx, hmd_path);
 
 	if(!priv->hmd_handle)
 		goto cleanup;
@@ -301,7 +484,7 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	}
 
 	// Open the lighthouse device
-	priv->imu_handle = open_device_idx(VALVE_ID, VIVE_LIGHTHOUSE_FPGA_RX, 0, 2, idx);
+	priv->imu_handle = open_device_idx(VALVE_ID, VIVE_LIGHTHOUSE_FPGA_RX, 0, 2, idx, imu_path);
 
 	if(!priv->imu_handle)
 		goto cleanup;
@@ -311,6 +494,17 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 		goto cleanup;
 	}
 
+	// the photodiode pulses come on the receiver's second interface
+	priv->lighthouse_handle = open_device_idx(VALVE_ID, VIVE_LIGHTHOUSE_FPGA_RX, 1, 2, idx, lighthouse_path);
+
+	if(priv->lighthouse_handle && hid_set_nonblocking(priv->lighthouse_handle, 1) == -1){
+		hid_close(priv->lighthouse_handle);
+		priv->lighthouse_handle = NULL;
+	}
+
+	if(!priv->lighthouse_handle)
+		LOGW("could not open the lighthouse receiver, there will be no sweeps");
+
 	dump_info_string(hid_get_manufacturer_string, "manufacturer", priv->hmd_handle);
 	dump_info_string(hid_get_product_string , "product", priv->hmd_handle);
 	dump_info_string(hid_get_serial_number_string, "serial number", priv->hmd_handle);
@@ -320,8 +514,11 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	printf("power on magic: %d\n", hret);
 
 	// enable lighthouse
-	//hret = hid_send_feature_report(priv->hmd_handle, vive_magic_enable_lighthouse, sizeof(vive_magic_enable_lighthouse));
-	//printf("enable lighthouse magic: %d\n", hret);
+	if(priv->lighthouse_handle){
+		hret = hid_send_feature_report(priv->hmd_handle, vive_magic_enable_lighthouse, sizeof(vive_magic_enable_lighthouse));
+		if(hret < 0)
+			LOGW("could not enable the lighthouse receiver");
+	}
 
 	unsigned char buffer[128];
 	int bytes;
@@ -380,25 +577,26 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 
 	// calculate projection eye projection matrices from the device properties
 	//ohmd_calc_default_proj_matrices(&priv->base.properties);
-	float l,r,t,b,n,f;
+	float l,r,t,b,n;
 	// left eye screen bounds
 	l = -1.0f * (priv->base.properties.hsize/2 - priv->base.properties.lens_sep/2);
 	r = priv->base.properties.lens_sep/2;
 	t = priv->base.properties.vsize - priv->base.properties.lens_vpos;
 	b = -1.0f * priv->base.properties.lens_vpos;
 	n = eye_to_screen_distance;
-	f = n*10e6;
-	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f, f: %0.3f", l,r,b,t,n,f);
+	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f", l,r,b,t,n);
 	/* eye separation is handled by IPD in the Modelview matrix */
-	omat4x4f_init_frustum(&priv->base.properties.proj_left, l, r, b, t, n, f);
+	ohmd_set_proj_tangents(&priv->base.properties, 0, l / n, r / n, b / n, t / n);
 	//right eye screen bounds
 	l = -1.0f * priv->base.properties.lens_sep/2;
 	r = priv->base.properties.hsize/2 - priv->base.properties.lens_sep/2;
 	n = eye_to_screen_distance;
-	f = n*10e6;
-	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f, f: %0.3f", l,r,b,t,n,f);
+	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f", l,r,b,t,n);
 	/* eye separation is handled by IPD in the Modelview matrix */
-	omat4x4f_init_frustum(&priv->base.properties.proj_right, l, r, b, t, n, f);
+	ohmd_set_proj_tangents(&priv->base.properties, 1, l / n, r / n, b / n, t / n);
+
+	// the planes come from OHMD_PROJECTION_ZNEAR and ZFAR
+	ohmd_calc_proj_matrices(&priv->base.properties);
 
 	priv->base.properties.fov = 2 * atan2f(
 			priv->base.properties.hsize/2 - priv->base.properties.lens_sep/2,
@@ -408,10 +606,25 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	priv->base.update = update_device;
 	priv->base.close = close_device;
 	priv->base.getf = getf;
+	priv->base.geti = geti;
+	priv->base.seti = seti;
+	priv->base.read_stream = read_stream;
 
 	ofusion_init(&priv->sensor_fusion);
 
-	ofq_init(&priv->gyro_q, 128);
+	// the gyro bias isn't compensated by the hardware, estimate it while the device is still
+	priv->sensor_fusion.flags |= FF_USE_GYRO_BIAS;
+
+	// the IMU reports at 1000 Hz, fuse pre-integrated windows of 4 samples
+	priv->sensor_fusion.fuse_interval = 4;
+
+	// both receiver interfaces send their reports at a high rate
+	ohmd_hid_reader_init(&priv->imu_reader, &priv->base, priv->imu_handle, imu_path);
+
+	if(priv->lighthouse_handle)
+		ohmd_hid_reader_init(&priv->lighthouse_reader, &priv->base, priv->lighthouse_handle, lighthouse_path);
+	else
+		priv->lighthouse_reader.fd = -1;
 
 	return (ohmd_device*)priv;
 
@@ -435,7 +648,7 @@ static void get_device_list(ohmd_driver* driver, ohmd_device_list* list)
 		strcpy(desc->vendor, "HTC/Valve");
 		strcpy(desc->product, "HTC Vive");
 
-		desc->revision = 0;
+		desc->revision = VIVE_DEVICE_HMD;
 
 		snprintf(desc->path, OHMD_STR_SIZE, "%d", idx);
 
@@ -446,6 +659,36 @@ static void get_device_list(ohmd_driver* driver, ohmd_device_list* list)
 	}
 
 	hid_free_enumeration(devs);
+
+	// one Watchman receiver per controller, both the ones built into the HMD and the USB dongles
+	devs = hid_enumerate(VALVE_ID, VIVE_WATCHMAN_DONGLE);
+	cur_dev = devs;
+
+	idx = 0;
+	while (cur_dev) {
+		// the controller reports come on the first interface
+		if(cur_dev->interface_number > 0 || list->num_devices >= OHMD_MAX_DEVICES){
+			cur_dev = cur_dev->next;
+			continue;
+		}
+
+		ohmd_device_desc* desc = &list->devices[list->num_devices++];
+
+		strcpy(desc->driver, "OpenHMD HTC Vive Driver");
+		strcpy(desc->vendor, "HTC/Valve");
+		snprintf(desc->product, OHMD_STR_SIZE, "HTC Vive: Controller %d", idx);
+
+		desc->revision = VIVE_DEVICE_CONTROLLER;
+
+		snprintf(desc->path, OHMD_STR_SIZE, "%s", cur_dev->path);
+
+		desc->driver_ptr = driver;
+
+		cur_dev = cur_dev->next;
+		idx++;
+	}
+
+	hid_free_enumeration(devs);
 }
 
 static void destroy_driver(ohmd_driver* drv)
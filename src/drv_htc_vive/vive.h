@@ -7,10 +7,15 @@
 #include "../openhmdi.h"
 #include "magic.h"
 
+#define VIVE_TIME_DIV 48000000.0f
+#define VIVE_SAMPLE_TICKS 48000 // the IMU samples at 1 kHz
+
 typedef enum
 {
 	VIVE_CONFIG_DATA = 17,
 	VIVE_IRQ_SENSORS = 32,
+	VIVE_LIGHTHOUSE_REPORT = 33,
+	VIVE_CONTROLLER_REPORT = 35,
 } vive_irq_cmd;
 
 typedef struct
@@ -21,12 +26,91 @@ typedef struct
 	uint8_t seq;
 } vive_sensor_sample;
 
+// samples in a sensor report, each is repeated in up to three consecutive reports
+#define VIVE_SAMPLES 3
+
 typedef struct
 {
 	uint8_t report_id;
-	vive_sensor_sample samples[3];
+	vive_sensor_sample samples[VIVE_SAMPLES];
 } vive_sensor_packet;
 
+// where the IMU sample stream left off, see vive_order_samples
+typedef struct
+{
+	vec3f last_gyro;
+	uint32_t last_ticks;
+	uint8_t last_seq;
+	bool have_sample;
+	int dropped_samples, duplicate_samples;
+} vive_sample_order;
+
+// a time span to integrate at one angular velocity, with the accelerometer of sample
+typedef struct
+{
+	float dt;
+	vec3f gyro;
+	const imu_sample* sample;
+} vive_fusion_step;
+
+// a step across a gap before the first sample, and up to two steps per sample
+#define VIVE_MAX_FUSION_STEPS (2 * VIVE_SAMPLES + 1)
+
+// digital buttons of a controller, button i is bit i of the button mask
+typedef enum
+{
+	VIVE_CONTROLLER_TRIGGER,
+	VIVE_CONTROLLER_TRACKPAD_CLICK,
+	VIVE_CONTROLLER_TRACKPAD_TOUCH,
+	VIVE_CONTROLLER_SYSTEM,
+	VIVE_CONTROLLER_GRIP,
+	VIVE_CONTROLLER_MENU,
+	VIVE_CONTROLLER_BUTTON_COUNT
+} vive_controller_button;
+
+// parts present in a controller message
+#define VIVE_CONTROLLER_HAS_BUTTONS  0x01
+#define VIVE_CONTROLLER_HAS_TRIGGER  0x02
+#define VIVE_CONTROLLER_HAS_TRACKPAD 0x04
+#define VIVE_CONTROLLER_HAS_BATTERY  0x08
+#define VIVE_CONTROLLER_HAS_IMU      0x10
+
+typedef struct
+{
+	uint8_t flags;
+	uint8_t buttons;
+	uint8_t trigger;
+	int16_t trackpad[2];
+	uint8_t battery;
+	bool charging;
+	int16_t acc[3];
+	int16_t rot[3];
+	uint32_t time_ticks;
+} vive_controller_message;
+
+typedef struct
+{
+	uint8_t report_id;
+	vive_controller_message message;
+} vive_controller_packet;
+
+// pulses in a lighthouse report, and the most sweep samples one decodes to
+#define VIVE_LIGHTHOUSE_PULSES 9
+
+// tracks the sync flashes of the base stations across lighthouse reports
+typedef struct
+{
+	uint32_t sync_time;   // start of the last sync flash
+	uint16_t sync_length; // its longest pulse
+	uint8_t sync_station; // its place in the cycle
+	bool have_sync;
+
+	uint32_t sweep_start; // sync flash of the station sweeping now
+	uint8_t sweep_station;
+	uint8_t sweep_axis;
+	bool sweeping;
+} vive_lighthouse_decoder;
+
 typedef struct
 {
 	uint8_t report_id;
@@ -34,8 +118,14 @@ typedef struct
 	unsigned char config_data[99999];
 } vive_config_packet;
 
-void vec3f_from_vive_vec(const int16_t* smp, vec3f* out_vec);
+void vec3f_from_vive_vec_accel(const int16_t* smp, vec3f* out_vec);
+void vec3f_from_vive_vec_gyro(const int16_t* smp, vec3f* out_vec);
 bool vive_decode_sensor_packet(vive_sensor_packet* pkt, const unsigned char* buffer, int size);
+bool vive_decode_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size);
+int vive_order_samples(vive_sample_order* order, imu_sample** smp, vive_fusion_step* out);
+bool vive_decode_controller_packet(vive_controller_packet* pkt, const unsigned char* buffer, int size);
+int vive_controller_button_events(uint8_t* buttons, const vive_controller_message* msg, ohmd_digital_input_event* out);
+int vive_decode_lighthouse_report(vive_lighthouse_decoder* d, const unsigned char* buffer, int size, ohmd_sweep_sample* out);
 bool vive_decode_config_packet(vive_config_packet* pkt, const unsigned char* buffer, uint16_t size);
 
 #endif
@@ -20,7 +20,6 @@
 #define NOLO_ID					0x0483 //ST microcontroller
 #define NOLO_HMD				0x5750
 
-static const int controllerLength = 3 + (3+4)*2 + 2 + 2 + 1;
 static devices_t* nolo_devices;
 
 static drv_priv* drv_priv_get(ohmd_device* device)
@@ -61,7 +60,7 @@ static void update_device(ohmd_device* device)
 
 	// Read all the messages from the device.
 	while(true){
-		int size = hid_read(priv->handle, buffer, FEATURE_BUFFER_SIZE);
+		int size = ohmd_hid_reader_read(&priv->reader, buffer, FEATURE_BUFFER_SIZE);
 		if(size < 0){
 			LOGE("error reading from device");
 			return;
@@ -69,19 +68,20 @@ static void update_device(ohmd_device* device)
 			return; // No more messages, return.
 		}
 
-		nolo_decrypt_data(buffer);
-
+		// the report type is sent in the clear, each type only decrypts what it decodes
 		// currently the only message type the hardware supports
 		switch (buffer[0]) {
 			case 0xa5:  // Controllers packet
 			{
+				nolo_decrypt_data_from(buffer, controller0 ? 1 : 64-NOLO_CONTROLLER_LENGTH);
 				if (controller0)
 					nolo_decode_controller(controller0, buffer+1);
 				if (controller1)
-					nolo_decode_controller(controller1, buffer+64-controllerLength);
+					nolo_decode_controller(controller1, buffer+64-NOLO_CONTROLLER_LENGTH);
 			break;
 			}
 			case 0xa6: // HMD packet
+				nolo_decrypt_data_from(buffer, 0x15);
 				nolo_decode_hmd_marker(priv, buffer+0x15);
 				nolo_decode_base_station(priv, buffer+0x36);
 			break;
@@ -133,6 +133,7 @@ static void close_device(ohmd_device* device)
 {
 	LOGD("closing device");
 	drv_priv* priv = drv_priv_get(device);
+	ohmd_hid_reader_close(&priv->reader);
 	hid_close(priv->handle);
 	free(priv);
 }
@@ -183,6 +184,7 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 
 	priv->id = desc->id;
 	priv->base.ctx = driver->ctx;
+	priv->reader.fd = -1;
 
 	// Open the HID device when physical device
 	if (priv->id == 0)
@@ -202,6 +204,7 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 			goto cleanup;
 		}
 
+		ohmd_hid_reader_init(&priv->reader, &priv->base, priv->handle, desc->path);
 	}
 
 	devices_t* current = nolo_devices;
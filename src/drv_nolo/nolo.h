@@ -12,12 +12,18 @@
 #include "../openhmdi.h"
 #include <hidapi.h>
 
+#include "../hid_reader.h"
+
 #define FEATURE_BUFFER_SIZE 64
 
+// controller 1 sits at the end of a controllers report
+#define NOLO_CONTROLLER_LENGTH (3 + (3+4)*2 + 2 + 2 + 1)
+
 typedef struct {
 	ohmd_device base;
 
 	hid_device* handle;
+	ohmd_hid_reader reader;
 	int id;
 	uint8_t button_state;
 } drv_priv;
@@ -36,6 +42,8 @@ typedef struct devices{
 
 void btea_decrypt(uint32_t *v, int n, int base_rounds, uint32_t const key[4]);
 void nolo_decrypt_data(unsigned char* buf);
+// decrypt only as far as needed to read from first_byte to the end of the report
+void nolo_decrypt_data_from(unsigned char* buf, int first_byte);
 
 void nolo_decode_base_station(drv_priv* priv, unsigned char* data);
 void nolo_decode_hmd_marker(drv_priv* priv, unsigned char* data);
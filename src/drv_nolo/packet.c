@@ -7,6 +7,7 @@
 /* NOLO VR - Packet Decoding and Utilities */
 
 #include <stdio.h>
+#include <string.h>
 #include "nolo.h"
 
 #define DELTA 0x9e3779b9
@@ -35,29 +36,91 @@ void btea_decrypt(uint32_t *v, int n, int base_rounds, uint32_t const key[4])
 	} while (--rounds);
 }
 
-void nolo_decrypt_data(unsigned char* buf)
+/*
+ * Reports are always 64 bytes with the 15 words after the report type byte
+ * encrypted under one constant key, so the decryptor below is specialized for
+ * that block: 4 rounds of 15 steps unrolled, with the round sums and key
+ * indices as constants. btea_decrypt stays as the generic reference.
+ */
+#define NOLO_CRYPT_OFFSET 1
+#define NOLO_CRYPT_WORDS ((64 - 4) / 4)
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+	defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64)
+#define NOLO_LITTLE_ENDIAN 1
+#endif
+
+static const uint32_t nolo_key[4] = {0x875bcc51, 0xa7637a66, 0x50960967, 0xf8536c51};
+
+// one decryption step of word _p with _zp as the word before it
+#define NOLO_STEP(_p, _zp, _sum) \
+	z = v[_zp]; \
+	y = v[_p] -= ((z >> 5 ^ y << 2) + (y >> 3 ^ z << 4)) ^ \
+		(((uint32_t)(_sum) ^ y) + (nolo_key[((_p) & 3) ^ (((uint32_t)(_sum) >> 2) & 3)] ^ z));
+
+// the last round leaves word _p final, stop once first_word is reached
+#define NOLO_LAST_STEP(_p, _zp, _sum) \
+	NOLO_STEP(_p, _zp, _sum) \
+	if((_p) <= first_word) \
+		return;
+
+#define NOLO_ROUND(_S, _sum) \
+	_S(14, 13, _sum) _S(13, 12, _sum) _S(12, 11, _sum) _S(11, 10, _sum) _S(10, 9, _sum) \
+	_S(9, 8, _sum) _S(8, 7, _sum) _S(7, 6, _sum) _S(6, 5, _sum) _S(5, 4, _sum) \
+	_S(4, 3, _sum) _S(3, 2, _sum) _S(2, 1, _sum) _S(1, 0, _sum) _S(0, 14, _sum)
+
+// 1 + 52 / 15 rounds, only words first_word and up are decrypted in the last one
+static void nolo_xxtea_decrypt(uint32_t* v, int first_word)
 {
-	const int cryptwords = (64-4)/4, cryptoffset = 1;
-	static const uint32_t key[4] = {0x875bcc51, 0xa7637a66, 0x50960967, 0xf8536c51};
-	uint32_t cryptpart[cryptwords];
+	uint32_t y = v[0], z;
+
+	NOLO_ROUND(NOLO_STEP, 4 * DELTA)
+	NOLO_ROUND(NOLO_STEP, 3 * DELTA)
+	NOLO_ROUND(NOLO_STEP, 2 * DELTA)
+	NOLO_ROUND(NOLO_LAST_STEP, 1 * DELTA)
+}
 
-	// Decrypt encrypted portion
-	for (int i = 0; i < cryptwords; i++) {
+void nolo_decrypt_data_from(unsigned char* buf, int first_byte)
+{
+	int first_word = (first_byte - NOLO_CRYPT_OFFSET) / 4;
+	uint32_t cryptpart[NOLO_CRYPT_WORDS];
+
+	if(first_word < 0)
+		first_word = 0;
+	else if(first_word > NOLO_CRYPT_WORDS)
+		first_word = NOLO_CRYPT_WORDS;
+
+#ifdef NOLO_LITTLE_ENDIAN
+	// the words are stored in host order, the copies only fix the alignment
+	memcpy(cryptpart, buf + NOLO_CRYPT_OFFSET, sizeof(cryptpart));
+#else
+	for (int i = 0; i < NOLO_CRYPT_WORDS; i++) {
 	cryptpart[i] =
-		((uint32_t)buf[cryptoffset+4*i  ]) << 0  |
-		((uint32_t)buf[cryptoffset+4*i+1]) << 8  |
-		((uint32_t)buf[cryptoffset+4*i+2]) << 16 |
-		((uint32_t)buf[cryptoffset+4*i+3]) << 24;
+		((uint32_t)buf[NOLO_CRYPT_OFFSET+4*i  ]) << 0  |
+		((uint32_t)buf[NOLO_CRYPT_OFFSET+4*i+1]) << 8  |
+		((uint32_t)buf[NOLO_CRYPT_OFFSET+4*i+2]) << 16 |
+		((uint32_t)buf[NOLO_CRYPT_OFFSET+4*i+3]) << 24;
 	}
-
-	btea_decrypt(cryptpart, cryptwords, 1, key);
-
-	for (int i = 0; i < cryptwords; i++) {
-		buf[cryptoffset+4*i  ] = cryptpart[i] >> 0;
-		buf[cryptoffset+4*i+1] = cryptpart[i] >> 8;
-		buf[cryptoffset+4*i+2] = cryptpart[i] >> 16;
-		buf[cryptoffset+4*i+3] = cryptpart[i] >> 24;
+#endif
+
+	nolo_xxtea_decrypt(cryptpart, first_word);
+
+#ifdef NOLO_LITTLE_ENDIAN
+	memcpy(buf + NOLO_CRYPT_OFFSET + 4 * first_word, cryptpart + first_word,
+		(NOLO_CRYPT_WORDS - first_word) * sizeof(uint32_t));
+#else
+	for (int i = first_word; i < NOLO_CRYPT_WORDS; i++) {
+		buf[NOLO_CRYPT_OFFSET+4*i  ] = cryptpart[i] >> 0;
+		buf[NOLO_CRYPT_OFFSET+4*i+1] = cryptpart[i] >> 8;
+		buf[NOLO_CRYPT_OFFSET+4*i+2] = cryptpart[i] >> 16;
+		buf[NOLO_CRYPT_OFFSET+4*i+3] = cryptpart[i] >> 24;
 	}
+#endif
+}
+
+void nolo_decrypt_data(unsigned char* buf)
+{
+	nolo_decrypt_data_from(buf, NOLO_CRYPT_OFFSET);
 }
 
 void nolo_decode_position(const unsigned char* data, vec3f* pos)
@@ -8,164 +8,148 @@
 /* Oculus Rift Driver - Packet Decoding and Utilities */
 
 #include <stdio.h>
+#include <string.h>
 #include "rift.h"
-
-#define SKIP_CMD (buffer++)
-#define READ8 *(buffer++);
-#define READ16 *buffer | (*(buffer + 1) << 8); buffer += 2;
-#define READ32 *buffer | (*(buffer + 1) << 8) | (*(buffer + 2) << 16) | (*(buffer + 3) << 24); buffer += 4;
-#define READFLOAT ((float)(*buffer)); buffer += 4;
-#define READFIXED (float)(*buffer | (*(buffer + 1) << 8) | (*(buffer + 2) << 16) | (*(buffer + 3) << 24)) / 1000000.0f; buffer += 4;
+#include "../packet_layout.h"
+#include "../packet_vec21.h"
 
 #define WRITE8(_val) *(buffer++) = (_val);
 #define WRITE16(_val) WRITE8((_val) & 0xff); WRITE8(((_val) >> 8) & 0xff);
 #define WRITE32(_val) WRITE16((_val) & 0xffff) *buffer; WRITE16(((_val) >> 16) & 0xffff);
 
-bool decode_sensor_range(pkt_sensor_range* range, const unsigned char* buffer, int size)
-{
-	if(!(size == 8 || size == 9)){
-		LOGE("invalid packet size (expected 8 or 9 but got %d)", size);
-		return false;
-	}
-
-	SKIP_CMD;
-	range->command_id = READ16;
-	range->accel_scale = READ8;
-	range->gyro_scale = READ16;
-	range->mag_scale = READ16;
-
-	return true;
-}
+#define SENSOR_RANGE_LAYOUT(F) \
+	F(command_id, 1, u16) \
+	F(accel_scale, 3, u8) \
+	F(gyro_scale, 4, u16) \
+	F(mag_scale, 6, u16)
+
+#define SENSOR_DISPLAY_INFO_LAYOUT(F) \
+	F(command_id, 1, u16) \
+	F(distortion_type, 3, u8) \
+	F(h_resolution, 4, u16) \
+	F(v_resolution, 6, u16) \
+	F(h_screen_size, 8, fixed) \
+	F(v_screen_size, 12, fixed) \
+	F(v_center, 16, fixed) \
+	F(lens_separation, 20, fixed) \
+	F(eye_to_screen_distance[0], 24, fixed) \
+	F(eye_to_screen_distance[1], 28, fixed) \
+	F(distortion_k[0], 32, float) \
+	F(distortion_k[1], 36, float) \
+	F(distortion_k[2], 40, float) \
+	F(distortion_k[3], 44, float) \
+	F(distortion_k[4], 48, float) \
+	F(distortion_k[5], 52, float)
+
+#define SENSOR_CONFIG_LAYOUT(F) \
+	F(command_id, 1, u16) \
+	F(flags, 3, u8) \
+	F(packet_interval, 4, u8) \
+	F(keep_alive_interval, 5, u16)
+
+#define TRACKER_SENSOR_LAYOUT(F) \
+	F(num_samples, 1, u8) \
+	F(timestamp, 2, u16) \
+	F(last_command_id, 4, u16) \
+	F(temperature, 6, s16) \
+	PL_VEC3(F, mag, 56, s16)
+
+// samples start at 12, after the number of samples since start at 4, which is unused
+#define TRACKER_SENSOR_DK2_LAYOUT(F) \
+	F(last_command_id, 1, u16) \
+	F(num_samples, 3, u8) \
+	F(temperature, 6, s16) \
+	F(timestamp, 8, u32) \
+	PL_VEC3(F, mag, 44, s16)
+
+PL_DECODER(decode_sensor_range, pkt_sensor_range, SENSOR_RANGE_LAYOUT, 8, 9)
+PL_DECODER(decode_sensor_config, pkt_sensor_config, SENSOR_CONFIG_LAYOUT, 7, 8)
+
+static PL_DECODER(decode_sensor_display_info_fields, pkt_sensor_display_info, SENSOR_DISPLAY_INFO_LAYOUT, 56, 57)
+static PL_DECODER_SIZES(decode_tracker_sensor_fields, pkt_tracker_sensor, TRACKER_SENSOR_LAYOUT, 62, 64)
+static PL_DECODER(decode_tracker_sensor_dk2_fields, pkt_tracker_sensor, TRACKER_SENSOR_DK2_LAYOUT, 64, 64)
 
 bool decode_sensor_display_info(pkt_sensor_display_info* info, const unsigned char* buffer, int size)
 {
-	if(!(size == 56 || size == 57)){
-		LOGE("invalid packet size (expected 56 or 57 but got %d)", size);
+	if(!decode_sensor_display_info_fields(info, buffer, size))
 		return false;
-	}
-
-	SKIP_CMD;
-	info->command_id = READ16;
-	info->distortion_type = READ8;
-	info->h_resolution = READ16;
-	info->v_resolution = READ16;
-	info->h_screen_size = READFIXED;
-	info->v_screen_size = READFIXED;
-	info->v_center = READFIXED;
-	info->lens_separation = READFIXED;
-	info->eye_to_screen_distance[0] = READFIXED;
-	info->eye_to_screen_distance[1] = READFIXED;
 
 	info->distortion_type_opts = 0;
 
-	for(int i = 0; i < 6; i++){
-		info->distortion_k[i] = READFLOAT;
-	}
-
 	return true;
 }
 
-bool decode_sensor_config(pkt_sensor_config* config, const unsigned char* buffer, int size)
-{
-	if(!(size == 7 || size == 8)){
-		LOGE("invalid packet size (expected 7 or 8 but got %d)", size);
-		return false;
-	}
-
-	SKIP_CMD;
-	config->command_id = READ16;
-	config->flags = READ8;
-	config->packet_interval = READ8;
-	config->keep_alive_interval = READ16;
-
-	return true;
-}
-
-static void decode_sample(const unsigned char* buffer, int32_t* smp)
-{
-	/*
-	 * Decode 3 tightly packed 21 bit values from 4 bytes.
-	 * We unpack them in the higher 21 bit values first and then shift
-	 * them down to the lower in order to get the sign bits correct.
-	 */
-
-	int x = (buffer[0] << 24)          | (buffer[1] << 16) | ((buffer[2] & 0xF8) << 8);
-	int y = ((buffer[2] & 0x07) << 29) | (buffer[3] << 21) | (buffer[4] << 13) | ((buffer[5] & 0xC0) << 5);
-	int z = ((buffer[5] & 0x3F) << 26) | (buffer[6] << 18) | (buffer[7] << 10);
-
-	smp[0] = x >> 11;
-	smp[1] = y >> 11;
-	smp[2] = z >> 11;
-}
+// raw sample values to m/s^2 and rad/s
+#define SAMPLE_SCALE 0.0001f
 
 bool decode_tracker_sensor_msg(pkt_tracker_sensor* msg, const unsigned char* buffer, int size)
 {
-	if(!(size == 62 || size == 64)){
-		LOGE("invalid packet size (expected 62 or 64 but got %d)", size);
+	if(!decode_tracker_sensor_fields(msg, buffer, size))
 		return false;
-	}
 
-	SKIP_CMD;
-	msg->num_samples = READ8;
-	msg->timestamp = READ16;
 	msg->timestamp *= 1000; // DK1 timestamps are in milliseconds
-	msg->last_command_id = READ16;
-	msg->temperature = READ16;
 
 	msg->num_samples = OHMD_MIN(msg->num_samples, 3);
-	for(int i = 0; i < msg->num_samples; i++){
-		decode_sample(buffer, msg->samples[i].accel);
-		buffer += 8;
-
-		decode_sample(buffer, msg->samples[i].gyro);
-		buffer += 8;
-	}
-
-	// Skip empty samples
-	buffer += (3 - msg->num_samples) * 16;
-	for(int i = 0; i < 3; i++){
-		msg->mag[i] = READ16;
-	}
+	pl_unpack_vec21(buffer + 8, msg->num_samples * 2, SAMPLE_SCALE, msg->smp_x, msg->smp_y, msg->smp_z);
 
 	return true;
 }
 
 bool decode_tracker_sensor_msg_dk2(pkt_tracker_sensor* msg, const unsigned char* buffer, int size)
 {
-	if(!(size == 64)){
-		LOGE("invalid packet size (expected 62 or 64 but got %d)", size);
+	if(!decode_tracker_sensor_dk2_fields(msg, buffer, size))
 		return false;
-	}
-
-	SKIP_CMD;
-	msg->last_command_id = READ16;
-	msg->num_samples = READ8;
-	/* Next is the number of samples since start, excluding the samples
-	contained in this packet */
-	buffer += 2; // unused: nb_samples_since_start
-	msg->temperature = READ16;
-	msg->timestamp = READ32;
 
 	/* Second sample value is junk (outdated/uninitialized) value if
 	num_samples < 2. */
 	msg->num_samples = OHMD_MIN(msg->num_samples, 2);
-	for(int i = 0; i < msg->num_samples; i++){
-		decode_sample(buffer, msg->samples[i].accel);
-		buffer += 8;
+	pl_unpack_vec21(buffer + 12, msg->num_samples * 2, SAMPLE_SCALE, msg->smp_x, msg->smp_y, msg->smp_z);
 
-		decode_sample(buffer, msg->samples[i].gyro);
-		buffer += 8;
-	}
+	// TODO: positional tracking data and frame data
+
+	return true;
+}
+
+// the samples of a report into the ring, all of them carry the report's time stamp and magnetic field
+static void push_samples(imu_ring* ring, const unsigned char* buffer, int count, uint32_t timestamp, const int16_t* mag)
+{
+	int32_t mag32[] = { mag[0], mag[1], mag[2] };
+	vec3f mag_vec;
 
-	// Skip empty samples
-	buffer += (2 - msg->num_samples) * 16;
+	vec3f_from_rift_vec(mag32, &mag_vec);
 
-	for(int i = 0; i < 3; i++){
-		msg->mag[i] = READ16;
+	// decoded straight into the ring entries, an accelerometer and then a gyro vector per sample
+	for(int i = 0; i < count; i++){
+		imu_sample* s = imu_ring_push(ring);
+
+		pl_read_vec21(buffer + i * 16, SAMPLE_SCALE, s->accel.arr);
+		pl_read_vec21(buffer + i * 16 + 8, SAMPLE_SCALE, s->gyro.arr);
+		s->mag = mag_vec;
+		s->tick = timestamp;
+		s->seq = i;
 	}
+}
 
-	// TODO: positional tracking data and frame data
+bool decode_tracker_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size)
+{
+	pkt_tracker_sensor msg;
+
+	if(!decode_tracker_sensor_fields(&msg, buffer, size))
+		return false;
 
+	// DK1 timestamps are in milliseconds
+	push_samples(ring, buffer + 8, OHMD_MIN(msg.num_samples, 3), msg.timestamp * 1000, msg.mag);
+	return true;
+}
+
+bool decode_tracker_sensor_samples_dk2(imu_ring* ring, const unsigned char* buffer, int size)
+{
+	pkt_tracker_sensor msg;
+
+	if(!decode_tracker_sensor_dk2_fields(&msg, buffer, size))
+		return false;
+
+	push_samples(ring, buffer + 12, OHMD_MIN(msg.num_samples, 2), msg.timestamp, msg.mag);
 	return true;
 }
 
@@ -177,6 +161,41 @@ void vec3f_from_rift_vec(const int32_t* smp, vec3f* out_vec)
 	out_vec->z = (float)smp[2] * 0.0001f;
 }
 
+void vec3f_from_rift_sample(const pkt_tracker_sensor* msg, int idx, vec3f* out_vec)
+{
+	out_vec->x = msg->smp_x[idx];
+	out_vec->y = msg->smp_y[idx];
+	out_vec->z = msg->smp_z[idx];
+}
+
+/*
+ * The packet_interval for a report every interval_us microseconds, rounded to
+ * whole samples and clamped to 1 to RIFT_MAX_REPORT_INTERVAL samples per report.
+ */
+uint16_t rift_packet_interval_from_us(int interval_us)
+{
+	const int sample_us = 1000000 / RIFT_SAMPLE_RATE;
+	int interval = interval_us / sample_us + (interval_us % sample_us >= sample_us / 2);
+
+	return OHMD_MIN(OHMD_MAX(interval, 1), RIFT_MAX_REPORT_INTERVAL) - 1;
+}
+
+/*
+ * Seconds to integrate the first of count samples of a report over. The
+ * samples are one sample apart and end at the report's time stamp, the first
+ * one follows the last sample of the previous report. Without a usable time
+ * stamp difference (the first report, or an overflow) the configured report
+ * interval, packet_interval + 1 samples, is assumed to have passed.
+ */
+float rift_report_first_dt(uint16_t packet_interval, int count, uint32_t last_timestamp, uint32_t timestamp)
+{
+	// TODO: handle overflows in a nicer way
+	if(timestamp > last_timestamp)
+		return (timestamp - last_timestamp) / 1000000.0f - (count - 1) * RIFT_SAMPLE_LEN;
+
+	return OHMD_MAX(packet_interval + 1 - (count - 1), 1) * RIFT_SAMPLE_LEN;
+}
+
 int encode_sensor_config(unsigned char* buffer, const pkt_sensor_config* config)
 {
 	WRITE8(RIFT_CMD_SENSOR_CONFIG);
@@ -257,19 +276,13 @@ void dump_packet_sensor_config(const pkt_sensor_config* config)
 	LOGD("  keep alive interval: %u", config->keep_alive_interval);
 }
 
-void dump_packet_tracker_sensor(const pkt_tracker_sensor* sensor)
+void dump_tracker_sensor_sample(const imu_sample* sample)
 {
-	(void)sensor;
-
-	LOGD("tracker sensor:");
-	LOGD("  last command id: %u", sensor->last_command_id);
-	LOGD("  timestamp:       %u", sensor->timestamp);
-	LOGD("  temperature:     %d", sensor->temperature);
-	LOGD("  num samples:     %u", sensor->num_samples);
-	LOGD("  magnetic field:  %i %i %i", sensor->mag[0], sensor->mag[1], sensor->mag[2]);
-
-	for(int i = 0; i < sensor->num_samples; i++){
-		LOGD("    accel: %d %d %d", sensor->samples[i].accel[0], sensor->samples[i].accel[1], sensor->samples[i].accel[2]);
-		LOGD("    gyro:  %d %d %d", sensor->samples[i].gyro[0], sensor->samples[i].gyro[1], sensor->samples[i].gyro[2]);
-	}
+	(void)sample;
+
+	LOGD("tracker sensor sample %u:", sample->seq);
+	LOGD("  timestamp:      %u", sample->tick);
+	LOGD("  accel:          %f %f %f", sample->accel.x, sample->accel.y, sample->accel.z);
+	LOGD("  gyro:           %f %f %f", sample->gyro.x, sample->gyro.y, sample->gyro.z);
+	LOGD("  magnetic field: %f %f %f", sample->mag.x, sample->mag.y, sample->mag.z);
 }
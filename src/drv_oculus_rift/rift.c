@@ -15,8 +15,8 @@
 #include <assert.h>
 
 #include "rift.h"
+#include "../hid_reader.h"
 
-#define TICK_LEN (1.0f / 1000.0f) // 1000 Hz ticks
 #define KEEP_ALIVE_VALUE (10 * 1000)
 #define SETFLAG(_s, _flag, _val) (_s) = ((_s) & ~(_flag)) | ((_val) ? (_flag) : 0)
 
@@ -24,15 +24,15 @@ typedef struct {
 	ohmd_device base;
 
 	hid_device* handle;
+	ohmd_hid_reader reader;
 	pkt_sensor_range sensor_range;
 	pkt_sensor_display_info display_info;
 	rift_coordinate_frame coordinate_frame, hw_coordinate_frame;
 	pkt_sensor_config sensor_config;
-	pkt_tracker_sensor sensor;
+	imu_ring samples;
 	uint32_t last_imu_timestamp;
 	double last_keep_alive;
 	fusion sensor_fusion;
-	vec3f raw_mag, raw_accel, raw_gyro;
 } rift_priv;
 
 typedef enum {
@@ -65,6 +65,39 @@ static int send_feature_report(rift_priv* priv, const unsigned char *data, size_
 	return hid_send_feature_report(priv->handle, data, length);
 }
 
+static int get_report_interval(rift_priv* priv)
+{
+	return priv->sensor_config.packet_interval + 1;
+}
+
+static int set_report_interval(rift_priv* priv, int interval_us)
+{
+	if(interval_us <= 0)
+		return OHMD_S_INVALID_PARAMETER;
+
+	priv->sensor_config.packet_interval = rift_packet_interval_from_us(interval_us);
+	int interval = get_report_interval(priv);
+
+	unsigned char buf[FEATURE_BUFFER_SIZE];
+	int size = encode_sensor_config(buf, &priv->sensor_config);
+	if(send_feature_report(priv, buf, size) == -1){
+		ohmd_set_error(priv->base.ctx, "send_feature_report failed in set_report_interval");
+		return OHMD_S_UNKNOWN_ERROR;
+	}
+
+	// read back what the sensor actually uses
+	size = get_feature_report(priv, RIFT_CMD_SENSOR_CONFIG, buf);
+	if(size <= 0 || !decode_sensor_config(&priv->sensor_config, buf, size)){
+		LOGW("could not read back the report interval");
+		return OHMD_S_OK;
+	}
+
+	if(get_report_interval(priv) != interval)
+		LOGW("report interval didn't stick");
+
+	return OHMD_S_OK;
+}
+
 static void set_coordinate_frame(rift_priv* priv, rift_coordinate_frame coordframe)
 {
 	priv->coordinate_frame = coordframe;
@@ -99,40 +132,31 @@ static void set_coordinate_frame(rift_priv* priv, rift_coordinate_frame coordfra
 
 static void handle_tracker_sensor_msg(rift_priv* priv, unsigned char* buffer, int size)
 {
-	if (buffer[0] == RIFT_IRQ_SENSORS
-	  && !decode_tracker_sensor_msg(&priv->sensor, buffer, size)){
-		LOGE("couldn't decode tracker sensor message");
-	}
+	bool ok = buffer[0] == RIFT_IRQ_SENSORS_DK2
+		? decode_tracker_sensor_samples_dk2(&priv->samples, buffer, size)
+		: decode_tracker_sensor_samples(&priv->samples, buffer, size);
 
-	if (buffer[0] == RIFT_IRQ_SENSORS_DK2
-	  && !decode_tracker_sensor_msg_dk2(&priv->sensor, buffer, size)){
+	if(!ok){
 		LOGE("couldn't decode tracker sensor message");
+		return;
 	}
 
-	pkt_tracker_sensor* s = &priv->sensor;
+	int count = imu_ring_count(&priv->samples);
+	imu_sample* s = imu_ring_pop(&priv->samples);
+	if(!s)
+		return;
 
-	dump_packet_tracker_sensor(s);
+	uint32_t timestamp = s->tick;
 
-	int32_t mag32[] = { s->mag[0], s->mag[1], s->mag[2] };
-	vec3f_from_rift_vec(mag32, &priv->raw_mag);
+	float dt = rift_report_first_dt(priv->sensor_config.packet_interval, count, priv->last_imu_timestamp, timestamp);
 
-	// TODO: handle overflows in a nicer way
-	float dt = TICK_LEN; // TODO: query the Rift for the sample rate
-	if (s->timestamp > priv->last_imu_timestamp)
-	{
-		dt = (s->timestamp - priv->last_imu_timestamp) / 1000000.0f;
-		dt -= (s->num_samples - 1) * TICK_LEN; // TODO: query the Rift for the sample rate
+	for(; s; s = imu_ring_pop(&priv->samples)){
+		dump_tracker_sensor_sample(s);
+		ofusion_update(&priv->sensor_fusion, dt, &s->gyro, &s->accel, &s->mag);
+		dt = RIFT_SAMPLE_LEN;
 	}
 
-	for(int i = 0; i < s->num_samples; i++){
-		vec3f_from_rift_vec(s->samples[i].accel, &priv->raw_accel);
-		vec3f_from_rift_vec(s->samples[i].gyro, &priv->raw_gyro);
-
-		ofusion_update(&priv->sensor_fusion, dt, &priv->raw_gyro, &priv->raw_accel, &priv->raw_mag);
-		dt = TICK_LEN; // TODO: query the Rift for the sample rate
-	}
-
-	priv->last_imu_timestamp = s->timestamp;
+	priv->last_imu_timestamp = timestamp;
 }
 
 static void update_device(ohmd_device* device)
@@ -155,7 +179,7 @@ static void update_device(ohmd_device* device)
 
 	// Read all the messages from the device.
 	while(true){
-		int size = hid_read(priv->handle, buffer, FEATURE_BUFFER_SIZE);
+		int size = ohmd_hid_reader_read(&priv->reader, buffer, FEATURE_BUFFER_SIZE);
 		if(size < 0){
 			LOGE("error reading from device");
 			return;
@@ -193,6 +217,10 @@ static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 		out[0] = out[1] = out[2] = 0;
 		break;
 
+	case OHMD_MAG_CORRECTION_GAIN:
+		*out = ofusion_get_mag_gain(&priv->sensor_fusion);
+		break;
+
 	default:
 		ohmd_set_error(priv->base.ctx, "invalid type given to getf (%ud)", type);
 		return -1;
@@ -202,10 +230,54 @@ static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 	return 0;
 }
 
+static int setf(ohmd_device* device, ohmd_float_value type, const float* in)
+{
+	rift_priv* priv = rift_priv_get(device);
+
+	switch(type){
+	case OHMD_MAG_CORRECTION_GAIN:
+		return ofusion_set_mag_gain(&priv->sensor_fusion, *in) == 0 ? OHMD_S_OK : OHMD_S_INVALID_PARAMETER;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
+static int geti(ohmd_device* device, ohmd_int_value type, int* out)
+{
+	rift_priv* priv = rift_priv_get(device);
+
+	switch(type){
+	case OHMD_SENSOR_REPORT_INTERVAL:
+		*out = get_report_interval(priv) * (1000000 / RIFT_SAMPLE_RATE);
+		return OHMD_S_OK;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
+static int seti(ohmd_device* device, ohmd_int_value type, const int* in)
+{
+	rift_priv* priv = rift_priv_get(device);
+
+	switch(type){
+	case OHMD_FUSION_ALGORITHM:
+		return ofusion_set_algorithm(&priv->sensor_fusion, in[0]) == 0 ? OHMD_S_OK : OHMD_S_INVALID_PARAMETER;
+
+	case OHMD_SENSOR_REPORT_INTERVAL:
+		return set_report_interval(priv, in[0]);
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
 static void close_device(ohmd_device* device)
 {
 	LOGD("closing device");
 	rift_priv* priv = rift_priv_get(device);
+	ohmd_hid_reader_close(&priv->reader);
 	hid_close(priv->handle);
 	free(priv);
 }
@@ -340,25 +412,26 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 
 	// calculate projection eye projection matrices from the device properties
 	//ohmd_calc_default_proj_matrices(&priv->base.properties);
-	float l,r,t,b,n,f;
+	float l,r,t,b,n;
 	// left eye screen bounds
 	l = -1.0f * (priv->display_info.h_screen_size/2 - priv->display_info.lens_separation/2);
 	r = priv->display_info.lens_separation/2;
 	t = priv->display_info.v_screen_size - priv->display_info.v_center;
 	b = -1.0f * priv->display_info.v_center;
 	n = priv->display_info.eye_to_screen_distance[0];
-	f = n*10e6;
-	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f, f: %0.3f", l,r,b,t,n,f);
+	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f", l,r,b,t,n);
 	/* eye separation is handled by IPD in the Modelview matrix */
-	omat4x4f_init_frustum(&priv->base.properties.proj_left, l, r, b, t, n, f);
+	ohmd_set_proj_tangents(&priv->base.properties, 0, l / n, r / n, b / n, t / n);
 	//right eye screen bounds
 	l = -1.0f * priv->display_info.lens_separation/2;
 	r = priv->display_info.h_screen_size/2 - priv->display_info.lens_separation/2;
 	n = priv->display_info.eye_to_screen_distance[1];
-	f = n*10e6;
-	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f, f: %0.3f", l,r,b,t,n,f);
+	//LOGD("l: %0.3f, r: %0.3f, b: %0.3f, t: %0.3f, n: %0.3f", l,r,b,t,n);
 	/* eye separation is handled by IPD in the Modelview matrix */
-	omat4x4f_init_frustum(&priv->base.properties.proj_right, l, r, b, t, n, f);
+	ohmd_set_proj_tangents(&priv->base.properties, 1, l / n, r / n, b / n, t / n);
+
+	// the planes come from OHMD_PROJECTION_ZNEAR and ZFAR
+	ohmd_calc_proj_matrices(&priv->base.properties);
 
 	priv->base.properties.fov = 2 * atan2f(
 			priv->display_info.h_screen_size/2 - priv->display_info.lens_separation/2,
@@ -368,10 +441,22 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	priv->base.update = update_device;
 	priv->base.close = close_device;
 	priv->base.getf = getf;
+	priv->base.setf = setf;
+	priv->base.geti = geti;
+	priv->base.seti = seti;
 
 	// initialize sensor fusion
 	ofusion_init(&priv->sensor_fusion);
 
+	// the Rift has a magnetometer, but its readings aren't hard or soft iron calibrated yet and an offset
+	// would pull the yaw off, so the correction stays off until it's turned on with OHMD_MAG_CORRECTION_GAIN
+
+	// the IMU reports at 1000 Hz, fuse pre-integrated windows of 4 samples
+	priv->sensor_fusion.fuse_interval = 4;
+
+	// read the sensor reports from the hidraw node when there is one
+	ohmd_hid_reader_init(&priv->reader, &priv->base, priv->handle, desc->path);
+
 	return &priv->base;
 
 cleanup:
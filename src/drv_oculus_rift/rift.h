@@ -14,6 +14,12 @@
 
 #define FEATURE_BUFFER_SIZE 256
 
+// the IMU always samples at 1 kHz, the sensor config only sets how many
+// samples pass between two reports, packet_interval + 1
+#define RIFT_SAMPLE_RATE 1000
+#define RIFT_SAMPLE_LEN (1.0f / RIFT_SAMPLE_RATE)
+#define RIFT_MAX_REPORT_INTERVAL 256
+
 typedef enum {
 	RIFT_CMD_SENSOR_CONFIG = 2,
 	RIFT_CMD_RANGE = 4,
@@ -56,17 +62,17 @@ typedef struct {
 	uint16_t mag_scale;
 } pkt_sensor_range;
 
-typedef struct {
-	int32_t accel[3];
-	int32_t gyro[3];
-} pkt_tracker_sample;
+// an accelerometer and a gyro vector for each of up to 3 samples, padded to a multiple of 4
+#define RIFT_SAMPLE_VECTORS 8
 
 typedef struct {
 	uint8_t num_samples;
 	uint32_t timestamp;
 	uint16_t last_command_id;
 	int16_t temperature;
-	pkt_tracker_sample samples[3];
+	// sample vectors in m/s^2 and rad/s as a structure of arrays, vector
+	// 2 * i is the accelerometer and 2 * i + 1 the gyro of sample i
+	float smp_x[RIFT_SAMPLE_VECTORS], smp_y[RIFT_SAMPLE_VECTORS], smp_z[RIFT_SAMPLE_VECTORS];
 	int16_t mag[3];
 } pkt_tracker_sensor;
 
@@ -101,7 +107,15 @@ bool decode_sensor_config(pkt_sensor_config* config, const unsigned char* buffer
 bool decode_tracker_sensor_msg(pkt_tracker_sensor* msg, const unsigned char* buffer, int size);
 bool decode_tracker_sensor_msg_dk2(pkt_tracker_sensor* msg, const unsigned char* buffer, int size);
 
+// the samples of a tracker sensor report, straight into the ring without the packet struct
+bool decode_tracker_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size);
+bool decode_tracker_sensor_samples_dk2(imu_ring* ring, const unsigned char* buffer, int size);
+
 void vec3f_from_rift_vec(const int32_t* smp, vec3f* out_vec);
+void vec3f_from_rift_sample(const pkt_tracker_sensor* msg, int idx, vec3f* out_vec);
+
+uint16_t rift_packet_interval_from_us(int interval_us);
+float rift_report_first_dt(uint16_t packet_interval, int count, uint32_t last_timestamp, uint32_t timestamp);
 
 int encode_sensor_config(unsigned char* buffer, const pkt_sensor_config* config);
 int encode_keep_alive(unsigned char* buffer, const pkt_keep_alive* keep_alive);
@@ -110,6 +124,6 @@ int encode_enable_components(unsigned char* buffer, bool display, bool audio);
 void dump_packet_sensor_range(const pkt_sensor_range* range);
 void dump_packet_sensor_config(const pkt_sensor_config* config);
 void dump_packet_sensor_display_info(const pkt_sensor_display_info* info);
-void dump_packet_tracker_sensor(const pkt_tracker_sensor* sensor);
+void dump_tracker_sensor_sample(const imu_sample* sample);
 
 #endif
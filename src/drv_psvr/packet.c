@@ -1,53 +1,74 @@
 #include "psvr.h"
 
-#ifdef _MSC_VER
-#define inline __inline
-#endif
+#include "../packet_layout.h"
 
-inline static uint8_t read8(const unsigned char** buffer)
-{
-	uint8_t ret = **buffer;
-	*buffer += 1;
-	return ret;
-}
+#define PSVR_SENSOR_SIZE 64
+#define PSVR_SMP_OFFSET(_i) (16 + 16 * (_i))
+#define PSVR_SMP_TICK 0
+#define PSVR_SMP_GYRO 4
+#define PSVR_SMP_ACCEL 10
+
+#define PSVR_SAMPLE_LAYOUT(F, _i) \
+	F(samples[_i].tick, PSVR_SMP_OFFSET(_i) + PSVR_SMP_TICK, u32) \
+	PL_VEC3(F, samples[_i].gyro, PSVR_SMP_OFFSET(_i) + PSVR_SMP_GYRO, s16) \
+	PL_VEC3(F, samples[_i].accel, PSVR_SMP_OFFSET(_i) + PSVR_SMP_ACCEL, s16)
 
-inline static int16_t read16(const unsigned char** buffer)
+#define PSVR_SENSOR_LAYOUT(F) \
+	F(samples[0].volume, 2, u16) \
+	PSVR_SAMPLE_LAYOUT(F, 0) \
+	PSVR_SAMPLE_LAYOUT(F, 1) \
+	F(samples[0].proximity, 55, u8) /* 255 for close */ \
+	F(samples[0].proximity_state, 56, u8) /* 0 (nothing) to 3 (headset is on) */
+
+// the bytes in between are unknown
+PL_DECODER(psvr_decode_sensor_packet, psvr_sensor_packet, PSVR_SENSOR_LAYOUT, PSVR_SENSOR_SIZE, PSVR_SENSOR_SIZE)
+
+void vec3f_from_psvr_vec(const int16_t* smp, vec3f* out_vec)
 {
-	int16_t ret = **buffer | (*(*buffer + 1) << 8);
-	*buffer += 2;
-	return ret;
+	out_vec->x = (float)smp[1] * 0.001f;
+	out_vec->y = (float)smp[0] * 0.001f;
+	out_vec->z = (float)smp[2] * 0.001f * -1.0f;
 }
 
-inline static uint32_t read32(const unsigned char** buffer)
+static inline void vec3f_from_psvr_buffer(const unsigned char* p, vec3f* out_vec)
 {
-	uint32_t ret = **buffer | (*(*buffer + 1) << 8) | (*(*buffer + 2) << 16) | (*(*buffer + 3) << 24);
-	*buffer += 4;
-	return ret;
+	int16_t smp[3] = { pl_read_s16(p), pl_read_s16(p + 2), pl_read_s16(p + 4) };
+	vec3f_from_psvr_vec(smp, out_vec);
 }
 
-bool psvr_decode_sensor_packet(psvr_sensor_packet* pkt, const unsigned char* buffer, int size)
+bool psvr_decode_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size)
 {
-	if(size != 64){
-		LOGE("invalid psvr sensor packet size (expected 64 but got %d)", size);
+	if(size != PSVR_SENSOR_SIZE){
+		LOGE("invalid psvr sensor report size (expected %d but got %d)", PSVR_SENSOR_SIZE, size);
 		return false;
 	}
 
-	buffer += 2; //skip 2
-	pkt->samples[0].volume = read16(&buffer); //volume
-	buffer += 12; //unknown, skip 12
-	pkt->samples[0].tick = read32(&buffer); //TICK
-	// acceleration
-	for(int i = 0; i < 3; i++){
-		pkt->samples[0].gyro[i] = read16(&buffer);
-	}
+	for(int i = 0; i < PSVR_SAMPLES; i++){
+		const unsigned char* p = buffer + PSVR_SMP_OFFSET(i);
+		imu_sample* s = imu_ring_push(ring);
 
-	// rotation
-	for(int i = 0; i < 3; i++){
-		pkt->samples[0].accel[i] = read16(&buffer);
-	}//34
-	buffer += 23; //probably other sample somewhere
-	pkt->samples[0].proximity = read8(&buffer); //255 for close
-	pkt->samples[0].proximity_state = read8(&buffer); // 0 (nothing) to 3 (headset is on)
+		vec3f_from_psvr_buffer(p + PSVR_SMP_ACCEL, &s->accel);
+		vec3f_from_psvr_buffer(p + PSVR_SMP_GYRO, &s->gyro);
+		s->mag.x = s->mag.y = s->mag.z = 0;
+		s->tick = pl_read_u32(p + PSVR_SMP_TICK);
+		s->seq = 0;
+	}
 
 	return true;
 }
+
+/*
+ * Ticks to integrate a sample over, from the previous sample's tick, 0 to
+ * skip it. On the first report (no previous tick yet), for a repeated tick
+ * and after a long gap, the spacing of the two samples within the report
+ * stands in, if that is usable itself.
+ */
+uint32_t psvr_sample_tick_delta(uint32_t last_tick, uint32_t tick, uint32_t report_spacing)
+{
+	uint32_t tick_delta = tick - last_tick;
+
+	if(last_tick == 0 || tick_delta == 0 || tick_delta > PSVR_MAX_TICK_DELTA)
+		tick_delta = report_spacing;
+
+	return tick_delta <= PSVR_MAX_TICK_DELTA ? tick_delta : 0;
+}
@@ -9,7 +9,7 @@
 
 #define FEATURE_BUFFER_SIZE 256
 
-#define TICK_LEN (1.0f / 1000000.0f) // 1000 Hz ticks
+#define TICK_LEN (1.0f / 1000000.0f) // 1 MHz ticks
 
 #define SONY_ID                  0x054c
 #define PSVR_HMD                 0x09af
@@ -23,52 +23,40 @@
 #include <stdbool.h>
 
 #include "psvr.h"
+#include "../hid_reader.h"
 
 typedef struct {
 	ohmd_device base;
 
 	hid_device* hmd_handle;
+	ohmd_hid_reader hmd_reader;
 	hid_device* hmd_control;
 	fusion sensor_fusion;
-	vec3f raw_accel, raw_gyro;
+	imu_ring samples;
 	uint32_t last_ticks;
 	uint8_t last_seq;
-	psvr_sensor_packet sensor;
 
 } psvr_priv;
 
-void vec3f_from_psvr_vec(const int16_t* smp, vec3f* out_vec)
-{
-	out_vec->x = (float)smp[1] * 0.001f;
-	out_vec->y = (float)smp[0] * 0.001f;
-	out_vec->z = (float)smp[2] * 0.001f * -1.0f;
-}
-
 static void handle_tracker_sensor_msg(psvr_priv* priv, unsigned char* buffer, int size)
 {
-	uint32_t last_sample_tick = priv->sensor.tick;
-
-	if(!psvr_decode_sensor_packet(&priv->sensor, buffer, size)){
+	if(!psvr_decode_sensor_samples(&priv->samples, buffer, size)){
 		LOGE("couldn't decode tracker sensor message");
+		return;
 	}
 
-	psvr_sensor_packet* s = &priv->sensor;
+	imu_sample* s[PSVR_SAMPLES];
+	for(int i = 0; i < PSVR_SAMPLES; i++)
+		s[i] = imu_ring_pop(&priv->samples);
 
-	uint32_t tick_delta = 1000;
-	if(last_sample_tick > 0) //startup correction
-		tick_delta = s->tick - last_sample_tick;
+	// both samples of the report are used, each integrated over the time since the one before it
+	for(int i = 0; i < PSVR_SAMPLES; i++){
+		uint32_t tick_delta = psvr_sample_tick_delta(priv->last_ticks, s[i]->tick, s[1]->tick - s[0]->tick);
 
-	float dt = tick_delta * TICK_LEN;
-	vec3f mag = {{0.0f, 0.0f, 0.0f}};
+		if(tick_delta > 0)
+			ofusion_update(&priv->sensor_fusion, tick_delta * TICK_LEN, &s[i]->gyro, &s[i]->accel, &s[i]->mag);
 
-	for(int i = 0; i < 1; i++){ //just use 1 sample since we don't have sample order for 	 frame
-		vec3f_from_psvr_vec(s->samples[i].accel, &priv->raw_accel);
-		vec3f_from_psvr_vec(s->samples[i].gyro, &priv->raw_gyro);
-
-		ofusion_update(&priv->sensor_fusion, dt, &priv->raw_gyro, &priv->raw_accel, &mag);
-
-		// reset dt to tick_len for the last samples if there were more than one sample
-		dt = TICK_LEN;
+		priv->last_ticks = s[i]->tick;
 	}
 }
 
@@ -80,7 +68,7 @@ static void update_device(ohmd_device* device)
 	unsigned char buffer[FEATURE_BUFFER_SIZE];
 
 	while(true){
-		int size = hid_read(priv->hmd_handle, buffer, FEATURE_BUFFER_SIZE);
+		int size = ohmd_hid_reader_read(&priv->hmd_reader, buffer, FEATURE_BUFFER_SIZE);
 		if(size < 0){
 			LOGE("error reading from device");
 			return;
@@ -134,19 +122,34 @@ static int getf(ohmd_device* device, ohmd_float_value type, float* out)
 	return 0;
 }
 
+static int seti(ohmd_device* device, ohmd_int_value type, const int* in)
+{
+	psvr_priv* priv = (psvr_priv*)device;
+
+	switch(type){
+	case OHMD_FUSION_ALGORITHM:
+		return ofusion_set_algorithm(&priv->sensor_fusion, in[0]) == 0 ? OHMD_S_OK : OHMD_S_INVALID_PARAMETER;
+
+	default:
+		return OHMD_S_UNSUPPORTED;
+	}
+}
+
 static void close_device(ohmd_device* device)
 {
 	psvr_priv* priv = (psvr_priv*)device;
 
 	LOGD("closing HTC PSVR device");
 
+	ohmd_hid_reader_close(&priv->hmd_reader);
 	hid_close(priv->hmd_handle);
 	hid_close(priv->hmd_control);
 
 	free(device);
 }
 
-static hid_device* open_device_idx(int manufacturer, int product, int iface, int iface_tot, int device_index)
+// path receives the opened device's path, OHMD_STR_SIZE bytes
+static hid_device* open_device_idx(int manufacturer, int product, int iface, int iface_tot, int device_index, char* path)
 {
 	struct hid_device_info* devs = hid_enumerate(manufacturer, product);
 	struct hid_device_info* cur_dev = devs;
@@ -160,6 +163,8 @@ static hid_device* open_device_idx(int manufacturer, int product, int iface, int
 
 		if(findEndPoint(cur_dev->path, device_index) > 0 && iface == iface_cur){
 			ret = hid_open_path(cur_dev->path);
+			strncpy(path, cur_dev->path, OHMD_STR_SIZE - 1);
+			path[OHMD_STR_SIZE - 1] = '\0';
 			printf("opening\n");
 		}
 
@@ -188,9 +193,10 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	priv->base.ctx = driver->ctx;
 
 	int idx = atoi(desc->path);
+	char hmd_path[OHMD_STR_SIZE], control_path[OHMD_STR_SIZE];
 
 	// Open the HMD device
-	priv->hmd_handle = open_device_idx(SONY_ID, PSVR_HMD, 0, 0, 4);
+	priv->hmd_handle = open_device_idx(SONY_ID, PSVR_HMD, 0, 0, 4, hmd_path);
 
 	if(!priv->hmd_handle)
 		goto cleanup;
@@ -201,7 +207,7 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	}
 
 	// Open the HMD Control device
-	priv->hmd_control = open_device_idx(SONY_ID, PSVR_HMD, 0, 0, 5);
+	priv->hmd_control = open_device_idx(SONY_ID, PSVR_HMD, 0, 0, 5, control_path);
 
 	if(!priv->hmd_control)
 		goto cleanup;
@@ -237,9 +243,13 @@ static ohmd_device* open_device(ohmd_driver* driver, ohmd_device_desc* desc)
 	priv->base.update = update_device;
 	priv->base.close = close_device;
 	priv->base.getf = getf;
+	priv->base.seti = seti;
 
 	ofusion_init(&priv->sensor_fusion);
 
+	// the sensor reports come on the HMD interface
+	ohmd_hid_reader_init(&priv->hmd_reader, &priv->base, priv->hmd_handle, hmd_path);
+
 	return (ohmd_device*)priv;
 
 cleanup:
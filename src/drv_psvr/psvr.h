@@ -25,11 +25,16 @@ typedef struct
 	uint8_t proximity_state;
 } psvr_sensor_sample;
 
+// a sensor report carries two IMU samples, each with its own time stamp
+#define PSVR_SAMPLES 2
+
+// longer gaps between samples are not trusted for integration
+#define PSVR_MAX_TICK_DELTA 100000 // 100 ms, in 1 MHz ticks
+
 typedef struct
 {
 	uint8_t report_id;
-	uint32_t tick;
-	psvr_sensor_sample samples[1];
+	psvr_sensor_sample samples[PSVR_SAMPLES];
 } psvr_sensor_packet;
 
 static const unsigned char psvr_vrmode_on[8]  = {
@@ -48,5 +53,7 @@ static const unsigned char psvr_power_on[8]  = {
 
 void vec3f_from_psvr_vec(const int16_t* smp, vec3f* out_vec);
 bool psvr_decode_sensor_packet(psvr_sensor_packet* pkt, const unsigned char* buffer, int size);
+bool psvr_decode_sensor_samples(imu_ring* ring, const unsigned char* buffer, int size);
+uint32_t psvr_sample_tick_delta(uint32_t last_tick, uint32_t tick, uint32_t report_spacing);
 
 #endif
@@ -14,49 +14,241 @@ void ofusion_init(fusion* me)
 {
 	memset(me, 0, sizeof(fusion));
 	me->orient.w = 1.0f;
+	me->orient_d.w = 1.0;
 
 	ofq_init(&me->mag_fq, 20);
 	ofq_init(&me->accel_fq, 20);
 	ofq_init(&me->ang_vel_fq, 20);
 
 	me->flags = FF_USE_GRAVITY;
+#ifdef OHMD_FUSION_DOUBLE
+	me->flags |= FF_DOUBLE_PRECISION;
+#endif
 	me->grav_gain = 0.05f;
+	me->gyro_bias_gain = 0.0005f;
+	me->mag_interval = 10;
+	me->mag_gain = 0.01f;
+	me->fuse_interval = 1;
+
+	me->algorithm = OHMD_FUSION_COMPLEMENTARY;
+	ofusion_madgwick_init(&me->madgwick);
+	ofusion_mahony_init(&me->mahony);
 }
 
-void ofusion_update(fusion* me, float dt, const vec3f* ang_vel, const vec3f* accel, const vec3f* mag)
+int ofusion_set_algorithm(fusion* me, int algorithm)
 {
-	me->ang_vel = *ang_vel;
-	me->accel = *accel;
-	me->raw_mag = *mag;
+	switch(algorithm){
+	case OHMD_FUSION_COMPLEMENTARY:
+	case OHMD_FUSION_MADGWICK:
+	case OHMD_FUSION_MAHONY:
+		break;
 
-	me->mag = *mag;
+	default:
+		return -1;
+	}
 
-	vec3f world_accel;
-	oquatf_get_rotated(&me->orient, accel, &world_accel);
+	// the orientation carries over, state specific to the previous algorithm doesn't
+	me->algorithm = algorithm;
+	me->grav_error_angle = 0;
+	me->device_level_count = 0;
+	me->mahony.integral_error.x = me->mahony.integral_error.y = me->mahony.integral_error.z = 0;
 
-	me->iterations += 1;
-	me->time += dt;
+	return 0;
+}
 
-	ofq_add(&me->mag_fq, mag);
-	ofq_add(&me->accel_fq, &world_accel);
-	ofq_add(&me->ang_vel_fq, ang_vel);
+int ofusion_set_mag_gain(fusion* me, float gain)
+{
+	// a gain of 1 takes out the whole yaw error at once, more would overshoot
+	if(!(gain >= 0 && gain <= 1.0f))
+		return -1;
+
+	if(gain > 0){
+		me->mag_gain = gain;
+		me->flags |= FF_USE_MAG;
+	}else{
+		me->flags &= ~FF_USE_MAG;
+	}
+
+	return 0;
+}
+
+float ofusion_get_mag_gain(const fusion* me)
+{
+	return (me->flags & FF_USE_MAG) ? me->mag_gain : 0;
+}
+
+// gravity direction in sensor space as predicted by the orientation, the transposed second row of its rotation
+static void get_predicted_up(const quatf* q, vec3f* out)
+{
+	out->x = 2.0f * (q->x * q->y + q->w * q->z);
+	out->y = 1.0f - 2.0f * (q->x * q->x + q->z * q->z);
+	out->z = 2.0f * (q->y * q->z - q->w * q->x);
+}
+
+void ofusion_madgwick_init(fusion_madgwick* me)
+{
+	me->beta = 0.05f;
+}
+
+void ofusion_madgwick_update(fusion_madgwick* me, quatf* orient, float dt, const vec3f* ang_vel, const vec3f* accel)
+{
+	quatf* q = orient;
+
+	// rate of change from the gyro, q' = q * (ang_vel, 0) / 2
+	quatf rate = {{
+		0.5f * ( q->w * ang_vel->x + q->y * ang_vel->z - q->z * ang_vel->y),
+		0.5f * ( q->w * ang_vel->y + q->z * ang_vel->x - q->x * ang_vel->z),
+		0.5f * ( q->w * ang_vel->z + q->x * ang_vel->y - q->y * ang_vel->x),
+		0.5f * (-q->x * ang_vel->x - q->y * ang_vel->y - q->z * ang_vel->z)
+	}};
+
+	float accel_length = ovec3f_get_length(accel);
+
+	if(accel_length > 0.0001f){
+		// objective function, predicted minus measured gravity direction
+		vec3f up;
+		get_predicted_up(q, &up);
+
+		float f1 = up.x - accel->x / accel_length;
+		float f2 = up.y - accel->y / accel_length;
+		float f3 = up.z - accel->z / accel_length;
+
+		// gradient of the objective, J^T * f
+		quatf step = {{
+			2.0f * q->y * f1 - 4.0f * q->x * f2 - 2.0f * q->w * f3,
+			2.0f * q->x * f1 + 2.0f * q->z * f3,
+			2.0f * q->w * f1 - 4.0f * q->z * f2 + 2.0f * q->y * f3,
+			2.0f * q->z * f1 - 2.0f * q->x * f3
+		}};
 
-	float ang_vel_length = ovec3f_get_length(ang_vel);
+		float step_length = oquatf_get_length(&step);
 
-	if(ang_vel_length > 0.0001f){
-		vec3f rot_axis =
-			{{ ang_vel->x / ang_vel_length, ang_vel->y / ang_vel_length, ang_vel->z / ang_vel_length }};
+		if(step_length > 0.0001f){
+			for(int i = 0; i < 4; i++)
+				rate.arr[i] -= me->beta * step.arr[i] / step_length;
+		}
+	}
+
+	for(int i = 0; i < 4; i++)
+		q->arr[i] += rate.arr[i] * dt;
+
+	oquatf_normalize_me(q);
+}
+
+void ofusion_mahony_init(fusion_mahony* me)
+{
+	me->kp = 0.5f;
+	me->ki = 0.01f;
+	me->integral_error.x = me->integral_error.y = me->integral_error.z = 0;
+}
+
+void ofusion_mahony_update(fusion_mahony* me, quatf* orient, float dt, const vec3f* ang_vel, const vec3f* accel)
+{
+	vec3f omega = *ang_vel;
+	float accel_length = ovec3f_get_length(accel);
+
+	if(accel_length > 0.0001f){
+		vec3f up;
+		get_predicted_up(orient, &up);
+
+		// error is the rotation between measured and predicted gravity, feed it back into the gyro
+		vec3f a = {{ accel->x / accel_length, accel->y / accel_length, accel->z / accel_length }};
+		vec3f error = {{
+			a.y * up.z - a.z * up.y,
+			a.z * up.x - a.x * up.z,
+			a.x * up.y - a.y * up.x
+		}};
 
-		float rot_angle = ang_vel_length * dt;
+		for(int i = 0; i < 3; i++){
+			me->integral_error.arr[i] += me->ki * error.arr[i] * dt;
+			omega.arr[i] += me->kp * error.arr[i] + me->integral_error.arr[i];
+		}
+	}
 
-		quatf delta_orient;
-		oquatf_init_axis(&delta_orient, &rot_axis, rot_angle);
+	vec3f rot_vec = {{ omega.x * dt, omega.y * dt, omega.z * dt }};
 
-		oquatf_mult_me(&me->orient, &delta_orient);
+	quatf delta_orient;
+	oquatf_init_rotation_vector(&delta_orient, &rot_vec);
+	oquatf_mult_me(orient, &delta_orient);
+
+	oquatf_normalize_me(orient);
+}
+
+/*
+ * Orientation updates for the complementary filter and the magnetometer correction. With
+ * FF_DOUBLE_PRECISION they're applied to orient_d, which orient is then rounded from, so
+ * rounding errors don't build up over long sessions. When orient was changed from the outside,
+ * or by the Madgwick or Mahony filter, orient_d picks up that value first.
+ */
+
+static void sync_orient_d(fusion* me)
+{
+	quatf q;
+	oquatd_get_quatf(&me->orient_d, &q);
+
+	if(memcmp(&q, &me->orient, sizeof(quatf)) != 0)
+		oquatd_from_quatf(&me->orient_d, &me->orient);
+}
+
+// orient = orient * delta, delta being the rotation of rot_vec in the body frame
+static void rotate_body(fusion* me, const vec3f* rot_vec)
+{
+	if(me->flags & FF_DOUBLE_PRECISION){
+		vec3d rot_vec_d;
+		quatd delta;
+
+		sync_orient_d(me);
+		ovec3d_from_vec3f(&rot_vec_d, rot_vec);
+		oquatd_init_rotation_vector(&delta, &rot_vec_d);
+		oquatd_mult_me(&me->orient_d, &delta);
+		oquatd_get_quatf(&me->orient_d, &me->orient);
+	}else{
+		quatf delta;
+		oquatf_init_rotation_vector(&delta, rot_vec);
+		oquatf_mult_me(&me->orient, &delta);
+	}
+}
+
+// orient = corr * orient, corr being a rotation by angle around axis in the world frame
+static void rotate_world(fusion* me, const vec3f* axis, float angle)
+{
+	if(me->flags & FF_DOUBLE_PRECISION){
+		vec3d axis_d;
+		quatd corr, old_orient;
+
+		sync_orient_d(me);
+		ovec3d_from_vec3f(&axis_d, axis);
+		oquatd_init_axis(&corr, &axis_d, angle);
+		old_orient = me->orient_d;
+		oquatd_mult(&corr, &old_orient, &me->orient_d);
+		oquatd_get_quatf(&me->orient_d, &me->orient);
+	}else{
+		quatf corr, old_orient;
+		oquatf_init_axis(&corr, axis, angle);
+		old_orient = me->orient;
+		oquatf_mult(&corr, &old_orient, &me->orient);
+	}
+}
+
+static void normalize_orient(fusion* me)
+{
+	if(me->flags & FF_DOUBLE_PRECISION){
+		sync_orient_d(me);
+		oquatd_normalize_me(&me->orient_d);
+		oquatd_get_quatf(&me->orient_d, &me->orient);
+	}else{
+		oquatf_normalize_me(&me->orient);
 	}
+}
+
+// the original filter, gyro integration with periodic tilt correction from averaged gravity
+static void complementary_update(fusion* me, float dt, int samples, const vec3f* rot_vec, const vec3f* accel)
+{
+	rotate_body(me, rot_vec);
 
 	// gravity correction
 	if(me->flags & FF_USE_GRAVITY){
+		float ang_vel_length = ovec3f_get_length(rot_vec) / dt;
 		const float gravity_tolerance = .4f, ang_vel_tolerance = .1f;
 		const float min_tilt_error = 0.05f, max_tilt_error = 0.01f;
 
@@ -65,7 +257,7 @@ void ofusion_update(fusion* me, float dt, const vec3f* ang_vel, const vec3f* acc
 
 		me->device_level_count =
 			fabsf(ovec3f_get_length(accel) - 9.82f) < gravity_tolerance * 2.0f && ang_vel_length < ang_vel_tolerance
-			? me->device_level_count + 1 : 0;
+			? me->device_level_count + samples : 0;
 
 		// device has been level for long enough, grab mean from the accelerometer filter queue (last n values)
 		// and use for correction
@@ -107,20 +299,188 @@ void ofusion_update(fusion* me, float dt, const vec3f* ang_vel, const vec3f* acc
 
 			// otherwise try to correct
 			else {
-				use_angle = -me->grav_gain * me->grav_error_angle * 0.005f * (5.0f * ang_vel_length + 1.0f);
+				use_angle = -me->grav_gain * me->grav_error_angle * 0.005f * (5.0f * ang_vel_length + 1.0f) * samples;
 				me->grav_error_angle += use_angle;
 			}
 
 			// perform the correction
-			quatf corr_quat, old_orient;
-			oquatf_init_axis(&corr_quat, &me->grav_error_axis, use_angle);
-			old_orient = me->orient;
+			rotate_world(me, &me->grav_error_axis, use_angle);
+		}
+	}
+}
+
+void ofusion_update(fusion* me, float dt, const vec3f* ang_vel, const vec3f* accel, const vec3f* mag)
+{
+	vec3f delta = {{ ang_vel->x * dt, ang_vel->y * dt, ang_vel->z * dt }};
+
+	if(me->fuse_interval <= 1){
+		ofusion_update_delta(me, dt, 1, &delta, accel, mag);
+		return;
+	}
+
+	// pre-integrate the window, summing the rotation vectors alone misses the rotation
+	// caused by the axis itself moving within the window (coning), which the cross
+	// product term of the exponential map composition adds back
+	vec3f* alpha = &me->window_rot;
+	me->window_coning.x += 0.5f * (alpha->y * delta.z - alpha->z * delta.y);
+	me->window_coning.y += 0.5f * (alpha->z * delta.x - alpha->x * delta.z);
+	me->window_coning.z += 0.5f * (alpha->x * delta.y - alpha->y * delta.x);
+
+	for(int i = 0; i < 3; i++){
+		alpha->arr[i] += delta.arr[i];
+		me->window_accel.arr[i] += accel->arr[i];
+	}
+
+	me->window_dt += dt;
+	me->window_count++;
+
+	if(me->window_count >= me->fuse_interval){
+		vec3f rot_vec, accel_mean;
+
+		for(int i = 0; i < 3; i++){
+			rot_vec.arr[i] = me->window_rot.arr[i] + me->window_coning.arr[i];
+			accel_mean.arr[i] = me->window_accel.arr[i] / me->window_count;
+		}
+
+		ofusion_update_delta(me, me->window_dt, me->window_count, &rot_vec, &accel_mean, mag);
+
+		me->window_count = 0;
+		me->window_dt = 0;
+		memset(&me->window_rot, 0, sizeof(vec3f));
+		memset(&me->window_coning, 0, sizeof(vec3f));
+		memset(&me->window_accel, 0, sizeof(vec3f));
+	}
+}
+
+void ofusion_update_delta(fusion* me, float dt, int samples, const vec3f* rot_vec, const vec3f* accel, const vec3f* mag)
+{
+	if(dt <= 0)
+		return;
+
+	// mean angular velocity over the delta, used where the filters need a rate
+	vec3f mean_ang_vel = {{ rot_vec->x / dt, rot_vec->y / dt, rot_vec->z / dt }};
+	const vec3f* ang_vel = &mean_ang_vel;
+
+	me->accel = *accel;
+	me->raw_mag = *mag;
+
+	me->mag = *mag;
+
+	vec3f world_accel;
+	oquatf_get_rotated(&me->orient, accel, &world_accel);
+
+	int prev_iterations = me->iterations;
+	me->iterations += samples;
+	me->time += dt;
 
-			oquatf_mult(&corr_quat, &old_orient, &me->orient);
+	ofq_add(&me->mag_fq, mag);
+	ofq_add(&me->accel_fq, &world_accel);
+	ofq_add(&me->ang_vel_fq, ang_vel);
+
+	me->ang_vel = *ang_vel;
+
+	// gyro bias estimation
+	if(me->flags & FF_USE_GYRO_BIAS){
+		const float gravity_tolerance = .4f, gyro_noise_tolerance = .05f;
+		const float max_bias = .2f, bias_tracking_tolerance = .02f;
+
+		vec3f ang_vel_mean, ang_vel_dev, bias_dev;
+		ofq_get_mean(&me->ang_vel_fq, &ang_vel_mean);
+		ovec3f_subtract(ang_vel, &ang_vel_mean, &ang_vel_dev);
+		ovec3f_subtract(&ang_vel_mean, &me->gyro_bias, &bias_dev);
+
+		// the device is considered still if the accelerometer only sees gravity and the gyro
+		// is steady at a value a bias could explain, once the estimate has settled it may
+		// only move slowly, so a slow steady turn isn't mistaken for bias
+
+		float bias_limit = me->gyro_bias_samples * me->gyro_bias_gain < 1.0f ? max_bias : bias_tracking_tolerance;
+
+		// the count only has to reach the queue size, it saturates just past it
+		me->device_still_count =
+			fabsf(ovec3f_get_length(accel) - 9.82f) < gravity_tolerance
+			&& ovec3f_get_length(&ang_vel_dev) < gyro_noise_tolerance
+			&& ovec3f_get_length(&bias_dev) < bias_limit
+			? OHMD_MIN(me->device_still_count + 1, me->ang_vel_fq.size + 1) : 0;
+
+		// once the filter queue only holds still samples, pull the estimate towards its mean,
+		// averaging outright at first and then continuing with a small gain to track drift
+
+		if(me->device_still_count > me->ang_vel_fq.size){
+			// stops counting once 1 / n drops below the tracking gain, it makes no difference past that
+			if(me->gyro_bias_samples * me->gyro_bias_gain < 1.0f)
+				me->gyro_bias_samples++;
+
+			float gain = OHMD_MAX(1.0f / me->gyro_bias_samples, me->gyro_bias_gain);
+
+			for(int i = 0; i < 3; i++)
+				me->gyro_bias.arr[i] += gain * (ang_vel_mean.arr[i] - me->gyro_bias.arr[i]);
+		}
+
+		ovec3f_subtract(ang_vel, &me->gyro_bias, &me->ang_vel);
+	}
+
+	// the filters below skip their gravity correction for a zero accelerometer reading
+	const vec3f no_accel = {{0, 0, 0}};
+	const vec3f* grav_accel = (me->flags & FF_USE_GRAVITY) ? accel : &no_accel;
+
+	vec3f corrected_rot = {{
+		rot_vec->x - me->gyro_bias.x * dt,
+		rot_vec->y - me->gyro_bias.y * dt,
+		rot_vec->z - me->gyro_bias.z * dt
+	}};
+
+	switch(me->algorithm){
+	case OHMD_FUSION_MADGWICK:
+		ofusion_madgwick_update(&me->madgwick, &me->orient, dt, &me->ang_vel, grav_accel);
+		break;
+
+	case OHMD_FUSION_MAHONY:
+		ofusion_mahony_update(&me->mahony, &me->orient, dt, &me->ang_vel, grav_accel);
+		break;
+
+	default:
+		complementary_update(me, dt, samples, &corrected_rot, accel);
+		break;
+	}
+
+	// magnetometer yaw correction, runs at a reduced rate since yaw drifts slowly
+	if((me->flags & FF_USE_MAG) && me->iterations / me->mag_interval != prev_iterations / me->mag_interval){
+		const float mag_tolerance = .25f, min_horizontal = .1f;
+
+		float mag_length = ovec3f_get_length(mag);
+
+		// project the field into the horizontal plane in world space, the remaining
+		// direction only depends on the yaw, tilt is taken care of by gravity correction
+		vec3f world_mag;
+		oquatf_get_rotated(&me->orient, mag, &world_mag);
+		world_mag.y = 0;
+
+		float horizontal_length = ovec3f_get_length(&world_mag);
+
+		if(horizontal_length > min_horizontal * mag_length){
+			ovec3f_normalize_me(&world_mag);
+
+			// capture the reference once the initial tilt has been corrected
+			if(me->mag_ref_length == 0){
+				if(me->iterations >= 2000){
+					me->mag_ref = world_mag;
+					me->mag_ref_length = mag_length;
+				}
+			}
+
+			// ignore samples where the field strength is off, they're likely disturbed
+			else if(fabsf(mag_length - me->mag_ref_length) < mag_tolerance * me->mag_ref_length){
+				// signed angle around the up axis from the current heading to the reference
+				float yaw_error = atan2f(world_mag.z * me->mag_ref.x - world_mag.x * me->mag_ref.z,
+				                         ovec3f_get_dot(&world_mag, &me->mag_ref));
+
+				vec3f up = {{0, 1.0f, 0}};
+				rotate_world(me, &up, me->mag_gain * yaw_error);
+			}
 		}
 	}
 
 	// mitigate drift due to floating point
 	// inprecision with quat multiplication.
-	oquatf_normalize_me(&me->orient);
+	normalize_orient(me);
 }
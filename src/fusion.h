@@ -13,18 +13,38 @@
 #include "omath.h"
 
 #define FF_USE_GRAVITY 1
+#define FF_USE_GYRO_BIAS 2
+#define FF_USE_MAG 4
+#define FF_DOUBLE_PRECISION 8 // integrate and correct the orientation in double precision
+
+// Madgwick gradient descent filter
+typedef struct {
+	float beta; // gradient step towards gravity, in quaternion units per second
+} fusion_madgwick;
+
+// Mahony nonlinear complementary filter
+typedef struct {
+	float kp; // proportional gain
+	float ki; // integral gain
+	vec3f integral_error;
+} fusion_mahony;
 
 typedef struct {
 	int state;
 
+	int algorithm; // ohmd_fusion_algorithm
+	fusion_madgwick madgwick;
+	fusion_mahony mahony;
+
 	quatf orient;   // orientation
+	quatd orient_d; // orientation in double precision, the one that's updated with FF_DOUBLE_PRECISION
 	vec3f accel;    // acceleration
 	vec3f ang_vel;  // angular velocity
 	vec3f mag;      // magnetometer
 	vec3f raw_mag;  // raw magnetometer values
 
 	int iterations;
-	float time;
+	double time;
 
 	int flags;
 
@@ -36,9 +56,43 @@ typedef struct {
 	float grav_error_angle;
 	vec3f grav_error_axis;
 	float grav_gain; // amount of correction
+
+	// gyro bias estimation
+	vec3f gyro_bias;
+	int device_still_count;
+	int gyro_bias_samples; // number of still samples the estimate is based on
+	float gyro_bias_gain; // amount of correction once the estimate has settled
+
+	// magnetometer yaw correction
+	vec3f mag_ref; // horizontal magnetic field direction in world space, zero until captured
+	float mag_ref_length;
+	int mag_interval; // correct every n samples
+	float mag_gain; // amount of correction
+
+	// gyro pre-integration, samples are accumulated and fused once per window
+	int fuse_interval; // fuse every n samples, 1 fuses every sample
+	int window_count;
+	float window_dt;
+	vec3f window_rot; // summed rotation vectors
+	vec3f window_coning; // coning correction
+	vec3f window_accel; // summed accelerometer samples
 } fusion;
 
 void ofusion_init(fusion* me);
 void ofusion_update(fusion* me, float dt, const vec3f* ang_vel, const vec3f* accel, const vec3f* mag_field);
+int ofusion_set_algorithm(fusion* me, int algorithm);
+
+// magnetometer yaw correction gain, 0 turns the correction off
+int ofusion_set_mag_gain(fusion* me, float gain);
+float ofusion_get_mag_gain(const fusion* me);
+
+// fuse a rotation vector pre-integrated over dt from n gyro samples, along with mean accelerometer readings
+void ofusion_update_delta(fusion* me, float dt, int samples, const vec3f* rot_vec, const vec3f* accel, const vec3f* mag_field);
+
+void ofusion_madgwick_init(fusion_madgwick* me);
+void ofusion_madgwick_update(fusion_madgwick* me, quatf* orient, float dt, const vec3f* ang_vel, const vec3f* accel);
+
+void ofusion_mahony_init(fusion_mahony* me);
+void ofusion_mahony_update(fusion_mahony* me, quatf* orient, float dt, const vec3f* ang_vel, const vec3f* accel);
 
 #endif
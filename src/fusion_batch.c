@@ -0,0 +1,328 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Batched Sensor Fusion Implementation */
+
+#include <string.h>
+#include "openhmdi.h"
+#include "fusion_batch.h"
+
+// samples the gyro has to stay steady for, and the weight of the running mean, as the scalar filter queue
+#define FB_STILL_WINDOW 20
+
+/*
+ * The update kernel is written once against the small set of vector
+ * operations below, and built for the widest instruction set the compiler
+ * targets. The scalar variant doubles as the reference implementation.
+ */
+
+#if defined(__AVX__)
+
+#include <immintrin.h>
+
+#define FB_ISA "avx"
+#define FB_WIDTH 8
+typedef __m256 vf;
+typedef __m256 vm;
+#define VLOAD(_p) _mm256_loadu_ps(_p)
+#define VSTORE(_p, _v) _mm256_storeu_ps(_p, _v)
+#define VSET(_f) _mm256_set1_ps(_f)
+#define VADD(_a, _b) _mm256_add_ps(_a, _b)
+#define VSUB(_a, _b) _mm256_sub_ps(_a, _b)
+#define VMUL(_a, _b) _mm256_mul_ps(_a, _b)
+#define VDIV(_a, _b) _mm256_div_ps(_a, _b)
+#define VMIN(_a, _b) _mm256_min_ps(_a, _b)
+#define VMAX(_a, _b) _mm256_max_ps(_a, _b)
+#define VLT(_a, _b) _mm256_cmp_ps(_a, _b, _CMP_LT_OQ)
+#define VMAND(_a, _b) _mm256_and_ps(_a, _b)
+#define VMASK(_m, _v) _mm256_and_ps(_m, _v)
+#define VRSQRT_EST(_v) _mm256_rsqrt_ps(_v)
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define FB_ISA "sse2"
+#define FB_WIDTH 4
+typedef __m128 vf;
+typedef __m128 vm;
+#define VLOAD(_p) _mm_loadu_ps(_p)
+#define VSTORE(_p, _v) _mm_storeu_ps(_p, _v)
+#define VSET(_f) _mm_set1_ps(_f)
+#define VADD(_a, _b) _mm_add_ps(_a, _b)
+#define VSUB(_a, _b) _mm_sub_ps(_a, _b)
+#define VMUL(_a, _b) _mm_mul_ps(_a, _b)
+#define VDIV(_a, _b) _mm_div_ps(_a, _b)
+#define VMIN(_a, _b) _mm_min_ps(_a, _b)
+#define VMAX(_a, _b) _mm_max_ps(_a, _b)
+#define VLT(_a, _b) _mm_cmplt_ps(_a, _b)
+#define VMAND(_a, _b) _mm_and_ps(_a, _b)
+#define VMASK(_m, _v) _mm_and_ps(_m, _v)
+#define VRSQRT_EST(_v) _mm_rsqrt_ps(_v)
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+#define FB_ISA "neon"
+#define FB_WIDTH 4
+typedef float32x4_t vf;
+typedef uint32x4_t vm;
+#define VLOAD(_p) vld1q_f32(_p)
+#define VSTORE(_p, _v) vst1q_f32(_p, _v)
+#define VSET(_f) vdupq_n_f32(_f)
+#define VADD(_a, _b) vaddq_f32(_a, _b)
+#define VSUB(_a, _b) vsubq_f32(_a, _b)
+#define VMUL(_a, _b) vmulq_f32(_a, _b)
+#define VDIV(_a, _b) vmulq_f32(_a, vrecip(_b))
+#define VMIN(_a, _b) vminq_f32(_a, _b)
+#define VMAX(_a, _b) vmaxq_f32(_a, _b)
+#define VLT(_a, _b) vcltq_f32(_a, _b)
+#define VMAND(_a, _b) vandq_u32(_a, _b)
+#define VMASK(_m, _v) vreinterpretq_f32_u32(vandq_u32(_m, vreinterpretq_u32_f32(_v)))
+#define VRSQRT_EST(_v) vrsqrteq_f32(_v)
+
+// 32 bit arm has no vector division, the estimate is refined with two newton-raphson steps
+static inline float32x4_t vrecip(float32x4_t x)
+{
+	float32x4_t y = vrecpeq_f32(x);
+	y = vmulq_f32(y, vrecpsq_f32(x, y));
+	return vmulq_f32(y, vrecpsq_f32(x, y));
+}
+
+#else
+
+#define FB_ISA "scalar"
+#define FB_WIDTH 1
+#define FB_SCALAR 1
+typedef float vf;
+typedef int vm;
+#define VLOAD(_p) (*(_p))
+#define VSTORE(_p, _v) (*(_p) = (_v))
+#define VSET(_f) (_f)
+#define VADD(_a, _b) ((_a) + (_b))
+#define VSUB(_a, _b) ((_a) - (_b))
+#define VMUL(_a, _b) ((_a) * (_b))
+#define VDIV(_a, _b) ((_a) / (_b))
+#define VMIN(_a, _b) OHMD_MIN(_a, _b)
+#define VMAX(_a, _b) OHMD_MAX(_a, _b)
+#define VLT(_a, _b) ((_a) < (_b))
+#define VMAND(_a, _b) ((_a) && (_b))
+#define VMASK(_m, _v) ((_m) ? (_v) : 0.0f)
+
+#endif
+
+// reciprocal square root, the estimate is refined with one newton-raphson step
+static inline vf vrsqrt(vf x)
+{
+#ifdef FB_SCALAR
+	return 1.0f / sqrtf(x);
+#else
+	vf y = VRSQRT_EST(x);
+	return VMUL(y, VSUB(VSET(1.5f), VMUL(VMUL(VSET(0.5f), x), VMUL(y, y))));
+#endif
+}
+
+void ofusion_batch_init(fusion_batch* me)
+{
+	memset(me, 0, sizeof(fusion_batch));
+
+	// keep padding lanes at a valid orientation as well
+	for(int i = 0; i < FUSION_BATCH_MAX_SIZE; i++)
+		me->ow[i] = 1.0f;
+
+	me->grav_gain = 0.25f;
+	me->gyro_bias_gain = 0.0005f;
+}
+
+static void reset_lane(fusion_batch* me, int idx)
+{
+	me->ox[idx] = me->oy[idx] = me->oz[idx] = 0;
+	me->ow[idx] = 1.0f;
+
+	me->bx[idx] = me->by[idx] = me->bz[idx] = 0;
+	me->mx[idx] = me->my[idx] = me->mz[idx] = 0;
+	me->still_count[idx] = me->bias_samples[idx] = 0;
+
+	me->dt[idx] = 0;
+	me->gx[idx] = me->gy[idx] = me->gz[idx] = 0;
+	me->ax[idx] = me->ay[idx] = me->az[idx] = 0;
+}
+
+static void move_lane(fusion_batch* me, int to, int from)
+{
+	me->ox[to] = me->ox[from]; me->oy[to] = me->oy[from];
+	me->oz[to] = me->oz[from]; me->ow[to] = me->ow[from];
+
+	me->bx[to] = me->bx[from]; me->by[to] = me->by[from]; me->bz[to] = me->bz[from];
+	me->mx[to] = me->mx[from]; me->my[to] = me->my[from]; me->mz[to] = me->mz[from];
+	me->still_count[to] = me->still_count[from];
+	me->bias_samples[to] = me->bias_samples[from];
+
+	me->dt[to] = me->dt[from];
+	me->gx[to] = me->gx[from]; me->gy[to] = me->gy[from]; me->gz[to] = me->gz[from];
+	me->ax[to] = me->ax[from]; me->ay[to] = me->ay[from]; me->az[to] = me->az[from];
+
+	reset_lane(me, from);
+}
+
+int ofusion_batch_add(fusion_batch* me)
+{
+	if(me->size >= FUSION_BATCH_MAX_SIZE)
+		return -1;
+
+	reset_lane(me, me->size);
+	return me->size++;
+}
+
+void ofusion_batch_remove(fusion_batch* me, int idx)
+{
+	me->size--;
+
+	if(idx != me->size)
+		move_lane(me, idx, me->size);
+	else
+		reset_lane(me, idx);
+}
+
+void ofusion_batch_set_sample(fusion_batch* me, int idx, float dt, const vec3f* ang_vel, const vec3f* accel)
+{
+	me->dt[idx] = dt;
+
+	me->gx[idx] = ang_vel->x;
+	me->gy[idx] = ang_vel->y;
+	me->gz[idx] = ang_vel->z;
+
+	me->ax[idx] = accel->x;
+	me->ay[idx] = accel->y;
+	me->az[idx] = accel->z;
+}
+
+void ofusion_batch_get_orient(const fusion_batch* me, int idx, quatf* out)
+{
+	out->x = me->ox[idx];
+	out->y = me->oy[idx];
+	out->z = me->oz[idx];
+	out->w = me->ow[idx];
+}
+
+const char* ofusion_batch_get_isa(void)
+{
+	return FB_ISA;
+}
+
+void ofusion_batch_update(fusion_batch* me)
+{
+	const vf half = VSET(0.5f), one = VSET(1.0f);
+	const vf grav_min = VSET(POW2(9.82f - .4f)), grav_max = VSET(POW2(9.82f + .4f));
+	const vf gyro_noise_tolerance = VSET(POW2(.05f));
+	const vf max_bias = VSET(.2f), bias_tracking_tolerance = VSET(.02f);
+	const vf window = VSET(FB_STILL_WINDOW), mean_weight = VSET(1.0f / FB_STILL_WINDOW);
+	const vf grav_gain = VSET(-0.5f * me->grav_gain), bias_gain = VSET(me->gyro_bias_gain);
+
+	for(int i = 0; i < me->size; i += FB_WIDTH){
+		vf ox = VLOAD(me->ox + i), oy = VLOAD(me->oy + i), oz = VLOAD(me->oz + i), ow = VLOAD(me->ow + i);
+		vf bx = VLOAD(me->bx + i), by = VLOAD(me->by + i), bz = VLOAD(me->bz + i);
+		vf ax = VLOAD(me->ax + i), ay = VLOAD(me->ay + i), az = VLOAD(me->az + i);
+		vf dt = VLOAD(me->dt + i);
+		vf rawx = VLOAD(me->gx + i), rawy = VLOAD(me->gy + i), rawz = VLOAD(me->gz + i);
+
+		// devices without a new sample rotate by nothing and leave their bias state alone
+		vm active = VLT(VSET(0), dt);
+		VSTORE(me->dt + i, VSET(0));
+
+		// bias corrected angular velocity
+		vf gx = VSUB(rawx, bx);
+		vf gy = VSUB(rawy, by);
+		vf gz = VSUB(rawz, bz);
+
+		// rotation vector over dt and its squared angle
+		vf rx = VMUL(gx, dt), ry = VMUL(gy, dt), rz = VMUL(gz, dt);
+		vf a2 = VADD(VADD(VMUL(rx, rx), VMUL(ry, ry)), VMUL(rz, rz));
+
+		// exponential map, cos(a/2) and sin(a/2)/a as series in a^2
+		vf c = VADD(one, VMUL(a2, VADD(VSET(-1.0f / 8.0f), VMUL(a2, VSET(1.0f / 384.0f)))));
+		vf s = VADD(half, VMUL(a2, VADD(VSET(-1.0f / 48.0f), VMUL(a2, VSET(1.0f / 3840.0f)))));
+		vf dx = VMUL(rx, s), dy = VMUL(ry, s), dz = VMUL(rz, s);
+
+		// orient = orient * delta
+		vf nx = VADD(VADD(VMUL(ow, dx), VMUL(ox, c)), VSUB(VMUL(oy, dz), VMUL(oz, dy)));
+		vf ny = VADD(VSUB(VMUL(ow, dy), VMUL(ox, dz)), VADD(VMUL(oy, c), VMUL(oz, dx)));
+		vf nz = VADD(VSUB(VADD(VMUL(ow, dz), VMUL(ox, dy)), VMUL(oy, dx)), VMUL(oz, c));
+		vf nw = VSUB(VSUB(VMUL(ow, c), VMUL(ox, dx)), VADD(VMUL(oy, dy), VMUL(oz, dz)));
+		ox = nx; oy = ny; oz = nz; ow = nw;
+
+		// only trust the accelerometer when it measures about one g
+		vf acc2 = VADD(VADD(VMUL(ax, ax), VMUL(ay, ay)), VMUL(az, az));
+		vm level = VMAND(VLT(grav_min, acc2), VLT(acc2, grav_max));
+
+		// gyro bias estimation, see ofusion_update
+		vf mx = VLOAD(me->mx + i), my = VLOAD(me->my + i), mz = VLOAD(me->mz + i);
+		mx = VADD(mx, VMASK(active, VMUL(mean_weight, VSUB(rawx, mx))));
+		my = VADD(my, VMASK(active, VMUL(mean_weight, VSUB(rawy, my))));
+		mz = VADD(mz, VMASK(active, VMUL(mean_weight, VSUB(rawz, mz))));
+		VSTORE(me->mx + i, mx);
+		VSTORE(me->my + i, my);
+		VSTORE(me->mz + i, mz);
+
+		vf devx = VSUB(rawx, mx), devy = VSUB(rawy, my), devz = VSUB(rawz, mz);
+		vf dev2 = VADD(VADD(VMUL(devx, devx), VMUL(devy, devy)), VMUL(devz, devz));
+
+		vf bdx = VSUB(mx, bx), bdy = VSUB(my, by), bdz = VSUB(mz, bz);
+		vf bias_dev2 = VADD(VADD(VMUL(bdx, bdx), VMUL(bdy, bdy)), VMUL(bdz, bdz));
+
+		// the device is still while level with a steady gyro a bias could explain, once
+		// the estimate has settled it may only move slowly so a slow turn isn't absorbed
+		vf samples = VLOAD(me->bias_samples + i);
+		vm settling = VLT(VMUL(samples, bias_gain), one);
+		vf bias_limit = VADD(bias_tracking_tolerance, VMASK(settling, VSUB(max_bias, bias_tracking_tolerance)));
+
+		vm still = VMAND(VMAND(level, VLT(dev2, gyro_noise_tolerance)), VLT(bias_dev2, VMUL(bias_limit, bias_limit)));
+		vf prev_count = VLOAD(me->still_count + i);
+		vf still_count = VMASK(still, VMIN(VADD(prev_count, one), VADD(window, one)));
+		still_count = VADD(prev_count, VMASK(active, VSUB(still_count, prev_count)));
+		VSTORE(me->still_count + i, still_count);
+
+		// averages outright at first, then tracks drift with the small gain, both counts saturate
+		vm update = VMAND(active, VLT(window, still_count));
+		samples = VADD(samples, VMASK(VMAND(update, settling), one));
+		VSTORE(me->bias_samples + i, samples);
+
+		vf gain = VMASK(update, VMAX(VDIV(one, VMAX(samples, one)), bias_gain));
+		VSTORE(me->bx + i, VADD(bx, VMUL(gain, bdx)));
+		VSTORE(me->by + i, VADD(by, VMUL(gain, bdy)));
+		VSTORE(me->bz + i, VADD(bz, VMUL(gain, bdz)));
+
+		// accelerometer in world space, qv = v * w + cross(v, q.xyz) and out = q.w * qv + ...
+		vf qx = VADD(VMUL(ax, ow), VSUB(VMUL(az, oy), VMUL(ay, oz)));
+		vf qy = VADD(VMUL(ay, ow), VSUB(VMUL(ax, oz), VMUL(az, ox)));
+		vf qz = VADD(VMUL(az, ow), VSUB(VMUL(ay, ox), VMUL(ax, oy)));
+		vf qw = VADD(VADD(VMUL(ax, ox), VMUL(ay, oy)), VMUL(az, oz));
+
+		vf wx = VADD(VADD(VMUL(ow, qx), VMUL(ox, qw)), VSUB(VMUL(oy, qz), VMUL(oz, qy)));
+		vf wz = VADD(VADD(VMUL(ow, qz), VMUL(oz, qw)), VSUB(VMUL(ox, qy), VMUL(oy, qx)));
+
+		// rotate towards gravity around (z, 0, -x), which for small tilts has
+		// the length of the tilt angle once divided by the accelerometer length
+		vf k = VMASK(level, VMUL(VMUL(grav_gain, dt), vrsqrt(acc2)));
+		vf hx = VMUL(k, wz), hz = VMUL(k, VSUB(VSET(0), wx));
+
+		// orient = corr * orient with corr = (hx, 0, hz, 1)
+		nx = VADD(ox, VSUB(VMUL(hx, ow), VMUL(hz, oy)));
+		ny = VADD(oy, VSUB(VMUL(hz, ox), VMUL(hx, oz)));
+		nz = VADD(oz, VADD(VMUL(hz, ow), VMUL(hx, oy)));
+		nw = VSUB(ow, VADD(VMUL(hx, ox), VMUL(hz, oz)));
+
+		// normalize
+		vf len = vrsqrt(VADD(VADD(VMUL(nx, nx), VMUL(ny, ny)), VADD(VMUL(nz, nz), VMUL(nw, nw))));
+
+		VSTORE(me->ox + i, VMUL(nx, len));
+		VSTORE(me->oy + i, VMUL(ny, len));
+		VSTORE(me->oz + i, VMUL(nz, len));
+		VSTORE(me->ow + i, VMUL(nw, len));
+	}
+}
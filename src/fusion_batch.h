@@ -0,0 +1,65 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Batched Sensor Fusion */
+
+#ifndef FUSION_BATCH_H
+#define FUSION_BATCH_H
+
+#include <stdbool.h>
+#include "omath.h"
+
+// matches the maximum number of active devices in a context
+#define FUSION_BATCH_MAX_SIZE 256
+
+/*
+ * Fusion state for many devices kept as a structure of arrays, so one update
+ * pass can advance a full SIMD register of devices at a time.
+ *
+ * Each device integrates its gyro sample with a polynomial exponential map,
+ * which is accurate for the per sample angles seen at IMU rates (< 0.2 rad),
+ * and gets a continuous gravity tilt correction. The gyro bias is tracked
+ * while the device is still, gated the same way as in ofusion_update, with a
+ * running mean of the gyro standing in for the filter queue.
+ *
+ * The external driver fuses the samples handed to its devices with one batch
+ * per context, the other drivers keep a fusion state per device.
+ */
+typedef struct {
+	int size;
+
+	// orientation
+	float ox[FUSION_BATCH_MAX_SIZE], oy[FUSION_BATCH_MAX_SIZE];
+	float oz[FUSION_BATCH_MAX_SIZE], ow[FUSION_BATCH_MAX_SIZE];
+
+	// gyro bias
+	float bx[FUSION_BATCH_MAX_SIZE], by[FUSION_BATCH_MAX_SIZE], bz[FUSION_BATCH_MAX_SIZE];
+
+	// gyro running mean, and the still and bias sample counts, kept as floats to stay in vector registers
+	float mx[FUSION_BATCH_MAX_SIZE], my[FUSION_BATCH_MAX_SIZE], mz[FUSION_BATCH_MAX_SIZE];
+	float still_count[FUSION_BATCH_MAX_SIZE], bias_samples[FUSION_BATCH_MAX_SIZE];
+
+	// input for the next update, consumed by ofusion_batch_update, a dt of 0 means no new sample
+	float dt[FUSION_BATCH_MAX_SIZE];
+	float gx[FUSION_BATCH_MAX_SIZE], gy[FUSION_BATCH_MAX_SIZE], gz[FUSION_BATCH_MAX_SIZE];
+	float ax[FUSION_BATCH_MAX_SIZE], ay[FUSION_BATCH_MAX_SIZE], az[FUSION_BATCH_MAX_SIZE];
+
+	float grav_gain; // fraction of the tilt error corrected per second
+	float gyro_bias_gain; // amount of bias correction per still sample
+} fusion_batch;
+
+void ofusion_batch_init(fusion_batch* me);
+int ofusion_batch_add(fusion_batch* me); // -1 if full
+void ofusion_batch_remove(fusion_batch* me, int idx); // the last device moves into idx
+void ofusion_batch_set_sample(fusion_batch* me, int idx, float dt, const vec3f* ang_vel, const vec3f* accel);
+void ofusion_batch_update(fusion_batch* me);
+void ofusion_batch_get_orient(const fusion_batch* me, int idx, quatf* out);
+
+// name of the instruction set the batch update was built for
+const char* ofusion_batch_get_isa(void);
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* HID Report Reader */
+
+#ifndef HID_READER_H
+#define HID_READER_H
+
+#include <hidapi.h>
+
+#include "openhmdi.h"
+
+#ifdef _MSC_VER
+#define inline __inline
+#endif
+
+/*
+ * Reads the input reports of a HID interface. With OHMD_HIDRAW on Linux the
+ * hidraw node hidapi opened is opened a second time and read directly, that
+ * skips hidapi's copy and locking per report, and the node is registered with
+ * the device so the update thread wakes up when a report arrives. Enumeration
+ * and feature reports stay on the hidapi handle. Everywhere else, and when the
+ * path isn't a hidraw node, reports come from hid_read.
+ *
+ * With OHMD_IO_URING the nodes are read through the context's io_uring, see
+ * uring.h, and the device waits on the ring instead of the node.
+ *
+ * The handle has to be non blocking, and fd must be -1 until attached.
+ *
+ * An unplugged hidraw node polls as hung up for as long as it stays open, so
+ * on the first read error the node is closed and taken out of the device's
+ * poll fds, or the update thread would never sleep again. The error is
+ * reported once, after that the reader has no more reports.
+ */
+typedef struct {
+	ohmd_device* device;
+	hid_device* handle;
+	int fd;
+	ohmd_uring* uring;
+	int uring_id;
+	bool failed;
+} ohmd_hid_reader;
+
+static inline void ohmd_hid_reader_add_poll_fd(ohmd_device* device, int fd)
+{
+	for(int i = 0; i < device->num_poll_fds; i++){
+		if(device->poll_fds[i] == fd)
+			return;
+	}
+
+	if(device->num_poll_fds < OHMD_MAX_POLL_FDS)
+		device->poll_fds[device->num_poll_fds++] = fd;
+}
+
+static inline void ohmd_hid_reader_remove_poll_fd(ohmd_device* device, int fd)
+{
+	for(int i = 0; i < device->num_poll_fds; i++){
+		if(device->poll_fds[i] == fd){
+			device->poll_fds[i] = device->poll_fds[--device->num_poll_fds];
+			return;
+		}
+	}
+}
+
+static inline void ohmd_hid_reader_init(ohmd_hid_reader* reader, ohmd_device* device, hid_device* handle, const char* path)
+{
+	ohmd_context* ctx = device->ctx;
+
+	reader->device = device;
+	reader->handle = handle;
+	reader->fd = ohmd_hidraw_open(path);
+	reader->uring = NULL;
+	reader->uring_id = -1;
+	reader->failed = false;
+
+	if(reader->fd < 0)
+		return;
+
+	if(!ctx->uring)
+		ctx->uring = ohmd_uring_create(ctx);
+
+	if(ctx->uring)
+		reader->uring_id = ohmd_uring_add(ctx->uring, reader->fd);
+
+	if(reader->uring_id >= 0){
+		reader->uring = ctx->uring;
+		ohmd_hid_reader_add_poll_fd(device, ohmd_uring_get_fd(reader->uring));
+	}else{
+		ohmd_hid_reader_add_poll_fd(device, reader->fd);
+	}
+
+	LOGD("reading %s through hidraw", path);
+}
+
+// only closes the hidraw node, the handle belongs to the driver
+static inline void ohmd_hid_reader_close(ohmd_hid_reader* reader)
+{
+	if(reader->uring){
+		// the ring's fd stays registered, other readers of the device may share it
+		ohmd_uring_remove(reader->uring, reader->uring_id);
+	}else if(reader->fd >= 0 && reader->device){
+		ohmd_hid_reader_remove_poll_fd(reader->device, reader->fd);
+	}
+
+	if(reader->fd >= 0)
+		ohmd_hidraw_close(reader->fd);
+
+	reader->fd = -1;
+	reader->uring = NULL;
+}
+
+// the size of the report, 0 when there are none left or -1 on errors
+static inline int ohmd_hid_reader_read(ohmd_hid_reader* reader, unsigned char* buffer, int size)
+{
+	int ret;
+
+	if(reader->failed)
+		return 0;
+
+	if(reader->uring)
+		ret = ohmd_uring_read(reader->uring, reader->uring_id, buffer, size);
+	else if(reader->fd >= 0)
+		ret = ohmd_hidraw_read(reader->fd, buffer, size);
+	else
+		ret = hid_read(reader->handle, buffer, size);
+
+	if(ret < 0){
+		reader->failed = true;
+		ohmd_hid_reader_close(reader);
+	}
+
+	return ret;
+}
+
+#endif
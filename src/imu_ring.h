@@ -0,0 +1,72 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* IMU Sample Ring */
+
+#ifndef IMU_RING_H
+#define IMU_RING_H
+
+#include <stdint.h>
+#include "omath.h"
+
+#ifdef _MSC_VER
+#define inline __inline
+#endif
+
+/*
+ * Fusion ready IMU samples. A driver keeps a ring in its private struct, its
+ * decoder converts the samples of a report straight from the HID buffer into
+ * the ring, and the driver passes pointers into the ring to the fusion.
+ *
+ * Pushing never fails, when the ring is full the oldest unread sample is
+ * overwritten. A popped sample stays valid until IMU_RING_SIZE more have been
+ * pushed, far more than any report carries.
+ */
+
+// a power of two
+#define IMU_RING_SIZE 16
+
+typedef struct {
+	vec3f accel; // m/s^2
+	vec3f gyro;  // rad/s
+	vec3f mag;   // zero for devices without a magnetometer
+	uint32_t tick; // device time stamp, the unit is device specific
+	uint8_t seq;   // device sequence number, for devices that send one
+} imu_sample;
+
+typedef struct {
+	imu_sample samples[IMU_RING_SIZE];
+	unsigned write, read; // free running
+	unsigned overwritten; // unread samples lost to a full ring
+} imu_ring;
+
+// the slot for the next sample, for the decoder to fill in
+static inline imu_sample* imu_ring_push(imu_ring* me)
+{
+	if(me->write - me->read == IMU_RING_SIZE){
+		me->read++;
+		me->overwritten++;
+	}
+
+	return &me->samples[me->write++ & (IMU_RING_SIZE - 1)];
+}
+
+// the oldest unread sample, NULL when there is none
+static inline imu_sample* imu_ring_pop(imu_ring* me)
+{
+	if(me->read == me->write)
+		return NULL;
+
+	return &me->samples[me->read++ & (IMU_RING_SIZE - 1)];
+}
+
+static inline int imu_ring_count(const imu_ring* me)
+{
+	return me->write - me->read;
+}
+
+#endif
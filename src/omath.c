@@ -7,36 +7,33 @@
 
 /* Math Code Implementation */
 
+// the exported functions are defined here, see omath_inline.h
+#define OMATH_IMPLEMENTATION
+
 #include <string.h>
 #include "openhmdi.h"
+#include "omath_simd.h"
 
 // vector
 
 float ovec3f_get_length(const vec3f* me)
 {
-	return sqrtf(POW2(me->x) + POW2(me->y) + POW2(me->z));
+	return ovec3f_get_length_inline(me);
 }
 
 void ovec3f_normalize_me(vec3f* me)
 {
-	if(me->x == 0 && me->y == 0 && me->z == 0)
-		return;
-
-	float len = ovec3f_get_length(me);
-	me->x /= len;
-	me->y /= len;
-	me->z /= len;
+	ovec3f_normalize_me_inline(me);
 }
 
 void ovec3f_subtract(const vec3f* a, const vec3f* b, vec3f* out)
 {
-	for(int i = 0; i < 3; i++)
-		out->arr[i] = a->arr[i] - b->arr[i];
+	ovec3f_subtract_inline(a, b, out);
 }
 
 float ovec3f_get_dot(const vec3f* me, const vec3f* vec)
 {
-	return me->x * vec->x + me->y * vec->y + me->z * vec->z;
+	return ovec3f_get_dot_inline(me, vec);
 }
 
 float ovec3f_get_angle(const vec3f* me, const vec3f* vec)
@@ -55,33 +52,22 @@ float ovec3f_get_angle(const vec3f* me, const vec3f* vec)
 
 void oquatf_init_axis(quatf* me, const vec3f* vec, float angle)
 {
-	vec3f norm = *vec;
-	ovec3f_normalize_me(&norm);
+	oquatf_init_axis_inline(me, vec, angle);
+}
 
-	me->x = norm.x * sinf(angle / 2.0f);
-	me->y = norm.y * sinf(angle / 2.0f);
-	me->z = norm.z * sinf(angle / 2.0f);
-	me->w = cosf(angle / 2.0f);
+void oquatf_init_rotation_vector(quatf* me, const vec3f* rot_vec)
+{
+	oquatf_init_rotation_vector_inline(me, rot_vec);
 }
 
 void oquatf_get_rotated(const quatf* me, const vec3f* vec, vec3f* out_vec)
 {
-	quatf q = {{vec->x * me->w + vec->z * me->y - vec->y * me->z,
-	            vec->y * me->w + vec->x * me->z - vec->z * me->x,
-	            vec->z * me->w + vec->y * me->x - vec->x * me->y,
-	            vec->x * me->x + vec->y * me->y + vec->z * me->z}};
-
-	out_vec->x = me->w * q.x + me->x * q.w + me->y * q.z - me->z * q.y;
-	out_vec->y = me->w * q.y + me->y * q.w + me->z * q.x - me->x * q.z;
-	out_vec->z = me->w * q.z + me->z * q.w + me->x * q.y - me->y * q.x;
+	omath_active_kernels->quat_get_rotated(me, vec, out_vec);
 }
 
 void oquatf_mult(const quatf* me, const quatf* q, quatf* out_q)
 {
-	out_q->x = me->w * q->x + me->x * q->w + me->y * q->z - me->z * q->y;
-	out_q->y = me->w * q->y - me->x * q->z + me->y * q->w + me->z * q->x;
-	out_q->z = me->w * q->z + me->x * q->y - me->y * q->x + me->z * q->w;
-	out_q->w = me->w * q->w - me->x * q->x - me->y * q->y - me->z * q->z;
+	omath_active_kernels->quat_mult(me, q, out_q);
 }
 
 void oquatf_mult_me(quatf* me, const quatf* q)
@@ -92,21 +78,17 @@ void oquatf_mult_me(quatf* me, const quatf* q)
 
 void oquatf_normalize_me(quatf* me)
 {
-	float len = oquatf_get_length(me);
-	me->x /= len;
-	me->y /= len;
-	me->z /= len;
-	me->w /= len;
+	omath_active_kernels->quat_normalize_me(me);
 }
 
 float oquatf_get_length(const quatf* me)
 {
-	return sqrtf(me->x * me->x + me->y * me->y + me->z * me->z + me->w * me->w);
+	return oquatf_get_length_inline(me);
 }
 
 float oquatf_get_dot(const quatf* me, const quatf* q)
 {
-	return me->x * q->x + me->y * q->y + me->z * q->z + me->w * q->w;
+	return oquatf_get_dot_inline(me, q);
 }
 
 void oquatf_inverse(quatf* me)
@@ -288,6 +270,52 @@ void omat4x4f_init_frustum(mat4x4f* me, float left, float right, float bottom, f
 	me->m[3][3] = 0;
 }
 
+void omat4x4f_init_frustum_tangents(mat4x4f* me, float left, float right, float bottom, float top, float znear, float zfar, int flags)
+{
+	omat4x4f_init_ident(me);
+
+	float delta_x = right - left;
+	float delta_y = top - bottom;
+	bool infinite = (flags & OMATH_PROJ_INFINITE_FAR) != 0;
+	if (delta_x == 0.0f || delta_y == 0.0f || znear <= 0.0f || (!infinite && zfar <= znear)) {
+		return;
+	}
+
+	// depth at the near and far plane
+	double depth_near = (flags & OMATH_PROJ_ZERO_TO_ONE) ? 0.0 : -1.0;
+	double depth_far = 1.0;
+
+	if(flags & OMATH_PROJ_REVERSE_Z){
+		double tmp = depth_near;
+		depth_near = depth_far;
+		depth_far = tmp;
+	}
+
+	// depth = m22 + m23 / distance, solved for the two planes, in double since the
+	// terms nearly cancel for far planes much further away than the near plane
+	double n = znear, f = zfar, m22, m23;
+	if(infinite){
+		m23 = (depth_near - depth_far) * n;
+		m22 = depth_far;
+	}else{
+		m23 = (depth_near - depth_far) * n * f / (f - n);
+		m22 = depth_far - m23 / f;
+	}
+
+	me->m[0][0] = 2.0f / delta_x;
+	me->m[0][2] = (right + left) / delta_x;
+
+	me->m[1][1] = 2.0f / delta_y;
+	me->m[1][2] = (top + bottom) / delta_y;
+
+	// view space looks down -z, clip w is the distance
+	me->m[2][2] = (float)-m22;
+	me->m[2][3] = (float)m23;
+
+	me->m[3][2] = -1.0f;
+	me->m[3][3] = 0;
+}
+
 void omat4x4f_init_look_at(mat4x4f* me, const quatf* rot, const vec3f* eye)
 {
 	quatf q;
@@ -323,6 +351,60 @@ void omat4x4f_init_look_at(mat4x4f* me, const quatf* rot, const vec3f* eye)
 	me->m[3][3] = 1;
 }
 
+// view rotation and the world shift of each eye, the rows of [rot^-1 | -pos -+ ipd / 2]
+static void get_eye_views(const quatf* rot, const vec3f* pos, float ipd, float r[3][3], float t_left[3], float t_right[3])
+{
+	quatf q = {{ -rot->x, -rot->y, -rot->z, rot->w }};
+
+	float xx = 2 * q.x * q.x, yy = 2 * q.y * q.y, zz = 2 * q.z * q.z;
+	float xy = 2 * q.x * q.y, xz = 2 * q.x * q.z, yz = 2 * q.y * q.z;
+	float wx = 2 * q.w * q.x, wy = 2 * q.w * q.y, wz = 2 * q.w * q.z;
+
+	r[0][0] = 1 - yy - zz; r[0][1] = xy - wz;     r[0][2] = xz + wy;
+	r[1][0] = xy + wz;     r[1][1] = 1 - xx - zz; r[1][2] = yz - wx;
+	r[2][0] = xz - wy;     r[2][1] = yz + wx;     r[2][2] = 1 - xx - yy;
+
+	t_left[0] = -pos->x + ipd / 2.0f;
+	t_right[0] = -pos->x - ipd / 2.0f;
+	t_left[1] = t_right[1] = -pos->y;
+	t_left[2] = t_right[2] = -pos->z;
+}
+
+void omat4x4f_init_eye_views_gl(const quatf* rot, const vec3f* pos, float ipd, float left[16], float right[16])
+{
+	float r[3][3], tl[3], tr[3];
+	get_eye_views(rot, pos, ipd, r, tl, tr);
+
+	// column major, the eyes only differ in the translation
+	for(int col = 0; col < 3; col++){
+		for(int row = 0; row < 3; row++)
+			left[col * 4 + row] = right[col * 4 + row] = r[row][col];
+
+		left[col * 4 + 3] = right[col * 4 + 3] = 0;
+	}
+
+	for(int row = 0; row < 3; row++){
+		left[12 + row] = tl[row];
+		right[12 + row] = tr[row];
+	}
+
+	left[15] = right[15] = 1;
+}
+
+void omat3x4f_init_eye_views(const quatf* rot, const vec3f* pos, float ipd, float left[12], float right[12])
+{
+	float r[3][3], tl[3], tr[3];
+	get_eye_views(rot, pos, ipd, r, tl, tr);
+
+	for(int row = 0; row < 3; row++){
+		for(int col = 0; col < 3; col++)
+			left[row * 4 + col] = right[row * 4 + col] = r[row][col];
+
+		left[row * 4 + 3] = tl[row];
+		right[row * 4 + 3] = tr[row];
+	}
+}
+
 void omat4x4f_init_translate(mat4x4f* me, float x, float y, float z)
 {
 	omat4x4f_init_ident(me);
@@ -333,31 +415,218 @@ void omat4x4f_init_translate(mat4x4f* me, float x, float y, float z)
 
 void omat4x4f_transpose(const mat4x4f* m, mat4x4f* o)
 {
-	o->m[0][0] = m->m[0][0];
-	o->m[1][0] = m->m[0][1];
-	o->m[2][0] = m->m[0][2];
-	o->m[3][0] = m->m[0][3];
+	omath_active_kernels->mat_transpose(m, o);
+}
 
-	o->m[0][1] = m->m[1][0];
-	o->m[1][1] = m->m[1][1];
-	o->m[2][1] = m->m[1][2];
-	o->m[3][1] = m->m[1][3];
+void omat4x4f_mult(const mat4x4f* l, const mat4x4f* r, mat4x4f *o)
+{
+	omath_active_kernels->mat_mult(l, r, o);
+}
 
-	o->m[0][2] = m->m[2][0];
-	o->m[1][2] = m->m[2][1];
-	o->m[2][2] = m->m[2][2];
-	o->m[3][2] = m->m[2][3];
+void omat4x4f_transform_points_aos(const mat4x4f* me, const float* in, float* out, int count)
+{
+	omath_active_kernels->points_transform_aos(me->arr, in, out, count);
+}
 
-	o->m[0][3] = m->m[3][0];
-	o->m[1][3] = m->m[3][1];
-	o->m[2][3] = m->m[3][2];
-	o->m[3][3] = m->m[3][3];
+void omat4x4f_transform_points_soa(const mat4x4f* me, const float* in, float* out, int count)
+{
+	omath_active_kernels->points_transform_soa(me->arr, in, out, count);
 }
 
-void omat4x4f_mult(const mat4x4f* l, const mat4x4f* r, mat4x4f *o)
+
+// double precision
+
+void ovec3d_normalize_me(vec3d* me)
+{
+	if(me->x == 0 && me->y == 0 && me->z == 0)
+		return;
+
+	double len = ovec3d_get_length(me);
+	me->x /= len;
+	me->y /= len;
+	me->z /= len;
+}
+
+double ovec3d_get_length(const vec3d* me)
+{
+	return sqrt(POW2(me->x) + POW2(me->y) + POW2(me->z));
+}
+
+double ovec3d_get_dot(const vec3d* me, const vec3d* vec)
+{
+	return me->x * vec->x + me->y * vec->y + me->z * vec->z;
+}
+
+void ovec3d_subtract(const vec3d* a, const vec3d* b, vec3d* out)
+{
+	for(int i = 0; i < 3; i++)
+		out->arr[i] = a->arr[i] - b->arr[i];
+}
+
+void ovec3d_from_vec3f(vec3d* me, const vec3f* vec)
+{
+	for(int i = 0; i < 3; i++)
+		me->arr[i] = vec->arr[i];
+}
+
+void ovec3d_get_vec3f(const vec3d* me, vec3f* out_vec)
+{
+	for(int i = 0; i < 3; i++)
+		out_vec->arr[i] = (float)me->arr[i];
+}
+
+void oquatd_init_axis(quatd* me, const vec3d* vec, double angle)
+{
+	vec3d norm = *vec;
+	ovec3d_normalize_me(&norm);
+
+	double s = sin(angle / 2.0);
+
+	me->x = norm.x * s;
+	me->y = norm.y * s;
+	me->z = norm.z * s;
+	me->w = cos(angle / 2.0);
+}
+
+void oquatd_init_rotation_vector(quatd* me, const vec3d* rot_vec)
+{
+	double a2 = POW2(rot_vec->x) + POW2(rot_vec->y) + POW2(rot_vec->z);
+	double c, s;
+
+	// same series as the float version, one more term keeps it below double rounding up to 0.05 rad
+	if(a2 < POW2(0.05)){
+		c = 1.0 + a2 * (-1.0 / 8.0 + a2 * (1.0 / 384.0 + a2 * (-1.0 / 46080.0)));
+		s = 0.5 + a2 * (-1.0 / 48.0 + a2 * (1.0 / 3840.0 + a2 * (-1.0 / 645120.0)));
+	}else{
+		double a = sqrt(a2);
+		c = cos(a / 2.0);
+		s = sin(a / 2.0) / a;
+	}
+
+	me->x = rot_vec->x * s;
+	me->y = rot_vec->y * s;
+	me->z = rot_vec->z * s;
+	me->w = c;
+}
+
+void oquatd_get_rotated(const quatd* me, const vec3d* vec, vec3d* out_vec)
+{
+	quatd q = {{vec->x * me->w + vec->z * me->y - vec->y * me->z,
+	            vec->y * me->w + vec->x * me->z - vec->z * me->x,
+	            vec->z * me->w + vec->y * me->x - vec->x * me->y,
+	            vec->x * me->x + vec->y * me->y + vec->z * me->z}};
+
+	out_vec->x = me->w * q.x + me->x * q.w + me->y * q.z - me->z * q.y;
+	out_vec->y = me->w * q.y + me->y * q.w + me->z * q.x - me->x * q.z;
+	out_vec->z = me->w * q.z + me->z * q.w + me->x * q.y - me->y * q.x;
+}
+
+void oquatd_mult(const quatd* me, const quatd* q, quatd* out_q)
+{
+	out_q->x = me->w * q->x + me->x * q->w + me->y * q->z - me->z * q->y;
+	out_q->y = me->w * q->y - me->x * q->z + me->y * q->w + me->z * q->x;
+	out_q->z = me->w * q->z + me->x * q->y - me->y * q->x + me->z * q->w;
+	out_q->w = me->w * q->w - me->x * q->x - me->y * q->y - me->z * q->z;
+}
+
+void oquatd_mult_me(quatd* me, const quatd* q)
+{
+	quatd tmp = *me;
+	oquatd_mult(&tmp, q, me);
+}
+
+void oquatd_normalize_me(quatd* me)
+{
+	double len = oquatd_get_length(me);
+	for(int i = 0; i < 4; i++)
+		me->arr[i] /= len;
+}
+
+double oquatd_get_length(const quatd* me)
+{
+	return sqrt(oquatd_get_dot(me, me));
+}
+
+double oquatd_get_dot(const quatd* me, const quatd* q)
+{
+	return me->x * q->x + me->y * q->y + me->z * q->z + me->w * q->w;
+}
+
+void oquatd_inverse(quatd* me)
+{
+	double dot = oquatd_get_dot(me, me);
+
+	// conjugate
+	for(int i = 0; i < 3; i++)
+		me->arr[i] = -me->arr[i];
+
+	for(int i = 0; i < 4; i++)
+		me->arr[i] /= dot;
+}
+
+void oquatd_diff(const quatd* me, const quatd* q, quatd* out_q)
+{
+	quatd inv = *me;
+	oquatd_inverse(&inv);
+	oquatd_mult(&inv, q, out_q);
+}
+
+void oquatd_get_mat4x4(const quatd* me, const vec3d* point, double mat[4][4])
+{
+	mat[0][0] = 1 - 2 * me->y * me->y - 2 * me->z * me->z;
+	mat[0][1] =     2 * me->x * me->y - 2 * me->w * me->z;
+	mat[0][2] =     2 * me->x * me->z + 2 * me->w * me->y;
+	mat[0][3] = point->x;
+
+	mat[1][0] =     2 * me->x * me->y + 2 * me->w * me->z;
+	mat[1][1] = 1 - 2 * me->x * me->x - 2 * me->z * me->z;
+	mat[1][2] =     2 * me->y * me->z - 2 * me->w * me->x;
+	mat[1][3] = point->y;
+
+	mat[2][0] =     2 * me->x * me->z - 2 * me->w * me->y;
+	mat[2][1] =     2 * me->y * me->z + 2 * me->w * me->x;
+	mat[2][2] = 1 - 2 * me->x * me->x - 2 * me->y * me->y;
+	mat[2][3] = point->z;
+
+	mat[3][0] = 0;
+	mat[3][1] = 0;
+	mat[3][2] = 0;
+	mat[3][3] = 1;
+}
+
+void oquatd_from_quatf(quatd* me, const quatf* q)
+{
+	for(int i = 0; i < 4; i++)
+		me->arr[i] = q->arr[i];
+}
+
+void oquatd_get_quatf(const quatd* me, quatf* out_q)
+{
+	for(int i = 0; i < 4; i++)
+		out_q->arr[i] = (float)me->arr[i];
+}
+
+void omat4x4d_init_ident(mat4x4d* me)
+{
+	memset(me, 0, sizeof(*me));
+	me->m[0][0] = 1.0;
+	me->m[1][1] = 1.0;
+	me->m[2][2] = 1.0;
+	me->m[3][3] = 1.0;
+}
+
+void omat4x4d_init_translate(mat4x4d* me, double x, double y, double z)
+{
+	omat4x4d_init_ident(me);
+	me->m[0][3] = x;
+	me->m[1][3] = y;
+	me->m[2][3] = z;
+}
+
+void omat4x4d_mult(const mat4x4d* l, const mat4x4d* r, mat4x4d* o)
 {
 	for(int i = 0; i < 4; i++){
-		float a0 = l->m[i][0], a1 = l->m[i][1], a2 = l->m[i][2], a3 = l->m[i][3];
+		double a0 = l->m[i][0], a1 = l->m[i][1], a2 = l->m[i][2], a3 = l->m[i][3];
 		o->m[i][0] = a0 * r->m[0][0] + a1 * r->m[1][0] + a2 * r->m[2][0] + a3 * r->m[3][0];
 		o->m[i][1] = a0 * r->m[0][1] + a1 * r->m[1][1] + a2 * r->m[2][1] + a3 * r->m[3][1];
 		o->m[i][2] = a0 * r->m[0][2] + a1 * r->m[1][2] + a2 * r->m[2][2] + a3 * r->m[3][2];
@@ -365,6 +634,19 @@ void omat4x4f_mult(const mat4x4f* l, const mat4x4f* r, mat4x4f *o)
 	}
 }
 
+void omat4x4d_transpose(const mat4x4d* m, mat4x4d* o)
+{
+	for(int i = 0; i < 4; i++)
+		for(int j = 0; j < 4; j++)
+			o->m[j][i] = m->m[i][j];
+}
+
+void omat4x4d_get_mat4x4f(const mat4x4d* me, mat4x4f* out_mat)
+{
+	for(int i = 0; i < 16; i++)
+		out_mat->arr[i] = (float)me->arr[i];
+}
+
 
 // filter queue
 
@@ -47,6 +47,7 @@ typedef union {
 } quatf;
 
 void oquatf_init_axis(quatf* me, const vec3f* vec, float angle);
+void oquatf_init_rotation_vector(quatf* me, const vec3f* rot_vec); // axis times angle, no trig for small angles
 
 void oquatf_get_rotated(const quatf* me, const vec3f* vec, vec3f* out_vec);
 void oquatf_mult_me(quatf* me, const quatf* q);
@@ -69,11 +70,95 @@ typedef union {
 void omat4x4f_init_ident(mat4x4f* me);
 void omat4x4f_init_perspective(mat4x4f* me, float fov_rad, float aspect, float znear, float zfar);
 void omat4x4f_init_frustum(mat4x4f* me, float left, float right, float bottom, float top, float znear, float zfar);
+
+// depth mapping options for omat4x4f_init_frustum_tangents, the same values as ohmd_projection_flags
+#define OMATH_PROJ_REVERSE_Z 1 // depth is 1 at the near plane and 0 (or -1) at the far plane
+#define OMATH_PROJ_INFINITE_FAR 2 // no far plane, zfar is ignored
+#define OMATH_PROJ_ZERO_TO_ONE 4 // clip space depth in [0, 1] instead of [-1, 1]
+
+// frustum given by the tangents of the angles to its edges, left and bottom negative
+void omat4x4f_init_frustum_tangents(mat4x4f* me, float left, float right, float bottom, float top, float znear, float zfar, int flags);
 void omat4x4f_init_look_at(mat4x4f* me, const quatf* ret, const vec3f* eye);
 void omat4x4f_init_translate(mat4x4f* me, float x, float y, float z);
 void omat4x4f_mult(const mat4x4f* left, const mat4x4f* right, mat4x4f* out_mat);
 void omat4x4f_transpose(const mat4x4f* me, mat4x4f* out_mat);
 
+// view matrices for both eyes of a head at rot and pos, the same as look_at followed by a
+// translation of -pos -+ ipd / 2, as column major (OpenGL) 4x4 or row major 3x4 affine
+void omat4x4f_init_eye_views_gl(const quatf* rot, const vec3f* pos, float ipd, float left[16], float right[16]);
+void omat3x4f_init_eye_views(const quatf* rot, const vec3f* pos, float ipd, float left[12], float right[12]);
+
+// point arrays transformed by the upper 3x4 part of a row major matrix, in and out may be the same array,
+// aos is x0 y0 z0 x1 ..., soa is count x values, then count y values, then count z values
+void omat4x4f_transform_points_aos(const mat4x4f* me, const float* in, float* out, int count);
+void omat4x4f_transform_points_soa(const mat4x4f* me, const float* in, float* out, int count);
+
+
+// double precision, for state that is accumulated over long sessions or far from the origin
+
+typedef union {
+	struct {
+		double x, y, z;
+	};
+	double arr[3];
+} vec3d;
+
+void ovec3d_normalize_me(vec3d* me);
+double ovec3d_get_length(const vec3d* me);
+double ovec3d_get_dot(const vec3d* me, const vec3d* vec);
+void ovec3d_subtract(const vec3d* a, const vec3d* b, vec3d* out);
+void ovec3d_from_vec3f(vec3d* me, const vec3f* vec);
+void ovec3d_get_vec3f(const vec3d* me, vec3f* out_vec);
+
+typedef union {
+	struct {
+		double x, y, z, w;
+	};
+	double arr[4];
+} quatd;
+
+void oquatd_init_axis(quatd* me, const vec3d* vec, double angle);
+void oquatd_init_rotation_vector(quatd* me, const vec3d* rot_vec);
+void oquatd_get_rotated(const quatd* me, const vec3d* vec, vec3d* out_vec);
+void oquatd_mult_me(quatd* me, const quatd* q);
+void oquatd_mult(const quatd* me, const quatd* q, quatd* out_q);
+void oquatd_diff(const quatd* me, const quatd* q, quatd* out_q);
+void oquatd_normalize_me(quatd* me);
+double oquatd_get_length(const quatd* me);
+double oquatd_get_dot(const quatd* me, const quatd* q);
+void oquatd_inverse(quatd* me);
+void oquatd_get_mat4x4(const quatd* me, const vec3d* point, double mat[4][4]);
+void oquatd_from_quatf(quatd* me, const quatf* q);
+void oquatd_get_quatf(const quatd* me, quatf* out_q);
+
+typedef union {
+	double m[4][4];
+	double arr[16];
+} mat4x4d;
+
+void omat4x4d_init_ident(mat4x4d* me);
+void omat4x4d_init_translate(mat4x4d* me, double x, double y, double z);
+void omat4x4d_mult(const mat4x4d* left, const mat4x4d* right, mat4x4d* out_mat);
+void omat4x4d_transpose(const mat4x4d* me, mat4x4d* out_mat);
+void omat4x4d_get_mat4x4f(const mat4x4d* me, mat4x4f* out_mat);
+
+
+// SIMD implementation selection, the best one for the CPU is picked by omath_init_impl
+
+typedef enum {
+	OMATH_IMPL_SCALAR = 0,
+	OMATH_IMPL_SSE2,
+	OMATH_IMPL_SSE41,
+	OMATH_IMPL_AVX,
+	OMATH_IMPL_NEON,
+	OMATH_IMPL_COUNT
+} omath_impl;
+
+void omath_init_impl(void); // only selects on the first call
+int omath_set_impl(omath_impl impl); // -1 if not supported by this build or CPU, for tests and benchmarks only
+omath_impl omath_get_impl(void);
+const char* omath_get_impl_name(omath_impl impl);
+
 
 // filter queue
 #define FILTER_QUEUE_MAX_SIZE 256
@@ -87,4 +172,6 @@ void ofq_init(filter_queue* me, int size);
 void ofq_add(filter_queue* me, const vec3f* vec);
 void ofq_get_mean(const filter_queue* me, vec3f* vec);
 
+#include "omath_inline.h"
+
 #endif
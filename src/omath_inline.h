@@ -0,0 +1,157 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Math - Inline Versions */
+
+#ifndef OMATH_INLINE_H
+#define OMATH_INLINE_H
+
+/*
+ * Inline versions of the small vector and quaternion functions on the per
+ * sample fusion path. When the library is built with OMATH_INLINE, calls to
+ * the functions below are mapped to these, so the compiler can optimize across
+ * them. The exported functions stay available and share these definitions.
+ *
+ * The inline quaternion functions are always the scalar ones, at this size a
+ * call into the SIMD kernels costs more than it saves. OMATH_INLINE is on by
+ * default, so ofusion_update doesn't use the SIMD quaternion kernels at all,
+ * see omath_simd.h.
+ */
+
+static inline float ovec3f_get_length_inline(const vec3f* me)
+{
+	return sqrtf(POW2(me->x) + POW2(me->y) + POW2(me->z));
+}
+
+static inline void ovec3f_normalize_me_inline(vec3f* me)
+{
+	if(me->x == 0 && me->y == 0 && me->z == 0)
+		return;
+
+	float len = ovec3f_get_length_inline(me);
+	me->x /= len;
+	me->y /= len;
+	me->z /= len;
+}
+
+static inline void ovec3f_subtract_inline(const vec3f* a, const vec3f* b, vec3f* out)
+{
+	for(int i = 0; i < 3; i++)
+		out->arr[i] = a->arr[i] - b->arr[i];
+}
+
+static inline float ovec3f_get_dot_inline(const vec3f* me, const vec3f* vec)
+{
+	return me->x * vec->x + me->y * vec->y + me->z * vec->z;
+}
+
+static inline void oquatf_init_axis_inline(quatf* me, const vec3f* vec, float angle)
+{
+	vec3f norm = *vec;
+	ovec3f_normalize_me_inline(&norm);
+
+	float s = sinf(angle / 2.0f);
+
+	me->x = norm.x * s;
+	me->y = norm.y * s;
+	me->z = norm.z * s;
+	me->w = cosf(angle / 2.0f);
+}
+
+/*
+ * Rotation from a rotation vector (axis times angle), the exponential map.
+ * Below OMATH_SMALL_ANGLE the cosine and sinc terms are evaluated as their
+ * series in angle^2, cut after the angle^4 term. The first dropped terms are
+ * angle^6 / 46080 for w and angle^7 / 645120 for the vector part, at 0.25 rad
+ * that is below 6e-9, under the rounding error of a float around 1. Gyro
+ * samples stay far below that, 2000 deg/s at 1 kHz is 0.035 rad.
+ */
+#define OMATH_SMALL_ANGLE 0.25f
+
+static inline void oquatf_init_rotation_vector_inline(quatf* me, const vec3f* rot_vec)
+{
+	float a2 = POW2(rot_vec->x) + POW2(rot_vec->y) + POW2(rot_vec->z);
+	float c, s;
+
+	if(a2 < POW2(OMATH_SMALL_ANGLE)){
+		// cos(a / 2) and sin(a / 2) / a
+		c = 1.0f + a2 * (-1.0f / 8.0f + a2 * (1.0f / 384.0f));
+		s = 0.5f + a2 * (-1.0f / 48.0f + a2 * (1.0f / 3840.0f));
+	}else{
+		float a = sqrtf(a2);
+		c = cosf(a / 2.0f);
+		s = sinf(a / 2.0f) / a;
+	}
+
+	me->x = rot_vec->x * s;
+	me->y = rot_vec->y * s;
+	me->z = rot_vec->z * s;
+	me->w = c;
+}
+
+static inline void oquatf_get_rotated_inline(const quatf* me, const vec3f* vec, vec3f* out_vec)
+{
+	quatf q = {{vec->x * me->w + vec->z * me->y - vec->y * me->z,
+	            vec->y * me->w + vec->x * me->z - vec->z * me->x,
+	            vec->z * me->w + vec->y * me->x - vec->x * me->y,
+	            vec->x * me->x + vec->y * me->y + vec->z * me->z}};
+
+	out_vec->x = me->w * q.x + me->x * q.w + me->y * q.z - me->z * q.y;
+	out_vec->y = me->w * q.y + me->y * q.w + me->z * q.x - me->x * q.z;
+	out_vec->z = me->w * q.z + me->z * q.w + me->x * q.y - me->y * q.x;
+}
+
+static inline void oquatf_mult_inline(const quatf* me, const quatf* q, quatf* out_q)
+{
+	out_q->x = me->w * q->x + me->x * q->w + me->y * q->z - me->z * q->y;
+	out_q->y = me->w * q->y - me->x * q->z + me->y * q->w + me->z * q->x;
+	out_q->z = me->w * q->z + me->x * q->y - me->y * q->x + me->z * q->w;
+	out_q->w = me->w * q->w - me->x * q->x - me->y * q->y - me->z * q->z;
+}
+
+static inline void oquatf_mult_me_inline(quatf* me, const quatf* q)
+{
+	quatf tmp = *me;
+	oquatf_mult_inline(&tmp, q, me);
+}
+
+static inline float oquatf_get_length_inline(const quatf* me)
+{
+	return sqrtf(me->x * me->x + me->y * me->y + me->z * me->z + me->w * me->w);
+}
+
+static inline float oquatf_get_dot_inline(const quatf* me, const quatf* q)
+{
+	return me->x * q->x + me->y * q->y + me->z * q->z + me->w * q->w;
+}
+
+static inline void oquatf_normalize_me_inline(quatf* me)
+{
+	float len = oquatf_get_length_inline(me);
+	me->x /= len;
+	me->y /= len;
+	me->z /= len;
+	me->w /= len;
+}
+
+// omath.c defines OMATH_IMPLEMENTATION to keep the exported definitions under their own names
+#if defined(OMATH_INLINE) && !defined(OMATH_IMPLEMENTATION)
+#define ovec3f_get_length(_me) ovec3f_get_length_inline(_me)
+#define ovec3f_normalize_me(_me) ovec3f_normalize_me_inline(_me)
+#define ovec3f_subtract(_a, _b, _out) ovec3f_subtract_inline(_a, _b, _out)
+#define ovec3f_get_dot(_me, _vec) ovec3f_get_dot_inline(_me, _vec)
+#define oquatf_init_axis(_me, _vec, _angle) oquatf_init_axis_inline(_me, _vec, _angle)
+#define oquatf_init_rotation_vector(_me, _rot_vec) oquatf_init_rotation_vector_inline(_me, _rot_vec)
+#define oquatf_get_rotated(_me, _vec, _out) oquatf_get_rotated_inline(_me, _vec, _out)
+#define oquatf_mult(_me, _q, _out) oquatf_mult_inline(_me, _q, _out)
+#define oquatf_mult_me(_me, _q) oquatf_mult_me_inline(_me, _q)
+#define oquatf_get_length(_me) oquatf_get_length_inline(_me)
+#define oquatf_get_dot(_me, _q) oquatf_get_dot_inline(_me, _q)
+#define oquatf_normalize_me(_me) oquatf_normalize_me_inline(_me)
+#endif
+
+#endif
@@ -0,0 +1,625 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Math - SIMD Kernels With Runtime Dispatch */
+
+#define OMATH_IMPLEMENTATION
+
+#include <string.h>
+#include "openhmdi.h"
+#include "omath_simd.h"
+
+/*
+ * Every x86 variant is built into the library with per function target
+ * attributes and picked at runtime from what the CPU reports, so the library
+ * itself doesn't have to be built for a newer CPU than it runs on. NEON is
+ * picked at compile time, it's part of the baseline wherever it's enabled.
+ *
+ * The SIMD variants round differently than the scalar code in places (sum
+ * order, reciprocal multiply instead of divide), results agree within a few
+ * ULP, see tests/unittests/simd.c.
+ */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define OMATH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OMATH_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define OMATH_TARGET(_t) __attribute__((target(_t)))
+#else
+#define OMATH_TARGET(_t)
+#endif
+
+
+// scalar
+
+static void scalar_quat_mult(const quatf* me, const quatf* q, quatf* out_q)
+{
+	oquatf_mult_inline(me, q, out_q);
+}
+
+static void scalar_quat_get_rotated(const quatf* me, const vec3f* vec, vec3f* out_vec)
+{
+	oquatf_get_rotated_inline(me, vec, out_vec);
+}
+
+static void scalar_quat_normalize_me(quatf* me)
+{
+	oquatf_normalize_me_inline(me);
+}
+
+static void scalar_mat_mult(const mat4x4f* l, const mat4x4f* r, mat4x4f* o)
+{
+	for(int i = 0; i < 4; i++){
+		float a0 = l->m[i][0], a1 = l->m[i][1], a2 = l->m[i][2], a3 = l->m[i][3];
+		o->m[i][0] = a0 * r->m[0][0] + a1 * r->m[1][0] + a2 * r->m[2][0] + a3 * r->m[3][0];
+		o->m[i][1] = a0 * r->m[0][1] + a1 * r->m[1][1] + a2 * r->m[2][1] + a3 * r->m[3][1];
+		o->m[i][2] = a0 * r->m[0][2] + a1 * r->m[1][2] + a2 * r->m[2][2] + a3 * r->m[3][2];
+		o->m[i][3] = a0 * r->m[0][3] + a1 * r->m[1][3] + a2 * r->m[2][3] + a3 * r->m[3][3];
+	}
+}
+
+static void scalar_mat_transpose(const mat4x4f* m, mat4x4f* o)
+{
+	for(int i = 0; i < 4; i++)
+		for(int j = 0; j < 4; j++)
+			o->m[j][i] = m->m[i][j];
+}
+
+static inline void scalar_point_transform(const float* m, float x, float y, float z, float* ox, float* oy, float* oz)
+{
+	*ox = m[0] * x + m[1] * y + m[2] * z + m[3];
+	*oy = m[4] * x + m[5] * y + m[6] * z + m[7];
+	*oz = m[8] * x + m[9] * y + m[10] * z + m[11];
+}
+
+static void scalar_points_transform_aos(const float m[12], const float* in, float* out, int count)
+{
+	for(int i = 0; i < count; i++, in += 3, out += 3)
+		scalar_point_transform(m, in[0], in[1], in[2], out, out + 1, out + 2);
+}
+
+static void scalar_points_transform_soa(const float m[12], const float* in, float* out, int count)
+{
+	for(int i = 0; i < count; i++)
+		scalar_point_transform(m, in[i], in[i + count], in[i + 2 * count], out + i, out + i + count, out + i + 2 * count);
+}
+
+static const omath_kernels scalar_kernels = {
+	scalar_quat_mult,
+	scalar_quat_get_rotated,
+	scalar_quat_normalize_me,
+	scalar_mat_mult,
+	scalar_mat_transpose,
+	scalar_points_transform_aos,
+	scalar_points_transform_soa,
+};
+
+
+#ifdef OMATH_X86
+
+// sse2
+
+// vec3f is only 12 bytes, so never load or store it as a full register
+OMATH_TARGET("sse2") static inline __m128 sse2_load_vec3(const vec3f* v)
+{
+	return _mm_set_ps(0, v->z, v->y, v->x);
+}
+
+// separate stores, so element loads right after can be forwarded from them
+OMATH_TARGET("sse2") static inline void sse2_store_vec3(vec3f* v, __m128 r)
+{
+	_mm_store_ss(&v->x, r);
+	_mm_store_ss(&v->y, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1)));
+	_mm_store_ss(&v->z, _mm_movehl_ps(r, r));
+}
+
+// a.yzx * b.zxy - a.zxy * b.yzx
+OMATH_TARGET("sse2") static inline __m128 sse2_cross(__m128 a, __m128 b)
+{
+	__m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+OMATH_TARGET("sse2") static inline __m128 sse2_quat_mult(__m128 a, __m128 b)
+{
+	// out = a.w * b + a.x * b.wzyx * (+-+-) + a.y * b.zwxy * (++--) + a.z * b.yxwz * (-++-)
+	const __m128 sign_x = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+	const __m128 sign_y = _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f);
+	const __m128 sign_z = _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+
+	__m128 b_wzyx = _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)), sign_x);
+	__m128 b_zwxy = _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)), sign_y);
+	__m128 b_yxwz = _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)), sign_z);
+
+	__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b_wzyx));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b_zwxy));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b_yxwz));
+	return r;
+}
+
+OMATH_TARGET("sse2") static void sse2_quat_mult_k(const quatf* me, const quatf* q, quatf* out_q)
+{
+	_mm_storeu_ps(out_q->arr, sse2_quat_mult(_mm_loadu_ps(me->arr), _mm_loadu_ps(q->arr)));
+}
+
+OMATH_TARGET("sse2") static void sse2_quat_get_rotated(const quatf* me, const vec3f* vec, vec3f* out_vec)
+{
+	// v + w * t + cross(u, t) with t = 2 * cross(u, v)
+	__m128 q = _mm_loadu_ps(me->arr);
+	__m128 v = sse2_load_vec3(vec);
+	__m128 u = _mm_and_ps(q, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+	__m128 w = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3));
+
+	__m128 t = sse2_cross(u, v);
+	t = _mm_add_ps(t, t);
+
+	__m128 r = _mm_add_ps(v, _mm_add_ps(_mm_mul_ps(w, t), sse2_cross(u, t)));
+	sse2_store_vec3(out_vec, r);
+}
+
+OMATH_TARGET("sse2") static void sse2_quat_normalize_me(quatf* me)
+{
+	__m128 q = _mm_loadu_ps(me->arr);
+	__m128 d = _mm_mul_ps(q, q);
+	d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+	d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+	_mm_storeu_ps(me->arr, _mm_div_ps(q, _mm_sqrt_ps(d)));
+}
+
+OMATH_TARGET("sse2") static void sse2_mat_mult(const mat4x4f* l, const mat4x4f* r, mat4x4f* o)
+{
+	__m128 r0 = _mm_loadu_ps(r->m[0]), r1 = _mm_loadu_ps(r->m[1]);
+	__m128 r2 = _mm_loadu_ps(r->m[2]), r3 = _mm_loadu_ps(r->m[3]);
+	__m128 out[4];
+
+	for(int i = 0; i < 4; i++){
+		__m128 a = _mm_mul_ps(_mm_set1_ps(l->m[i][0]), r0);
+		a = _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(l->m[i][1]), r1));
+		a = _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(l->m[i][2]), r2));
+		a = _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(l->m[i][3]), r3));
+		out[i] = a;
+	}
+
+	// the output may alias either input
+	for(int i = 0; i < 4; i++)
+		_mm_storeu_ps(o->m[i], out[i]);
+}
+
+OMATH_TARGET("sse2") static void sse2_mat_transpose(const mat4x4f* m, mat4x4f* o)
+{
+	__m128 r0 = _mm_loadu_ps(m->m[0]), r1 = _mm_loadu_ps(m->m[1]);
+	__m128 r2 = _mm_loadu_ps(m->m[2]), r3 = _mm_loadu_ps(m->m[3]);
+
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+	_mm_storeu_ps(o->m[0], r0);
+	_mm_storeu_ps(o->m[1], r1);
+	_mm_storeu_ps(o->m[2], r2);
+	_mm_storeu_ps(o->m[3], r3);
+}
+
+// out = m * (x, y, z, 1) for four points at once
+#define SSE2_TRANSFORM4(_m, _x, _y, _z, _ox, _oy, _oz) \
+	_ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_m[0], _x), _mm_mul_ps(_m[1], _y)), _mm_add_ps(_mm_mul_ps(_m[2], _z), _m[3])); \
+	_oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_m[4], _x), _mm_mul_ps(_m[5], _y)), _mm_add_ps(_mm_mul_ps(_m[6], _z), _m[7])); \
+	_oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_m[8], _x), _mm_mul_ps(_m[9], _y)), _mm_add_ps(_mm_mul_ps(_m[10], _z), _m[11]));
+
+OMATH_TARGET("sse2") static void sse2_points_transform_aos(const float m[12], const float* in, float* out, int count)
+{
+	__m128 mv[12];
+	for(int i = 0; i < 12; i++)
+		mv[i] = _mm_set1_ps(m[i]);
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4, in += 12, out += 12){
+		// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+		__m128 a = _mm_loadu_ps(in), b = _mm_loadu_ps(in + 4), c = _mm_loadu_ps(in + 8);
+
+		__m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		__m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+		                          _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+
+		__m128 ox, oy, oz;
+		SSE2_TRANSFORM4(mv, x, y, z, ox, oy, oz);
+
+		__m128 xy_lo = _mm_unpacklo_ps(ox, oy), xy_hi = _mm_unpackhi_ps(ox, oy);
+		a = _mm_shuffle_ps(xy_lo, _mm_shuffle_ps(oz, ox, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0));
+		b = _mm_shuffle_ps(_mm_shuffle_ps(oy, oz, _MM_SHUFFLE(1, 1, 1, 1)), xy_hi, _MM_SHUFFLE(1, 0, 2, 0));
+		c = _mm_shuffle_ps(oz, xy_hi, _MM_SHUFFLE(3, 2, 3, 2));
+		c = _mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 3, 2, 0));
+
+		_mm_storeu_ps(out, a);
+		_mm_storeu_ps(out + 4, b);
+		_mm_storeu_ps(out + 8, c);
+	}
+
+	scalar_points_transform_aos(m, in, out, count - i);
+}
+
+OMATH_TARGET("sse2") static void sse2_points_transform_soa(const float m[12], const float* in, float* out, int count)
+{
+	__m128 mv[12];
+	for(int i = 0; i < 12; i++)
+		mv[i] = _mm_set1_ps(m[i]);
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4){
+		__m128 x = _mm_loadu_ps(in + i), y = _mm_loadu_ps(in + i + count), z = _mm_loadu_ps(in + i + 2 * count);
+
+		__m128 ox, oy, oz;
+		SSE2_TRANSFORM4(mv, x, y, z, ox, oy, oz);
+
+		_mm_storeu_ps(out + i, ox);
+		_mm_storeu_ps(out + i + count, oy);
+		_mm_storeu_ps(out + i + 2 * count, oz);
+	}
+
+	for(; i < count; i++)
+		scalar_point_transform(m, in[i], in[i + count], in[i + 2 * count], out + i, out + i + count, out + i + 2 * count);
+}
+
+static const omath_kernels sse2_kernels = {
+	sse2_quat_mult_k,
+	sse2_quat_get_rotated,
+	sse2_quat_normalize_me,
+	sse2_mat_mult,
+	sse2_mat_transpose,
+	sse2_points_transform_aos,
+	sse2_points_transform_soa,
+};
+
+
+// sse4.1, a single dot product instruction for the length
+
+OMATH_TARGET("sse4.1") static void sse41_quat_normalize_me(quatf* me)
+{
+	__m128 q = _mm_loadu_ps(me->arr);
+	_mm_storeu_ps(me->arr, _mm_div_ps(q, _mm_sqrt_ps(_mm_dp_ps(q, q, 0xff))));
+}
+
+static const omath_kernels sse41_kernels = {
+	sse2_quat_mult_k,
+	sse2_quat_get_rotated,
+	sse41_quat_normalize_me,
+	sse2_mat_mult,
+	sse2_mat_transpose,
+	sse2_points_transform_aos,
+	sse2_points_transform_soa,
+};
+
+
+// avx, two matrix rows per register
+
+OMATH_TARGET("avx") static void avx_mat_mult(const mat4x4f* l, const mat4x4f* r, mat4x4f* o)
+{
+	__m256 r0 = _mm256_broadcast_ps((const __m128*)r->m[0]);
+	__m256 r1 = _mm256_broadcast_ps((const __m128*)r->m[1]);
+	__m256 r2 = _mm256_broadcast_ps((const __m128*)r->m[2]);
+	__m256 r3 = _mm256_broadcast_ps((const __m128*)r->m[3]);
+
+	__m256 a01 = _mm256_loadu_ps(l->m[0]);
+	__m256 a23 = _mm256_loadu_ps(l->m[2]);
+
+	__m256 o01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+	o01 = _mm256_add_ps(o01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(1, 1, 1, 1)), r1));
+	o01 = _mm256_add_ps(o01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(2, 2, 2, 2)), r2));
+	o01 = _mm256_add_ps(o01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(3, 3, 3, 3)), r3));
+
+	__m256 o23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+	o23 = _mm256_add_ps(o23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(1, 1, 1, 1)), r1));
+	o23 = _mm256_add_ps(o23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(2, 2, 2, 2)), r2));
+	o23 = _mm256_add_ps(o23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(3, 3, 3, 3)), r3));
+
+	_mm256_storeu_ps(o->m[0], o01);
+	_mm256_storeu_ps(o->m[2], o23);
+}
+
+OMATH_TARGET("avx") static void avx_points_transform_soa(const float m[12], const float* in, float* out, int count)
+{
+	__m256 mv[12];
+	for(int i = 0; i < 12; i++)
+		mv[i] = _mm256_set1_ps(m[i]);
+
+	int i = 0;
+	for(; i + 8 <= count; i += 8){
+		__m256 x = _mm256_loadu_ps(in + i), y = _mm256_loadu_ps(in + i + count), z = _mm256_loadu_ps(in + i + 2 * count);
+
+		__m256 ox = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(mv[0], x), _mm256_mul_ps(mv[1], y)), _mm256_add_ps(_mm256_mul_ps(mv[2], z), mv[3]));
+		__m256 oy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(mv[4], x), _mm256_mul_ps(mv[5], y)), _mm256_add_ps(_mm256_mul_ps(mv[6], z), mv[7]));
+		__m256 oz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(mv[8], x), _mm256_mul_ps(mv[9], y)), _mm256_add_ps(_mm256_mul_ps(mv[10], z), mv[11]));
+
+		_mm256_storeu_ps(out + i, ox);
+		_mm256_storeu_ps(out + i + count, oy);
+		_mm256_storeu_ps(out + i + 2 * count, oz);
+	}
+
+	for(; i < count; i++)
+		scalar_point_transform(m, in[i], in[i + count], in[i + 2 * count], out + i, out + i + count, out + i + 2 * count);
+}
+
+static const omath_kernels avx_kernels = {
+	sse2_quat_mult_k,
+	sse2_quat_get_rotated,
+	sse41_quat_normalize_me,
+	avx_mat_mult,
+	sse2_mat_transpose,
+	sse2_points_transform_aos,
+	avx_points_transform_soa,
+};
+
+
+// cpu feature detection
+
+static void cpu_features(bool* sse2, bool* sse41, bool* avx)
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	*sse2 = (info[3] >> 26) & 1;
+	*sse41 = (info[2] >> 19) & 1;
+
+	// avx also needs the os to save the upper register halves
+	bool osxsave = (info[2] >> 27) & 1;
+	*avx = ((info[2] >> 28) & 1) && osxsave && (_xgetbv(0) & 6) == 6;
+#elif defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	*sse2 = __builtin_cpu_supports("sse2");
+	*sse41 = __builtin_cpu_supports("sse4.1");
+	*avx = __builtin_cpu_supports("avx");
+#else
+	*sse2 = *sse41 = *avx = false;
+#endif
+}
+
+#endif // OMATH_X86
+
+
+#ifdef OMATH_NEON
+
+// neon
+
+static inline float32x4_t neon_quat_mult(float32x4_t a, float32x4_t b)
+{
+	// same decomposition as the sse2 version, signs applied by multiplying with +-1
+	static const float sign_x[4] = { 1, -1, 1, -1 };
+	static const float sign_y[4] = { 1, 1, -1, -1 };
+	static const float sign_z[4] = { -1, 1, 1, -1 };
+
+	float32x4_t b_zwxy = vextq_f32(b, b, 2);
+	float32x4_t b_yxwz = vrev64q_f32(b);
+	float32x4_t b_wzyx = vrev64q_f32(b_zwxy);
+
+	float32x4_t r = vmulq_n_f32(b, vgetq_lane_f32(a, 3));
+	r = vaddq_f32(r, vmulq_n_f32(vmulq_f32(b_wzyx, vld1q_f32(sign_x)), vgetq_lane_f32(a, 0)));
+	r = vaddq_f32(r, vmulq_n_f32(vmulq_f32(b_zwxy, vld1q_f32(sign_y)), vgetq_lane_f32(a, 1)));
+	r = vaddq_f32(r, vmulq_n_f32(vmulq_f32(b_yxwz, vld1q_f32(sign_z)), vgetq_lane_f32(a, 2)));
+	return r;
+}
+
+static void neon_quat_mult_k(const quatf* me, const quatf* q, quatf* out_q)
+{
+	vst1q_f32(out_q->arr, neon_quat_mult(vld1q_f32(me->arr), vld1q_f32(q->arr)));
+}
+
+static void neon_quat_normalize_me(quatf* me)
+{
+	float32x4_t q = vld1q_f32(me->arr);
+	float32x4_t d = vmulq_f32(q, q);
+	float32x2_t s = vadd_f32(vget_low_f32(d), vget_high_f32(d));
+	s = vpadd_f32(s, s);
+
+	vst1q_f32(me->arr, vmulq_n_f32(q, 1.0f / sqrtf(vget_lane_f32(s, 0))));
+}
+
+static void neon_mat_mult(const mat4x4f* l, const mat4x4f* r, mat4x4f* o)
+{
+	float32x4_t r0 = vld1q_f32(r->m[0]), r1 = vld1q_f32(r->m[1]);
+	float32x4_t r2 = vld1q_f32(r->m[2]), r3 = vld1q_f32(r->m[3]);
+	float32x4_t out[4];
+
+	for(int i = 0; i < 4; i++){
+		float32x4_t a = vmulq_n_f32(r0, l->m[i][0]);
+		a = vaddq_f32(a, vmulq_n_f32(r1, l->m[i][1]));
+		a = vaddq_f32(a, vmulq_n_f32(r2, l->m[i][2]));
+		a = vaddq_f32(a, vmulq_n_f32(r3, l->m[i][3]));
+		out[i] = a;
+	}
+
+	for(int i = 0; i < 4; i++)
+		vst1q_f32(o->m[i], out[i]);
+}
+
+static void neon_mat_transpose(const mat4x4f* m, mat4x4f* o)
+{
+	// a de-interleaving load yields the columns
+	float32x4x4_t c = vld4q_f32(m->arr);
+
+	vst1q_f32(o->m[0], c.val[0]);
+	vst1q_f32(o->m[1], c.val[1]);
+	vst1q_f32(o->m[2], c.val[2]);
+	vst1q_f32(o->m[3], c.val[3]);
+}
+
+#define NEON_TRANSFORM4(_m, _x, _y, _z, _ox, _oy, _oz) \
+	_ox = vaddq_f32(vaddq_f32(vmulq_n_f32(_x, _m[0]), vmulq_n_f32(_y, _m[1])), vaddq_f32(vmulq_n_f32(_z, _m[2]), vdupq_n_f32(_m[3]))); \
+	_oy = vaddq_f32(vaddq_f32(vmulq_n_f32(_x, _m[4]), vmulq_n_f32(_y, _m[5])), vaddq_f32(vmulq_n_f32(_z, _m[6]), vdupq_n_f32(_m[7]))); \
+	_oz = vaddq_f32(vaddq_f32(vmulq_n_f32(_x, _m[8]), vmulq_n_f32(_y, _m[9])), vaddq_f32(vmulq_n_f32(_z, _m[10]), vdupq_n_f32(_m[11])));
+
+static void neon_points_transform_aos(const float m[12], const float* in, float* out, int count)
+{
+	int i = 0;
+	for(; i + 4 <= count; i += 4, in += 12, out += 12){
+		// de-interleaving load and interleaving store handle the layout
+		float32x4x3_t p = vld3q_f32(in), o;
+		NEON_TRANSFORM4(m, p.val[0], p.val[1], p.val[2], o.val[0], o.val[1], o.val[2]);
+		vst3q_f32(out, o);
+	}
+
+	scalar_points_transform_aos(m, in, out, count - i);
+}
+
+static void neon_points_transform_soa(const float m[12], const float* in, float* out, int count)
+{
+	int i = 0;
+	for(; i + 4 <= count; i += 4){
+		float32x4_t x = vld1q_f32(in + i), y = vld1q_f32(in + i + count), z = vld1q_f32(in + i + 2 * count);
+		float32x4_t ox, oy, oz;
+		NEON_TRANSFORM4(m, x, y, z, ox, oy, oz);
+
+		vst1q_f32(out + i, ox);
+		vst1q_f32(out + i + count, oy);
+		vst1q_f32(out + i + 2 * count, oz);
+	}
+
+	for(; i < count; i++)
+		scalar_point_transform(m, in[i], in[i + count], in[i + 2 * count], out + i, out + i + count, out + i + 2 * count);
+}
+
+static const omath_kernels neon_kernels = {
+	neon_quat_mult_k,
+	scalar_quat_get_rotated,
+	neon_quat_normalize_me,
+	neon_mat_mult,
+	neon_mat_transpose,
+	neon_points_transform_aos,
+	neon_points_transform_soa,
+};
+
+#endif // OMATH_NEON
+
+
+// dispatch
+
+const omath_kernels* omath_active_kernels = &scalar_kernels;
+static omath_impl active_impl = OMATH_IMPL_SCALAR;
+
+static const omath_kernels* get_kernels(omath_impl impl)
+{
+#ifdef OMATH_X86
+	bool sse2, sse41, avx;
+	cpu_features(&sse2, &sse41, &avx);
+#endif
+
+	switch(impl){
+	case OMATH_IMPL_SCALAR:
+		return &scalar_kernels;
+
+#ifdef OMATH_X86
+	case OMATH_IMPL_SSE2:
+		return sse2 ? &sse2_kernels : NULL;
+
+	case OMATH_IMPL_SSE41:
+		return sse2 && sse41 ? &sse41_kernels : NULL;
+
+	case OMATH_IMPL_AVX:
+		return sse2 && sse41 && avx ? &avx_kernels : NULL;
+#endif
+
+#ifdef OMATH_NEON
+	case OMATH_IMPL_NEON:
+		return &neon_kernels;
+#endif
+
+	default:
+		return NULL;
+	}
+}
+
+int omath_set_impl(omath_impl impl)
+{
+	const omath_kernels* kernels = get_kernels(impl);
+	if(!kernels)
+		return -1;
+
+	omath_active_kernels = kernels;
+	active_impl = impl;
+
+	return 0;
+}
+
+omath_impl omath_get_impl(void)
+{
+	return active_impl;
+}
+
+const char* omath_get_impl_name(omath_impl impl)
+{
+	switch(impl){
+	case OMATH_IMPL_SCALAR: return "scalar";
+	case OMATH_IMPL_SSE2: return "sse2";
+	case OMATH_IMPL_SSE41: return "sse4.1";
+	case OMATH_IMPL_AVX: return "avx";
+	case OMATH_IMPL_NEON: return "neon";
+	default: return "unknown";
+	}
+}
+
+static void select_best_impl(void)
+{
+	// best first
+	static const omath_impl order[] = {
+		OMATH_IMPL_AVX, OMATH_IMPL_SSE41, OMATH_IMPL_SSE2, OMATH_IMPL_NEON, OMATH_IMPL_SCALAR
+	};
+
+	for(int i = 0; i < sizeof(order) / sizeof(order[0]); i++){
+		if(omath_set_impl(order[i]) == 0)
+			return;
+	}
+}
+
+/*
+ * Contexts are created while other contexts' update threads are reading the
+ * kernels, so the selection only ever happens once per process. Callers racing
+ * the first one wait for it to finish.
+ */
+
+#ifdef _WIN32
+
+static INIT_ONCE init_impl_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK init_impl_routine(PINIT_ONCE once, PVOID param, PVOID* context)
+{
+	select_best_impl();
+	return TRUE;
+}
+
+void omath_init_impl(void)
+{
+	InitOnceExecuteOnce(&init_impl_once, init_impl_routine, NULL, NULL);
+}
+
+#else
+
+static pthread_once_t init_impl_once = PTHREAD_ONCE_INIT;
+
+void omath_init_impl(void)
+{
+	pthread_once(&init_impl_once, select_best_impl);
+}
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Math - SIMD Kernel Dispatch */
+
+#ifndef OMATH_SIMD_H
+#define OMATH_SIMD_H
+
+#include "omath.h"
+
+/*
+ * The hot math functions, implemented once per instruction set, behind the
+ * exported omath functions.
+ *
+ * The fusion code doesn't reach the quaternion kernels in a default build: it
+ * is built with OMATH_INLINE, which maps its quaternion calls to the scalar
+ * versions in omath_inline.h. Only builds with CMake OPENHMD_INLINE_MATH off,
+ * or configure --disable-inline-math, run ofusion_update on these.
+ */
+typedef struct {
+	void (*quat_mult)(const quatf* me, const quatf* q, quatf* out_q);
+	void (*quat_get_rotated)(const quatf* me, const vec3f* vec, vec3f* out_vec);
+	void (*quat_normalize_me)(quatf* me);
+	void (*mat_mult)(const mat4x4f* left, const mat4x4f* right, mat4x4f* out_mat);
+	void (*mat_transpose)(const mat4x4f* me, mat4x4f* out_mat);
+	void (*points_transform_aos)(const float mat[12], const float* in, float* out, int count);
+	void (*points_transform_soa)(const float mat[12], const float* in, float* out, int count);
+} omath_kernels;
+
+// kernels in use, never NULL, starts out as the scalar implementation, only written by
+// omath_init_impl and omath_set_impl
+extern const omath_kernels* omath_active_kernels;
+
+#endif
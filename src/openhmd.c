@@ -26,6 +26,9 @@ ohmd_context* OHMD_APIENTRY ohmd_ctx_create(void)
 		return NULL;
 	}
 
+	// pick the math kernels for this CPU, only the first context does
+	omath_init_impl();
+
 #if DRIVER_OCULUS_RIFT
 	ctx->drivers[ctx->num_drivers++] = ohmd_create_oculus_rift_drv(ctx);
 #endif
@@ -78,6 +81,8 @@ void OHMD_APIENTRY ohmd_ctx_destroy(ohmd_context* ctx)
 		ohmd_destroy_mutex(ctx->update_mutex);
 	}
 
+	ohmd_uring_destroy(ctx->uring);
+
 	free(ctx);
 }
 
@@ -93,6 +98,9 @@ void OHMD_APIENTRY ohmd_ctx_update(ohmd_context* ctx)
 		dev->getf(dev, OHMD_ROTATION_QUAT, (float*)&dev->rotation);
 		ohmd_unlock_mutex(ctx->update_mutex);
 	}
+
+	if(ctx->uring)
+		ohmd_uring_flush(ctx->uring);
 }
 
 const char* OHMD_APIENTRY ohmd_ctx_get_error(ohmd_context* ctx)
@@ -147,16 +155,34 @@ static unsigned int ohmd_update_thread(void* arg)
 
 	while(!ctx->update_request_quit)
 	{
+		int fds[64], num_fds = 0;
+
 		ohmd_lock_mutex(ctx->update_mutex);
 
+		ohmd_uring* uring = ctx->uring;
+
 		for(int i = 0; i < ctx->num_active_devices; i++){
-			if(ctx->active_devices[i]->settings.automatic_update && ctx->active_devices[i]->update)
-				ctx->active_devices[i]->update(ctx->active_devices[i]);
+			ohmd_device* dev = ctx->active_devices[i];
+
+			if(dev->settings.automatic_update && dev->update){
+				dev->update(dev);
+
+				for(int j = 0; j < dev->num_poll_fds && num_fds < 64; j++)
+					fds[num_fds++] = dev->poll_fds[j];
+			}
 		}
 
 		ohmd_unlock_mutex(ctx->update_mutex);
 
-		ohmd_sleep(AUTOMATIC_UPDATE_SLEEP);
+		// one system call posts the reads consumed by all devices again
+		if(uring)
+			ohmd_uring_flush(uring);
+
+		// wake up as soon as a report arrives, devices without fds are still updated every AUTOMATIC_UPDATE_SLEEP
+		if(num_fds > 0)
+			ohmd_poll_fds(fds, num_fds, AUTOMATIC_UPDATE_SLEEP);
+		else
+			ohmd_sleep(AUTOMATIC_UPDATE_SLEEP);
 	}
 
 	return 0;
@@ -189,6 +215,13 @@ ohmd_device* OHMD_APIENTRY ohmd_list_open_device_s(ohmd_context* ctx, int index,
 
 		device->settings = *settings;
 
+		if(device->settings.fusion_algorithm != OHMD_FUSION_COMPLEMENTARY){
+			if(!device->seti || device->seti(device, OHMD_FUSION_ALGORITHM, &device->settings.fusion_algorithm) != OHMD_S_OK){
+				LOGW("device doesn't support fusion algorithm %d, using the default", device->settings.fusion_algorithm);
+				device->settings.fusion_algorithm = OHMD_FUSION_COMPLEMENTARY;
+			}
+		}
+
 		device->ctx = ctx;
 		device->active_device_idx = ctx->num_active_devices;
 		ctx->active_devices[ctx->num_active_devices++] = device;
@@ -215,6 +248,7 @@ ohmd_device* OHMD_APIENTRY ohmd_list_open_device(ohmd_context* ctx, int index)
 	ohmd_device_settings settings;
 
 	settings.automatic_update = true;
+	settings.fusion_algorithm = OHMD_FUSION_COMPLEMENTARY;
 
 	return ohmd_list_open_device_s(ctx, index, &settings);
 }
@@ -245,39 +279,51 @@ int OHMD_APIENTRY ohmd_close_device(ohmd_device* device)
 	return OHMD_S_OK;
 }
 
+static void get_eye_views(ohmd_device* device, float* left, float* right, bool affine)
+{
+	quatf rot = device->rotation;
+	oquatf_mult_me(&rot, &device->rotation_correction);
+
+	if(affine)
+		omat3x4f_init_eye_views(&rot, &device->position, device->properties.ipd, left, right);
+	else
+		omat4x4f_init_eye_views_gl(&rot, &device->position, device->properties.ipd, left, right);
+}
+
 static int ohmd_device_getf_unp(ohmd_device* device, ohmd_float_value type, float* out)
 {
 	switch(type){
 	case OHMD_LEFT_EYE_GL_MODELVIEW_MATRIX: {
-			vec3f point = {{0, 0, 0}};
-			quatf rot = device->rotation;
-			quatf tmp = device->rotation_correction;
-			oquatf_mult_me(&tmp, &rot);
-			rot = tmp;
-			mat4x4f orient, world_shift, result;
-			omat4x4f_init_look_at(&orient, &rot, &point);
-			omat4x4f_init_translate(&world_shift, -device->position.x +(device->properties.ipd / 2.0f), -device->position.y, -device->position.z);
-			omat4x4f_mult(&world_shift, &orient, &result);
-			omat4x4f_transpose(&result, (mat4x4f*)out);
+			float right[16];
+			get_eye_views(device, out, right, false);
 			return OHMD_S_OK;
 		}
 	case OHMD_RIGHT_EYE_GL_MODELVIEW_MATRIX: {
-			vec3f point = {{0, 0, 0}};
-			quatf rot = device->rotation;
-			oquatf_mult_me(&rot, &device->rotation_correction);
-			mat4x4f orient, world_shift, result;
-			omat4x4f_init_look_at(&orient, &rot, &point);
-			omat4x4f_init_translate(&world_shift, -device->position.x + -(device->properties.ipd / 2.0f), -device->position.y, -device->position.z);
-			omat4x4f_mult(&world_shift, &orient, &result);
-			omat4x4f_transpose(&result, (mat4x4f*)out);
+			float left[16];
+			get_eye_views(device, left, out, false);
 			return OHMD_S_OK;
 		}
-	case OHMD_LEFT_EYE_GL_PROJECTION_MATRIX:
-		omat4x4f_transpose(&device->properties.proj_left, (mat4x4f*)out);
+	case OHMD_EYES_GL_MODELVIEW_MATRICES:
+		get_eye_views(device, out, out + 16, false);
 		return OHMD_S_OK;
-	case OHMD_RIGHT_EYE_GL_PROJECTION_MATRIX:
-		omat4x4f_transpose(&device->properties.proj_right, (mat4x4f*)out);
+	case OHMD_EYES_MODELVIEW_AFFINE:
+		get_eye_views(device, out, out + 12, true);
 		return OHMD_S_OK;
+	case OHMD_LEFT_EYE_GL_PROJECTION_MATRIX:
+	case OHMD_RIGHT_EYE_GL_PROJECTION_MATRIX: {
+			// rebuilt here rather than on every change of znear, zfar or the flags
+			if(device->properties.proj_dirty)
+				ohmd_calc_proj_matrices(&device->properties);
+
+			mat4x4f* proj = type == OHMD_LEFT_EYE_GL_PROJECTION_MATRIX ? &device->properties.proj_left : &device->properties.proj_right;
+
+			if(device->properties.proj_flags & OHMD_PROJECTION_ROW_MAJOR)
+				memcpy(out, proj, sizeof(mat4x4f));
+			else
+				omat4x4f_transpose(proj, (mat4x4f*)out);
+
+			return OHMD_S_OK;
+		}
 
 	case OHMD_SCREEN_HORIZONTAL_SIZE:
 		*out = device->properties.hsize;
@@ -366,9 +412,11 @@ int ohmd_device_setf_unp(ohmd_device* device, ohmd_float_value type, const float
 		return OHMD_S_OK;
 	case OHMD_PROJECTION_ZFAR:
 		device->properties.zfar = *in;
+		device->properties.proj_dirty = true;
 		return OHMD_S_OK;
 	case OHMD_PROJECTION_ZNEAR:
 		device->properties.znear = *in;
+		device->properties.proj_dirty = true;
 		return OHMD_S_OK;
 	case OHMD_ROTATION_QUAT:
 		{
@@ -399,6 +447,7 @@ int ohmd_device_setf_unp(ohmd_device* device, ohmd_float_value type, const float
 			return OHMD_S_OK;
 		}
 	case OHMD_EXTERNAL_SENSOR_FUSION:
+	case OHMD_MAG_CORRECTION_GAIN:
 		{
 			if(device->setf == NULL)
 				return OHMD_S_UNSUPPORTED;
@@ -457,6 +506,27 @@ int OHMD_APIENTRY ohmd_device_geti(ohmd_device* device, ohmd_int_value type, int
 				return OHMD_S_OK;
 			}
 
+		case OHMD_FUSION_ALGORITHM:
+			*out = device->settings.fusion_algorithm;
+			return OHMD_S_OK;
+
+		case OHMD_PROJECTION_FLAGS:
+			*out = device->properties.proj_flags;
+			return OHMD_S_OK;
+
+		case OHMD_SENSOR_SAMPLES_DROPPED:
+		case OHMD_SENSOR_SAMPLES_DUPLICATED:
+		case OHMD_SENSOR_REPORT_INTERVAL: {
+				if(!device->geti)
+					return OHMD_S_UNSUPPORTED;
+
+				ohmd_lock_mutex(device->ctx->update_mutex);
+				int ret = device->geti(device, type, out);
+				ohmd_unlock_mutex(device->ctx->update_mutex);
+
+				return ret;
+			}
+
 		default:
 				return OHMD_S_INVALID_PARAMETER;
 	}
@@ -465,11 +535,64 @@ int OHMD_APIENTRY ohmd_device_geti(ohmd_device* device, ohmd_int_value type, int
 int OHMD_APIENTRY ohmd_device_seti(ohmd_device* device, ohmd_int_value type, const int* in)
 {
 	switch(type){
+	case OHMD_FUSION_ALGORITHM: {
+			if(!device->seti)
+				return OHMD_S_UNSUPPORTED;
+
+			ohmd_lock_mutex(device->ctx->update_mutex);
+			int ret = device->seti(device, type, in);
+			if(ret == OHMD_S_OK)
+				device->settings.fusion_algorithm = in[0];
+			ohmd_unlock_mutex(device->ctx->update_mutex);
+
+			return ret;
+		}
+
+	case OHMD_SENSOR_REPORT_INTERVAL: {
+			if(!device->seti)
+				return OHMD_S_UNSUPPORTED;
+
+			ohmd_lock_mutex(device->ctx->update_mutex);
+			int ret = device->seti(device, type, in);
+			ohmd_unlock_mutex(device->ctx->update_mutex);
+
+			return ret;
+		}
+
+	case OHMD_PROJECTION_FLAGS: {
+			const int all = OHMD_PROJECTION_REVERSE_Z | OHMD_PROJECTION_INFINITE_FAR |
+				OHMD_PROJECTION_DEPTH_ZERO_TO_ONE | OHMD_PROJECTION_ROW_MAJOR;
+
+			if(in[0] & ~all)
+				return OHMD_S_INVALID_PARAMETER;
+
+			ohmd_lock_mutex(device->ctx->update_mutex);
+			device->properties.proj_flags = in[0];
+			device->properties.proj_dirty = true;
+			ohmd_unlock_mutex(device->ctx->update_mutex);
+
+			return OHMD_S_OK;
+		}
+
 	default:
 		return OHMD_S_INVALID_PARAMETER;
 	}
 }
 
+int OHMD_APIENTRY ohmd_device_read_stream(ohmd_device* device, ohmd_stream_type type, void* out, int max)
+{
+	if(max < 0 || (!out && max > 0))
+		return OHMD_S_INVALID_PARAMETER;
+
+	if(!device->read_stream)
+		return OHMD_S_UNSUPPORTED;
+
+	ohmd_lock_mutex(device->ctx->update_mutex);
+	int ret = device->read_stream(device, type, out, max);
+	ohmd_unlock_mutex(device->ctx->update_mutex);
+
+	return ret;
+}
 
 int ohmd_device_set_data_unp(ohmd_device* device, ohmd_data_value type, const void* in)
 {
@@ -496,6 +619,43 @@ int OHMD_APIENTRY ohmd_device_set_data(ohmd_device* device, ohmd_data_value type
 	return ret;
 }
 
+int OHMD_APIENTRY ohmd_device_transform_points(ohmd_device* device, const float* pose, ohmd_point_layout layout,
+                                                const float* in, float* out, int count)
+{
+	if(!in || !out || count < 0)
+		return OHMD_S_INVALID_PARAMETER;
+
+	quatf rot;
+	vec3f pos;
+
+	if(pose){
+		memcpy(rot.arr, pose, sizeof(float) * 4);
+		memcpy(pos.arr, pose + 4, sizeof(float) * 3);
+	}else{
+		ohmd_lock_mutex(device->ctx->update_mutex);
+		ohmd_device_getf_unp(device, OHMD_ROTATION_QUAT, rot.arr);
+		ohmd_device_getf_unp(device, OHMD_POSITION_VECTOR, pos.arr);
+		ohmd_unlock_mutex(device->ctx->update_mutex);
+	}
+
+	// one rotation and translation matrix for the whole batch
+	mat4x4f mat;
+	oquatf_get_mat4x4(&rot, &pos, mat.m);
+
+	switch(layout){
+	case OHMD_POINTS_AOS:
+		omat4x4f_transform_points_aos(&mat, in, out, count);
+		return OHMD_S_OK;
+
+	case OHMD_POINTS_SOA:
+		omat4x4f_transform_points_soa(&mat, in, out, count);
+		return OHMD_S_OK;
+
+	default:
+		return OHMD_S_INVALID_PARAMETER;
+	}
+}
+
 ohmd_status OHMD_APIENTRY ohmd_device_settings_seti(ohmd_device_settings* settings, ohmd_int_settings key, const int* val)
 {
 	switch(key){
@@ -503,6 +663,10 @@ ohmd_status OHMD_APIENTRY ohmd_device_settings_seti(ohmd_device_settings* settin
 		settings->automatic_update = val[0] == 0 ? false : true;
 		return OHMD_S_OK;
 
+	case OHMD_IDS_FUSION_ALGORITHM:
+		settings->fusion_algorithm = val[0];
+		return OHMD_S_OK;
+
 	default:
 		return OHMD_S_INVALID_PARAMETER;
 	}
@@ -537,8 +701,6 @@ void ohmd_set_default_device_properties(ohmd_device_properties* props)
 
 void ohmd_calc_default_proj_matrices(ohmd_device_properties* props)
 {
-	mat4x4f proj_base; // base projection matrix
-
 	// Calculate where the lens is on each screen,
 	// and with the given value offset the projection matrix.
 	float screen_center = props->hsize / 4.0f;
@@ -548,20 +710,41 @@ void ohmd_calc_default_proj_matrices(ohmd_device_properties* props)
 	// value of the offset seems to work.
 	float proj_offset = fabs(4.0f * lens_shift / props->hsize);
 
-	// Setup the base projection matrix. Each eye mostly have the
-	// same projection matrix with the exception of the offset.
-	omat4x4f_init_perspective(&proj_base, props->fov, props->ratio, props->znear, props->zfar);
+	// Each eye has the same symmetric field of view, moved sideways by the
+	// offset so the lens is at the center of the projection.
+	float top = tanf(props->fov / 2.0f);
+	float half_width = top * props->ratio;
 
-	// Setup the two adjusted projection matricies. Each is setup to deal
-	// with the fact that the lens is not in the center of the screen.
-	// These matrices only change of the hardware changes, so static.
-	mat4x4f translate;
+	ohmd_set_proj_tangents(props, 0, -half_width * (1.0f + proj_offset), half_width * (1.0f - proj_offset), -top, top);
+	ohmd_set_proj_tangents(props, 1, -half_width * (1.0f - proj_offset), half_width * (1.0f + proj_offset), -top, top);
 
-	omat4x4f_init_translate(&translate, proj_offset, 0, 0);
-	omat4x4f_mult(&translate, &proj_base, &props->proj_left);
+	ohmd_calc_proj_matrices(props);
+}
+
+void ohmd_set_proj_tangents(ohmd_device_properties* props, int eye, float left, float right, float bottom, float top)
+{
+	props->proj_tangents[eye][0] = left;
+	props->proj_tangents[eye][1] = right;
+	props->proj_tangents[eye][2] = bottom;
+	props->proj_tangents[eye][3] = top;
+	props->proj_dirty = true;
+}
+
+void ohmd_calc_proj_matrices(ohmd_device_properties* props)
+{
+	mat4x4f* proj[2] = { &props->proj_left, &props->proj_right };
+
+	for(int eye = 0; eye < 2; eye++){
+		const float* t = props->proj_tangents[eye];
+
+		// keep matrices set up by the driver directly
+		if(t[0] == t[1])
+			continue;
+
+		omat4x4f_init_frustum_tangents(proj[eye], t[0], t[1], t[2], t[3], props->znear, props->zfar, props->proj_flags);
+	}
 
-	omat4x4f_init_translate(&translate, -proj_offset, 0, 0);
-	omat4x4f_mult(&translate, &proj_base, &props->proj_right);
+	props->proj_dirty = false;
 }
 
 void ohmd_set_universal_distortion_k(ohmd_device_properties* props, float a, float b, float c, float d)
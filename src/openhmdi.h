@@ -19,8 +19,10 @@
 #include "omath.h"
 #include "platform.h"
 #include "queue.h"
+#include "uring.h"
 
 #define OHMD_MAX_DEVICES 16
+#define OHMD_MAX_POLL_FDS 4
 
 #define OHMD_MAX(_a, _b) ((_a) > (_b) ? (_a) : (_b))
 #define OHMD_MIN(_a, _b) ((_a) < (_b) ? (_a) : (_b))
@@ -78,6 +80,9 @@ typedef struct {
 
 		mat4x4f proj_left; // adjusted projection matrix for left screen
 		mat4x4f proj_right; // adjusted projection matrix for right screen
+		float proj_tangents[2][4]; // per eye frustum edges (left, right, bottom, top) as tangents, all 0 if not set
+		int proj_flags; // ohmd_projection_flags
+		bool proj_dirty; // proj_left and proj_right need to be rebuilt from the tangents
 		float universal_distortion_k[4]; //PanoTools lens distiorion model [a,b,c,d]
 		float universal_aberration_k[3]; //post-warp per channel scaling [r,g,b]
 } ohmd_device_properties;
@@ -85,6 +90,7 @@ typedef struct {
 struct ohmd_device_settings
 {
 	bool automatic_update;
+	int fusion_algorithm;
 };
 
 struct ohmd_device {
@@ -95,8 +101,10 @@ struct ohmd_device {
 
 	int (*getf)(ohmd_device* device, ohmd_float_value type, float* out);
 	int (*setf)(ohmd_device* device, ohmd_float_value type, const float* in);
+	int (*geti)(ohmd_device* device, ohmd_int_value type, int* out);
 	int (*seti)(ohmd_device* device, ohmd_int_value type, const int* in);
 	int (*set_data)(ohmd_device* device, ohmd_data_value type, const void* in);
+	int (*read_stream)(ohmd_device* device, ohmd_stream_type type, void* out, int max);
 
 	void (*update)(ohmd_device* device);
 	void (*close)(ohmd_device* device);
@@ -111,6 +119,10 @@ struct ohmd_device {
 	vec3f position;
 	
 	ohmdq* digital_input_event_queue;
+
+	// readable when the device has reports, the update thread waits on them instead of sleeping
+	int poll_fds[OHMD_MAX_POLL_FDS];
+	int num_poll_fds;
 };
 
 
@@ -128,12 +140,17 @@ struct ohmd_context {
 
 	bool update_request_quit;
 
+	// created by the first device reading a hidraw node, NULL without io_uring
+	ohmd_uring* uring;
+
 	char error_msg[OHMD_STR_SIZE];
 };
 
 // helper functions
 void ohmd_set_default_device_properties(ohmd_device_properties* props);
 void ohmd_calc_default_proj_matrices(ohmd_device_properties* props);
+void ohmd_set_proj_tangents(ohmd_device_properties* props, int eye, float left, float right, float bottom, float top);
+void ohmd_calc_proj_matrices(ohmd_device_properties* props);
 void ohmd_set_universal_distortion_k(ohmd_device_properties* props, float a, float b, float c, float d);
 void ohmd_set_universal_aberration_k(ohmd_device_properties* props, float r, float g, float b);
 
@@ -150,5 +167,6 @@ ohmd_driver* ohmd_create_android_drv(ohmd_context* ctx);
 #include "log.h"
 #include "omath.h"
 #include "fusion.h"
+#include "imu_ring.h"
 
 #endif
@@ -0,0 +1,125 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packet Layouts */
+
+#ifndef PACKET_LAYOUT_H
+#define PACKET_LAYOUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef _MSC_VER
+#define inline __inline
+#endif
+
+/*
+ * Declarative decoding of fixed layout HID reports.
+ *
+ * A layout is declared once as an X-macro listing every field of the decoded
+ * struct with its byte offset in the report and its wire type:
+ *
+ *   #define FOO_SENSOR_LAYOUT(F) \
+ *   	F(report_id, 0, u8) \
+ *   	F(tick, 1, u32) \
+ *   	PL_VEC3(F, accel, 5, s16)
+ *
+ *   PL_DECODER(foo_decode_sensor_packet, foo_sensor_packet, FOO_SENSOR_LAYOUT, 11, 11)
+ *
+ * PL_DECODER expands to a function bool name(type* pkt, const unsigned char*
+ * buffer, int size) that checks the report size once against the given
+ * minimum and maximum, and then reads every field from a constant offset.
+ * It carries no storage class, put static in front for a local decoder.
+ * A field that would end past the minimum size fails to compile.
+ *
+ * PL_DECODER_SIZES is the same for reports that come in exactly one of two
+ * sizes, the fields have to fit in the smaller, first one.
+ *
+ * Wire types are little endian: u8, u16, s16, u32, s32, float, an IEEE 754
+ * single, and fixed, a s32 in millionths decoded to float.
+ */
+
+#define PL_SIZE_u8 1
+#define PL_SIZE_u16 2
+#define PL_SIZE_s16 2
+#define PL_SIZE_u32 4
+#define PL_SIZE_s32 4
+#define PL_SIZE_float 4
+#define PL_SIZE_fixed 4
+
+static inline uint8_t pl_read_u8(const unsigned char* p)
+{
+	return p[0];
+}
+
+static inline uint16_t pl_read_u16(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline int16_t pl_read_s16(const unsigned char* p)
+{
+	return (int16_t)pl_read_u16(p);
+}
+
+static inline uint32_t pl_read_u32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline int32_t pl_read_s32(const unsigned char* p)
+{
+	return (int32_t)pl_read_u32(p);
+}
+
+static inline float pl_read_float(const unsigned char* p)
+{
+	union { uint32_t u; float f; } v = { pl_read_u32(p) };
+	return v.f;
+}
+
+static inline float pl_read_fixed(const unsigned char* p)
+{
+	return (float)pl_read_s32(p) / 1000000.0f;
+}
+
+// three consecutive values into _field[0] to _field[2]
+#define PL_VEC3(F, _field, _offset, _type) \
+	F(_field[0], (_offset), _type) \
+	F(_field[1], (_offset) + PL_SIZE_##_type, _type) \
+	F(_field[2], (_offset) + 2 * PL_SIZE_##_type, _type)
+
+#define PL_DECODE_FIELD(_field, _offset, _type) \
+	(void)sizeof(char[(_offset) + PL_SIZE_##_type <= pl_min_size ? 1 : -1]); \
+	pkt->_field = pl_read_##_type(buffer + (_offset));
+
+#define PL_DECODER(_name, _type, _layout, _min_size, _max_size) \
+	bool _name(_type* pkt, const unsigned char* buffer, int size) \
+	{ \
+		enum { pl_min_size = (_min_size) }; \
+		if(size < (_min_size) || size > (_max_size)){ \
+			LOGE("invalid " #_type " size (expected %d to %d but got %d)", (_min_size), (_max_size), size); \
+			return false; \
+		} \
+		_layout(PL_DECODE_FIELD) \
+		return true; \
+	}
+
+#define PL_DECODER_SIZES(_name, _type, _layout, _size, _other_size) \
+	bool _name(_type* pkt, const unsigned char* buffer, int size) \
+	{ \
+		enum { pl_min_size = (_size) }; \
+		(void)sizeof(char[(_size) < (_other_size) ? 1 : -1]); \
+		if(size != (_size) && size != (_other_size)){ \
+			LOGE("invalid " #_type " size (expected %d or %d but got %d)", (_size), (_other_size), size); \
+			return false; \
+		} \
+		_layout(PL_DECODE_FIELD) \
+		return true; \
+	}
+
+#endif
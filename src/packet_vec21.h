@@ -0,0 +1,137 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Packed 21 Bit Vectors */
+
+#ifndef PACKET_VEC21_H
+#define PACKET_VEC21_H
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#define inline __inline
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PL_VEC21_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PL_VEC21_NEON
+#endif
+
+/*
+ * Vectors of 3 tightly packed, big endian, 21 bit values in 8 bytes each, as
+ * sent by the Rift and its clones.
+ */
+
+// one vector into out[0] to out[2] multiplied by scale, every value is moved
+// to the top of 32 bits and shifted down with its sign
+static inline void pl_read_vec21(const unsigned char* p, float scale, float* out)
+{
+	uint64_t v = 0;
+	for(int k = 0; k < 8; k++)
+		v = (v << 8) | p[k];
+
+	out[0] = (float)((int32_t)(uint32_t)(v >> 32) >> 11) * scale;
+	out[1] = (float)((int32_t)(uint32_t)(v >> 11) >> 11) * scale;
+	out[2] = (float)((int32_t)(uint32_t)(v << 10) >> 11) * scale;
+}
+
+#if defined(PL_VEC21_SSE2)
+
+// up to two vectors, never reading past the last one, missing ones are 0
+static inline __m128i pl_vec21_load2(const unsigned char* p, int n)
+{
+	if(n >= 2)
+		return _mm_loadu_si128((const __m128i*)p);
+
+	return n == 1 ? _mm_loadl_epi64((const __m128i*)p) : _mm_setzero_si128();
+}
+
+// reverses the bytes of both 64 bit lanes
+static inline __m128i pl_vec21_bswap64(__m128i v)
+{
+	v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	return _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+// the low (or high) 32 bits of each 64 bit lane of a and then b
+static inline __m128i pl_vec21_pack32(__m128i a, __m128i b, int high)
+{
+	__m128 fa = _mm_castsi128_ps(a), fb = _mm_castsi128_ps(b);
+	return _mm_castps_si128(high ? _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)) : _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+static inline void pl_vec21_store(float* out, __m128i top, float scale)
+{
+	_mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(top, 11)), _mm_set1_ps(scale)));
+}
+
+#elif defined(PL_VEC21_NEON)
+
+// up to two vectors byte swapped, never reading past the last one, missing ones are 0
+static inline uint64x2_t pl_vec21_load2(const unsigned char* p, int n)
+{
+	uint8x16_t b;
+
+	if(n >= 2)
+		b = vld1q_u8(p);
+	else
+		b = vcombine_u8(n == 1 ? vld1_u8(p) : vdup_n_u8(0), vdup_n_u8(0));
+
+	return vreinterpretq_u64_u8(vrev64q_u8(b));
+}
+
+static inline void pl_vec21_store(float* out, uint32x2_t lo, uint32x2_t hi, float scale)
+{
+	int32x4_t top = vreinterpretq_s32_u32(vcombine_u32(lo, hi));
+	vst1q_f32(out, vmulq_n_f32(vcvtq_f32_s32(vshrq_n_s32(top, 11)), scale));
+}
+
+#endif
+
+/*
+ * Unpacks count vectors into x, y and z multiplied by scale, four at a time
+ * with the same bit math as pl_read_vec21. The vectors are loaded straight
+ * from the report, the last block only up to its last vector. The outputs
+ * need room for count rounded up to 4, the values past count are 0.
+ */
+static inline void pl_unpack_vec21(const unsigned char* buffer, int count, float scale, float* x, float* y, float* z)
+{
+	for(int i = 0; i < count; i += 4){
+		const unsigned char* p = buffer + i * 8;
+
+#if defined(PL_VEC21_SSE2)
+		__m128i v0 = pl_vec21_bswap64(pl_vec21_load2(p, count - i));
+		__m128i v1 = pl_vec21_bswap64(pl_vec21_load2(p + 16, count - i - 2));
+
+		pl_vec21_store(x + i, pl_vec21_pack32(v0, v1, 1), scale);
+		pl_vec21_store(y + i, pl_vec21_pack32(_mm_srli_epi64(v0, 11), _mm_srli_epi64(v1, 11), 0), scale);
+		pl_vec21_store(z + i, pl_vec21_pack32(_mm_slli_epi64(v0, 10), _mm_slli_epi64(v1, 10), 0), scale);
+#elif defined(PL_VEC21_NEON)
+		uint64x2_t v0 = pl_vec21_load2(p, count - i), v1 = pl_vec21_load2(p + 16, count - i - 2);
+
+		pl_vec21_store(x + i, vshrn_n_u64(v0, 32), vshrn_n_u64(v1, 32), scale);
+		pl_vec21_store(y + i, vshrn_n_u64(v0, 11), vshrn_n_u64(v1, 11), scale);
+		pl_vec21_store(z + i, vmovn_u64(vshlq_n_u64(v0, 10)), vmovn_u64(vshlq_n_u64(v1, 10)), scale);
+#else
+		for(int j = 0; j < 4; j++){
+			float v[3] = { 0, 0, 0 };
+			if(i + j < count)
+				pl_read_vec21(p + j * 8, scale, v);
+
+			x[i + j] = v[0];
+			y[i + j] = v[1];
+			z[i + j] = v[2];
+		}
+#endif
+	}
+}
+
+#endif
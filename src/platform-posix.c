@@ -20,6 +20,13 @@
 #include <stdio.h>
 #include <pthread.h>
 #include <string.h>
+#include <poll.h>
+#include <errno.h>
+
+#if defined(__linux__) && defined(OHMD_HIDRAW)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "platform.h"
 #include "openhmdi.h"
@@ -51,6 +58,68 @@ void ohmd_sleep(double seconds)
 	nanosleep(&sleepfor, NULL);
 }
 
+void ohmd_poll_fds(const int* fds, int count, double timeout)
+{
+	struct pollfd pfds[64];
+
+	count = count < 64 ? count : 64;
+
+	for(int i = 0; i < count; i++){
+		pfds[i].fd = fds[i];
+		pfds[i].events = POLLIN;
+	}
+
+	poll(pfds, count, (int)(timeout * 1000.0 + 0.5));
+}
+
+#if defined(__linux__) && defined(OHMD_HIDRAW)
+
+int ohmd_hidraw_open(const char* path)
+{
+	// hidapi's hidraw backend uses the node as the path, other backends hold the interface themselves
+	if(strncmp(path, "/dev/hidraw", 11) != 0)
+		return -1;
+
+	return open(path, O_RDONLY | O_NONBLOCK);
+}
+
+int ohmd_hidraw_read(int fd, unsigned char* buffer, int size)
+{
+	ssize_t ret = read(fd, buffer, size);
+
+	if(ret < 0)
+		return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+	// hidraw reports are never empty, end of file means the node is gone
+	if(ret == 0)
+		return -1;
+
+	return (int)ret;
+}
+
+void ohmd_hidraw_close(int fd)
+{
+	close(fd);
+}
+
+#else
+
+int ohmd_hidraw_open(const char* path)
+{
+	return -1;
+}
+
+int ohmd_hidraw_read(int fd, unsigned char* buffer, int size)
+{
+	return -1;
+}
+
+void ohmd_hidraw_close(int fd)
+{
+}
+
+#endif
+
 // threads
 struct ohmd_thread
 {
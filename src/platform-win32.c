@@ -36,6 +36,26 @@ void ohmd_sleep(double seconds)
 	Sleep((DWORD)(seconds * 1000));
 }
 
+// TODO wait on the devices' handles
+void ohmd_poll_fds(const int* fds, int count, double timeout)
+{
+	ohmd_sleep(timeout);
+}
+
+int ohmd_hidraw_open(const char* path)
+{
+	return -1;
+}
+
+int ohmd_hidraw_read(int fd, unsigned char* buffer, int size)
+{
+	return -1;
+}
+
+void ohmd_hidraw_close(int fd)
+{
+}
+
 // threads
 
 struct ohmd_thread {
@@ -16,6 +16,15 @@ double ohmd_get_tick();
 void ohmd_sleep(double seconds);
 void ohmd_toggle_ovr_service(int state);
 
+// waits until one of the file descriptors is readable, at most timeout seconds
+void ohmd_poll_fds(const int* fds, int count, double timeout);
+
+/* Linux hidraw nodes, opening fails on other platforms and without OHMD_HIDRAW */
+
+int ohmd_hidraw_open(const char* path);
+int ohmd_hidraw_read(int fd, unsigned char* buffer, int size);
+void ohmd_hidraw_close(int fd);
+
 typedef struct ohmd_thread ohmd_thread;
 typedef struct ohmd_mutex ohmd_mutex;
 
@@ -0,0 +1,464 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Batched Report Reads, io_uring Implementation */
+
+#if defined(__linux__) && defined(OHMD_IO_URING)
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "uring.h"
+#include "openhmdi.h"
+
+#define URING_ENTRIES 512
+#define URING_READERS 32
+#define URING_SLOTS 8       // reads kept posted per reader
+#define URING_REPORT_SIZE 256
+
+// user_data of the cancel requests, reads carry the reader id and slot
+#define URING_CANCEL_TAG ~(__u64)0
+#define URING_USER_DATA(_id, _slot) (((__u64)(_id) << 8) | (_slot))
+
+typedef struct {
+	int fd; // -1 when the reader is free
+	int error;
+	int in_flight;
+
+	// completed slots in completion order, the order the reports were read in
+	unsigned char done[URING_SLOTS];
+	unsigned done_read, done_write;
+
+	int lengths[URING_SLOTS];
+	unsigned char buffers[URING_SLOTS][URING_REPORT_SIZE];
+} uring_reader;
+
+struct ohmd_uring {
+	int fd;
+	ohmd_mutex* mutex;
+
+	void* sq_ring;
+	void* cq_ring;
+	size_t sq_ring_size, cq_ring_size;
+
+	unsigned *sq_head, *sq_tail, *sq_array;
+	unsigned sq_mask, sq_entries;
+	struct io_uring_sqe* sqes;
+
+	unsigned *cq_head, *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe* cqes;
+
+	unsigned to_submit;
+
+	uring_reader readers[URING_READERS];
+};
+
+static int uring_setup(unsigned entries, struct io_uring_params* p)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void submit(ohmd_uring* ring)
+{
+	while(ring->to_submit > 0){
+		int ret = uring_enter(ring->fd, ring->to_submit, 0, 0);
+
+		if(ret < 0){
+			if(errno != EINTR){
+				LOGW("could not submit reads: %s", strerror(errno));
+				return;
+			}
+			continue;
+		}
+
+		ring->to_submit -= (unsigned)ret;
+
+		if(ret == 0)
+			return;
+	}
+}
+
+static struct io_uring_sqe* get_sqe(ohmd_uring* ring)
+{
+	unsigned tail = *ring->sq_tail;
+
+	if(tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries){
+		submit(ring);
+
+		if(tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries)
+			return NULL;
+	}
+
+	struct io_uring_sqe* sqe = &ring->sqes[tail & ring->sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+
+	return sqe;
+}
+
+// the entry from get_sqe is filled in
+static void push_sqe(ohmd_uring* ring)
+{
+	unsigned tail = *ring->sq_tail;
+
+	ring->sq_array[tail & ring->sq_mask] = tail & ring->sq_mask;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->to_submit++;
+}
+
+static void queue_read(ohmd_uring* ring, int id, int slot)
+{
+	uring_reader* r = ring->readers + id;
+	struct io_uring_sqe* sqe = get_sqe(ring);
+
+	if(!sqe){
+		LOGE("io_uring submission queue full");
+		r->error = -ENOSPC;
+		return;
+	}
+
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = r->fd;
+	sqe->off = (__u64)-1; // the current position, hidraw has none
+	sqe->addr = (__u64)(uintptr_t)r->buffers[slot];
+	sqe->len = URING_REPORT_SIZE;
+	sqe->user_data = URING_USER_DATA(id, slot);
+
+	push_sqe(ring);
+	r->in_flight++;
+}
+
+static void handle_cqe(ohmd_uring* ring, const struct io_uring_cqe* cqe)
+{
+	if(cqe->user_data == URING_CANCEL_TAG)
+		return;
+
+	int id = (int)(cqe->user_data >> 8);
+	int slot = (int)(cqe->user_data & 0xff);
+	uring_reader* r = ring->readers + id;
+
+	r->in_flight--;
+
+	// a reader that is being removed only waits for its reads to finish
+	if(r->fd < 0 || cqe->res == -ECANCELED)
+		return;
+
+	if(cqe->res > 0){
+		r->lengths[slot] = cqe->res;
+		r->done[r->done_write++ % URING_SLOTS] = slot;
+	}else if(cqe->res == -EAGAIN || cqe->res == -EINTR){
+		queue_read(ring, id, slot);
+	}else{
+		// end of file or the device went away
+		r->error = cqe->res ? cqe->res : -EIO;
+	}
+}
+
+// only touches the shared memory, no system call
+static void reap(ohmd_uring* ring)
+{
+	unsigned head = *ring->cq_head;
+	unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+	for(; head != tail; head++)
+		handle_cqe(ring, &ring->cqes[head & ring->cq_mask]);
+
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+// the kernel has to support reads, they came with 5.6, a bit later than io_uring itself
+static bool supports_read(int fd)
+{
+	size_t size = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+	struct io_uring_probe* probe = calloc(1, size);
+	bool ret = false;
+
+	if(!probe)
+		return false;
+
+	if(uring_register(fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) == 0 && probe->last_op >= IORING_OP_READ)
+		ret = probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED;
+
+	free(probe);
+
+	return ret;
+}
+
+ohmd_uring* ohmd_uring_create(ohmd_context* ctx)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+
+	int fd = uring_setup(URING_ENTRIES, &p);
+
+	if(fd < 0){
+		LOGD("io_uring not available (%s), reading devices directly", strerror(errno));
+		return NULL;
+	}
+
+	if(!supports_read(fd)){
+		LOGD("io_uring can't read on this kernel, reading devices directly");
+		close(fd);
+		return NULL;
+	}
+
+	ohmd_uring* ring = ohmd_alloc(ctx, sizeof(ohmd_uring));
+
+	if(!ring){
+		close(fd);
+		return NULL;
+	}
+
+	ring->fd = fd;
+	ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+	// both rings share one mapping since 5.4
+	if(p.features & IORING_FEAT_SINGLE_MMAP){
+		ring->sq_ring_size = ring->cq_ring_size = OHMD_MAX(ring->sq_ring_size, ring->cq_ring_size);
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+	if(ring->sq_ring == MAP_FAILED)
+		goto cleanup;
+
+	if(p.features & IORING_FEAT_SINGLE_MMAP){
+		ring->cq_ring = ring->sq_ring;
+	}else{
+		ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+		if(ring->cq_ring == MAP_FAILED)
+			goto cleanup;
+	}
+
+	ring->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+	if(ring->sqes == MAP_FAILED)
+		goto cleanup;
+
+	char* sq = ring->sq_ring;
+	ring->sq_head = (unsigned*)(sq + p.sq_off.head);
+	ring->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+	ring->sq_array = (unsigned*)(sq + p.sq_off.array);
+	ring->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+	ring->sq_entries = p.sq_entries;
+
+	char* cq = ring->cq_ring;
+	ring->cq_head = (unsigned*)(cq + p.cq_off.head);
+	ring->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+	ring->cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+	for(int i = 0; i < URING_READERS; i++)
+		ring->readers[i].fd = -1;
+
+	ring->mutex = ohmd_create_mutex(ctx);
+
+	if(!ring->mutex)
+		goto cleanup;
+
+	LOGD("reading devices through io_uring");
+
+	return ring;
+
+cleanup:
+	LOGW("could not map the io_uring queues: %s", strerror(errno));
+
+	if(ring->sqes && ring->sqes != MAP_FAILED)
+		munmap(ring->sqes, p.sq_entries * sizeof(struct io_uring_sqe));
+	if(ring->cq_ring && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	if(ring->sq_ring && ring->sq_ring != MAP_FAILED)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+
+	close(fd);
+	free(ring);
+
+	return NULL;
+}
+
+void ohmd_uring_destroy(ohmd_uring* ring)
+{
+	if(!ring)
+		return;
+
+	// closing the ring cancels whatever is still posted
+	munmap(ring->sqes, ring->sq_entries * sizeof(struct io_uring_sqe));
+	if(ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	munmap(ring->sq_ring, ring->sq_ring_size);
+
+	close(ring->fd);
+	ohmd_destroy_mutex(ring->mutex);
+	free(ring);
+}
+
+int ohmd_uring_get_fd(ohmd_uring* ring)
+{
+	return ring->fd;
+}
+
+int ohmd_uring_add(ohmd_uring* ring, int fd)
+{
+	int id = -1;
+
+	ohmd_lock_mutex(ring->mutex);
+
+	for(int i = 0; i < URING_READERS; i++){
+		uring_reader* r = ring->readers + i;
+
+		if(r->fd < 0 && r->in_flight == 0){
+			id = i;
+			break;
+		}
+	}
+
+	if(id >= 0){
+		uring_reader* r = ring->readers + id;
+
+		r->fd = fd;
+		r->error = 0;
+		r->done_read = r->done_write = 0;
+
+		for(int slot = 0; slot < URING_SLOTS; slot++)
+			queue_read(ring, id, slot);
+
+		submit(ring);
+	}
+
+	ohmd_unlock_mutex(ring->mutex);
+
+	return id;
+}
+
+void ohmd_uring_remove(ohmd_uring* ring, int id)
+{
+	uring_reader* r = ring->readers + id;
+
+	ohmd_lock_mutex(ring->mutex);
+
+	// completions for a removed reader don't post its reads again
+	r->fd = -1;
+
+	while(r->in_flight > 0){
+		for(int slot = 0; slot < URING_SLOTS; slot++){
+			struct io_uring_sqe* sqe = get_sqe(ring);
+
+			if(!sqe)
+				break;
+
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->addr = URING_USER_DATA(id, slot);
+			sqe->user_data = URING_CANCEL_TAG;
+			push_sqe(ring);
+		}
+
+		int ret = uring_enter(ring->fd, ring->to_submit, 1, IORING_ENTER_GETEVENTS);
+
+		if(ret > 0)
+			ring->to_submit -= (unsigned)ret;
+
+		reap(ring);
+	}
+
+	ohmd_unlock_mutex(ring->mutex);
+}
+
+int ohmd_uring_read(ohmd_uring* ring, int id, unsigned char* buffer, int size)
+{
+	uring_reader* r = ring->readers + id;
+	int ret = 0;
+
+	ohmd_lock_mutex(ring->mutex);
+
+	reap(ring);
+
+	if(r->done_read != r->done_write){
+		int slot = r->done[r->done_read++ % URING_SLOTS];
+
+		ret = OHMD_MIN(r->lengths[slot], size);
+		memcpy(buffer, r->buffers[slot], ret);
+
+		// posted with the next flush
+		queue_read(ring, id, slot);
+	}else if(r->error){
+		ret = -1;
+	}
+
+	ohmd_unlock_mutex(ring->mutex);
+
+	return ret;
+}
+
+void ohmd_uring_flush(ohmd_uring* ring)
+{
+	ohmd_lock_mutex(ring->mutex);
+
+	reap(ring);
+	submit(ring);
+
+	ohmd_unlock_mutex(ring->mutex);
+}
+
+#else
+
+#include <stddef.h>
+
+#include "uring.h"
+
+ohmd_uring* ohmd_uring_create(ohmd_context* ctx)
+{
+	return NULL;
+}
+
+void ohmd_uring_destroy(ohmd_uring* ring)
+{
+}
+
+int ohmd_uring_get_fd(ohmd_uring* ring)
+{
+	return -1;
+}
+
+int ohmd_uring_add(ohmd_uring* ring, int fd)
+{
+	return -1;
+}
+
+void ohmd_uring_remove(ohmd_uring* ring, int id)
+{
+}
+
+int ohmd_uring_read(ohmd_uring* ring, int id, unsigned char* buffer, int size)
+{
+	return -1;
+}
+
+void ohmd_uring_flush(ohmd_uring* ring)
+{
+}
+
+#endif
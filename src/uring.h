@@ -0,0 +1,50 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Batched Report Reads */
+
+#ifndef URING_H
+#define URING_H
+
+#include "openhmd.h"
+
+/*
+ * One io_uring per context keeps a few reads posted on every hidraw node the
+ * drivers read from. Completed reports are collected from the shared
+ * completion queue without a system call, so finding out that a device has
+ * nothing new is free, and the reads consumed during an update pass are
+ * posted again together by ohmd_uring_flush.
+ *
+ * Only built on Linux with OHMD_IO_URING. ohmd_uring_create returns NULL when
+ * the kernel has no io_uring or no read operation for it (before 5.6), or it
+ * is disabled, and the readers fall back to reading the nodes directly.
+ *
+ * All functions are safe to call from the update thread and the application
+ * at the same time.
+ */
+
+typedef struct ohmd_uring ohmd_uring;
+
+ohmd_uring* ohmd_uring_create(ohmd_context* ctx);
+void ohmd_uring_destroy(ohmd_uring* ring);
+
+// readable when completions are waiting
+int ohmd_uring_get_fd(ohmd_uring* ring);
+
+// posts reads on a non blocking file descriptor, returns the id to read with or -1 when full
+int ohmd_uring_add(ohmd_uring* ring, int fd);
+
+// cancels the reads, the file descriptor can be closed after this
+void ohmd_uring_remove(ohmd_uring* ring, int id);
+
+// the size of the oldest report, 0 when there is none or -1 on errors
+int ohmd_uring_read(ohmd_uring* ring, int id, unsigned char* buffer, int size);
+
+// collects completions and posts the reads consumed since the last flush
+void ohmd_uring_flush(ohmd_uring* ring);
+
+#endif
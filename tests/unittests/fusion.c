@@ -0,0 +1,355 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Unit Tests - Sensor Fusion Tests */
+
+#include "tests.h"
+#include "fusion_batch.h"
+
+static const vec3f gravity = {{0, 9.82f, 0}};
+static const vec3f no_mag = {{0, 0, 0}};
+
+void test_ofusion_gyro_bias()
+{
+	vec3f bias = {{0.01f, -0.02f, 0.005f}};
+
+	fusion f;
+	ofusion_init(&f);
+	f.flags |= FF_USE_GYRO_BIAS;
+
+	// a device sitting still on a table, 3 seconds at 1000 Hz
+	for(int i = 0; i < 3000; i++)
+		ofusion_update(&f, 0.001f, &bias, &gravity, &no_mag);
+
+	TAssert(vec3f_eq(f.gyro_bias, bias, 0.0001f));
+
+	// the counters saturate instead of growing for as long as the device sits still
+	TAssert(f.device_still_count == f.ang_vel_fq.size + 1);
+	TAssert(f.gyro_bias_samples * f.gyro_bias_gain < 1.0f + f.gyro_bias_gain);
+
+	// the remaining rotation should be what was integrated while the estimate converged
+	float angle = 2.0f * acosf(OHMD_MIN(fabsf(f.orient.w), 1.0f));
+	TAssert(angle < 0.01f);
+}
+
+void test_ofusion_gyro_bias_ignores_slow_turn()
+{
+	vec3f bias = {{0.01f, -0.02f, 0.005f}};
+	vec3f turn = {{0.01f, 0.08f, 0.005f}};
+
+	fusion f;
+	ofusion_init(&f);
+	f.flags |= FF_USE_GYRO_BIAS;
+
+	for(int i = 0; i < 3000; i++)
+		ofusion_update(&f, 0.001f, &bias, &gravity, &no_mag);
+
+	// a steady slow turn must not be absorbed into the settled estimate
+	for(int i = 0; i < 3000; i++)
+		ofusion_update(&f, 0.001f, &turn, &gravity, &no_mag);
+
+	TAssert(vec3f_eq(f.gyro_bias, bias, 0.001f));
+}
+
+void test_ofusion_batch_gyro_bias_ignores_slow_turn()
+{
+	static fusion_batch batch;
+	vec3f bias = {{0.01f, -0.02f, 0.005f}};
+	vec3f turn = {{0.01f, 0.02f, 0.005f}};
+
+	ofusion_batch_init(&batch);
+	TAssert(ofusion_batch_add(&batch) == 0);
+
+	for(int i = 0; i < 3000; i++){
+		ofusion_batch_set_sample(&batch, 0, 0.001f, &bias, &gravity);
+		ofusion_batch_update(&batch);
+	}
+
+	vec3f estimate = {{batch.bx[0], batch.by[0], batch.bz[0]}};
+	TAssert(vec3f_eq(estimate, bias, 0.0001f));
+
+	// a steady slow turn must not be absorbed into the settled estimate
+	for(int i = 0; i < 3000; i++){
+		ofusion_batch_set_sample(&batch, 0, 0.001f, &turn, &gravity);
+		ofusion_batch_update(&batch);
+	}
+
+	estimate = (vec3f){{batch.bx[0], batch.by[0], batch.bz[0]}};
+	TAssert(vec3f_eq(estimate, bias, 0.001f));
+}
+
+static float get_mag_yaw_error(fusion* f, const vec3f* mag)
+{
+	vec3f world_mag;
+	oquatf_get_rotated(&f->orient, mag, &world_mag);
+	world_mag.y = 0;
+	ovec3f_normalize_me(&world_mag);
+
+	return ovec3f_get_angle(&world_mag, &f->mag_ref);
+}
+
+void test_ofusion_mag_yaw_correction()
+{
+	vec3f drift = {{0, 0.01f, 0}};
+	vec3f mag = {{0.2f, -0.4f, 0.3f}};
+
+	fusion f;
+	ofusion_init(&f);
+
+	// off by default, on with a gain between 0 and 1
+	TAssert(ofusion_get_mag_gain(&f) == 0);
+	TAssert(ofusion_set_mag_gain(&f, -0.1f) != 0 && ofusion_set_mag_gain(&f, 1.5f) != 0);
+	TAssert(ofusion_set_mag_gain(&f, 0.01f) == 0 && ofusion_get_mag_gain(&f) == 0.01f);
+
+	// 20 seconds at 1000 Hz with an uncompensated yaw drift of 0.2 radians
+	for(int i = 0; i < 20000; i++)
+		ofusion_update(&f, 0.001f, &drift, &gravity, &mag);
+
+	TAssert(f.mag_ref_length > 0);
+	TAssert(get_mag_yaw_error(&f, &mag) < 0.02f);
+
+	// a disturbed field must not drag the heading along
+	vec3f disturbed = {{2.0f, -4.0f, 3.0f}};
+	quatf before = f.orient;
+
+	for(int i = 0; i < 1000; i++)
+		ofusion_update(&f, 0.001f, &drift, &gravity, &disturbed);
+
+	quatf diff;
+	oquatf_diff(&before, &f.orient, &diff);
+	TAssert(2.0f * acosf(OHMD_MIN(fabsf(diff.w), 1.0f)) < 0.011f);
+}
+
+void test_ofusion_batch_integrate()
+{
+	static fusion_batch batch;
+	vec3f no_accel = {{0, 0, 0}};
+	vec3f rates[3] = {
+		{{0, 1.0f, 0}},
+		{{0.5f, 0, -0.25f}},
+		{{-2.0f, 0.3f, 1.0f}},
+	};
+
+	ofusion_batch_init(&batch);
+	for(int d = 0; d < 3; d++)
+		TAssert(ofusion_batch_add(&batch) == d);
+
+	// one second at 1000 Hz, without gravity to correct against
+	for(int i = 0; i < 1000; i++){
+		for(int d = 0; d < 3; d++)
+			ofusion_batch_set_sample(&batch, d, 0.001f, &rates[d], &no_accel);
+
+		ofusion_batch_update(&batch);
+	}
+
+	for(int d = 0; d < 3; d++){
+		quatf expected, orient;
+		float angle = ovec3f_get_length(&rates[d]);
+		vec3f axis = rates[d];
+		ovec3f_normalize_me(&axis);
+		oquatf_init_axis(&expected, &axis, angle);
+
+		ofusion_batch_get_orient(&batch, d, &orient);
+		TAssert(quatf_eq(orient, expected, 0.001f));
+	}
+}
+
+void test_ofusion_batch_gravity_correction()
+{
+	static fusion_batch batch;
+	vec3f still = {{0, 0, 0}};
+
+	ofusion_batch_init(&batch);
+	TAssert(ofusion_batch_add(&batch) == 0);
+
+	// start tilted by 0.3 radians about x while the device lies flat
+	quatf tilt;
+	vec3f x_axis = {{1, 0, 0}};
+	oquatf_init_axis(&tilt, &x_axis, 0.3f);
+	batch.ox[0] = tilt.x; batch.oy[0] = tilt.y; batch.oz[0] = tilt.z; batch.ow[0] = tilt.w;
+
+	// 20 seconds at 1000 Hz
+	for(int i = 0; i < 20000; i++){
+		ofusion_batch_set_sample(&batch, 0, 0.001f, &still, &gravity);
+		ofusion_batch_update(&batch);
+	}
+
+	quatf orient;
+	ofusion_batch_get_orient(&batch, 0, &orient);
+
+	vec3f up;
+	oquatf_get_rotated(&orient, &gravity, &up);
+	ovec3f_normalize_me(&up);
+
+	TAssert(fabsf(up.x) < 0.01f && fabsf(up.z) < 0.01f && up.y > 0.999f);
+}
+
+static void test_algorithm_gravity_correction(int algorithm)
+{
+	vec3f still = {{0, 0, 0}};
+
+	fusion f;
+	ofusion_init(&f);
+	TAssert(ofusion_set_algorithm(&f, algorithm) == 0);
+
+	// start tilted by 0.3 radians about x while the device lies flat
+	vec3f x_axis = {{1, 0, 0}};
+	oquatf_init_axis(&f.orient, &x_axis, 0.3f);
+
+	// 20 seconds at 1000 Hz
+	for(int i = 0; i < 20000; i++)
+		ofusion_update(&f, 0.001f, &still, &gravity, &no_mag);
+
+	vec3f up;
+	oquatf_get_rotated(&f.orient, &gravity, &up);
+	ovec3f_normalize_me(&up);
+
+	TAssert(fabsf(up.x) < 0.01f && fabsf(up.z) < 0.01f && up.y > 0.999f);
+}
+
+static void test_algorithm_integrate(int algorithm)
+{
+	vec3f turn = {{0, 1.0f, 0}};
+
+	fusion f;
+	ofusion_init(&f);
+	TAssert(ofusion_set_algorithm(&f, algorithm) == 0);
+
+	// one second of turning about the up axis, which gravity can't correct
+	for(int i = 0; i < 1000; i++)
+		ofusion_update(&f, 0.001f, &turn, &gravity, &no_mag);
+
+	quatf expected;
+	oquatf_init_axis(&expected, &turn, 1.0f);
+	TAssert(quatf_eq(f.orient, expected, 0.001f));
+}
+
+void test_ofusion_madgwick()
+{
+	test_algorithm_gravity_correction(OHMD_FUSION_MADGWICK);
+	test_algorithm_integrate(OHMD_FUSION_MADGWICK);
+}
+
+void test_ofusion_mahony()
+{
+	test_algorithm_gravity_correction(OHMD_FUSION_MAHONY);
+	test_algorithm_integrate(OHMD_FUSION_MAHONY);
+}
+
+void test_ofusion_set_algorithm()
+{
+	fusion f;
+	ofusion_init(&f);
+
+	TAssert(f.algorithm == OHMD_FUSION_COMPLEMENTARY);
+	TAssert(ofusion_set_algorithm(&f, OHMD_FUSION_MAHONY) == 0);
+	TAssert(f.algorithm == OHMD_FUSION_MAHONY);
+	TAssert(ofusion_set_algorithm(&f, 42) != 0);
+	TAssert(f.algorithm == OHMD_FUSION_MAHONY);
+}
+
+// precise for small angles, unlike acos of the dot product
+static float get_angle_between(const quatf* a, const quatf* b)
+{
+	quatf inv = *a, diff;
+	oquatf_inverse(&inv);
+	oquatf_mult(&inv, b, &diff);
+
+	vec3f v = {{ diff.x, diff.y, diff.z }};
+	return 2.0f * asinf(OHMD_MIN(ovec3f_get_length(&v), 1.0f));
+}
+
+void test_ofusion_coning_window()
+{
+	fusion per_sample, windowed;
+	ofusion_init(&per_sample);
+	ofusion_init(&windowed);
+	per_sample.flags = windowed.flags = 0;
+	windowed.fuse_interval = 4;
+
+	// the same window summed without coning correction, for comparison
+	quatf naive = {{0, 0, 0, 1}};
+	vec3f naive_rot = {{0, 0, 0}};
+
+	// a rate vector spinning in the xy plane at 10 Hz, 10 seconds at 1000 Hz,
+	// each sample alone is integrated exactly, summing them into windows is not
+	for(int i = 0; i < 10000; i++){
+		float t = i * 0.001f;
+		vec3f ang_vel = {{ 2.0f * cosf(2.0f * M_PI * 10.0f * t), 2.0f * sinf(2.0f * M_PI * 10.0f * t), 0 }};
+
+		ofusion_update(&per_sample, 0.001f, &ang_vel, &gravity, &no_mag);
+		ofusion_update(&windowed, 0.001f, &ang_vel, &gravity, &no_mag);
+
+		for(int j = 0; j < 3; j++)
+			naive_rot.arr[j] += ang_vel.arr[j] * 0.001f;
+
+		if(i % 4 == 3){
+			float angle = ovec3f_get_length(&naive_rot);
+			ovec3f_normalize_me(&naive_rot);
+
+			quatf delta;
+			oquatf_init_axis(&delta, &naive_rot, angle);
+			oquatf_mult_me(&naive, &delta);
+			naive_rot.x = naive_rot.y = naive_rot.z = 0;
+		}
+	}
+
+	float windowed_error = get_angle_between(&windowed.orient, &per_sample.orient);
+	float naive_error = get_angle_between(&naive, &per_sample.orient);
+
+	TAssert(windowed_error < 0.001f);
+	TAssert(windowed_error * 10.0f < naive_error);
+	TAssert(windowed.iterations == 10000);
+}
+
+// angle of the rotation between an orientation and the expected one, in double precision
+static double get_angle_error(const quatf* q, const quatd* expected)
+{
+	quatd qd, diff;
+	oquatd_from_quatf(&qd, q);
+	oquatd_diff(expected, &qd, &diff);
+
+	vec3d v = {{ diff.x, diff.y, diff.z }};
+	return 2.0 * asin(OHMD_MIN(ovec3d_get_length(&v), 1.0));
+}
+
+void test_ofusion_double_precision()
+{
+	fusion single, dbl;
+	ofusion_init(&single);
+	ofusion_init(&dbl);
+	single.flags = 0;
+	dbl.flags = FF_DOUBLE_PRECISION;
+
+	// a constant turn, 20 minutes at 1000 Hz, every sample adds the same rotation
+	// so the exact result is a single rotation by the summed rotation vector
+	const int samples = 1200000;
+	vec3f ang_vel = {{ 0.3f, -0.7f, 0.2f }};
+	vec3f rot_vec = {{ ang_vel.x * 0.001f, ang_vel.y * 0.001f, ang_vel.z * 0.001f }};
+
+	for(int i = 0; i < samples; i++){
+		ofusion_update(&single, 0.001f, &ang_vel, &gravity, &no_mag);
+		ofusion_update(&dbl, 0.001f, &ang_vel, &gravity, &no_mag);
+	}
+
+	quatd expected;
+	vec3d total = {{ (double)rot_vec.x * samples, (double)rot_vec.y * samples, (double)rot_vec.z * samples }};
+	oquatd_init_rotation_vector(&expected, &total);
+
+	double single_error = get_angle_error(&single.orient, &expected);
+	double double_error = get_angle_error(&dbl.orient, &expected);
+
+	// only rounded to float once at the end
+	TAssert(double_error < 1e-6);
+	TAssert(double_error * 10.0 < single_error);
+	TAssert(fabs(dbl.time - (double)0.001f * samples) < 1e-6);
+
+	// changes from the outside are picked up
+	dbl.orient = (quatf){{0, 0, 0, 1}};
+	ofusion_update(&dbl, 0.001f, &ang_vel, &gravity, &no_mag);
+	TAssert(dbl.orient_d.w > 0.999999);
+}
@@ -9,6 +9,7 @@
 
 #include "tests.h"
 #include "openhmd.h"
+#include <string.h>
 
 void test_highlevel_open_close_device()
 {
@@ -67,3 +68,377 @@ void test_highlevel_open_close_many_devices()
 	
 	ohmd_ctx_destroy(ctx);	
 }
+
+static int find_device(ohmd_context* ctx, int num_devices, const char* product)
+{
+	for(int i = 0; i < num_devices; i++){
+		if(strcmp(ohmd_list_gets(ctx, i, OHMD_PRODUCT), product) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+void test_highlevel_fusion_algorithm()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	int external = find_device(ctx, num_devices, "External Device");
+	int dummy = find_device(ctx, num_devices, "Dummy Device");
+	TAssert(external >= 0 && dummy >= 0);
+
+	ohmd_device_settings* settings = ohmd_device_settings_create(ctx);
+	int val = OHMD_FUSION_MADGWICK;
+	TAssert(ohmd_device_settings_seti(settings, OHMD_IDS_FUSION_ALGORITHM, &val) == OHMD_S_OK);
+
+	// the setting is applied when the device is opened
+	ohmd_device* hmd = ohmd_list_open_device_s(ctx, external, settings);
+	TAssert(hmd);
+	TAssert(ohmd_device_geti(hmd, OHMD_FUSION_ALGORITHM, &val) == OHMD_S_OK && val == OHMD_FUSION_MADGWICK);
+
+	val = OHMD_FUSION_MAHONY;
+	TAssert(ohmd_device_seti(hmd, OHMD_FUSION_ALGORITHM, &val) == OHMD_S_OK);
+	TAssert(ohmd_device_geti(hmd, OHMD_FUSION_ALGORITHM, &val) == OHMD_S_OK && val == OHMD_FUSION_MAHONY);
+
+	val = 42;
+	TAssert(ohmd_device_seti(hmd, OHMD_FUSION_ALGORITHM, &val) == OHMD_S_INVALID_PARAMETER);
+	TAssert(ohmd_device_geti(hmd, OHMD_FUSION_ALGORITHM, &val) == OHMD_S_OK && val == OHMD_FUSION_MAHONY);
+
+	// devices without fusion fall back to the default
+	ohmd_device* dummy_hmd = ohmd_list_open_device_s(ctx, dummy, settings);
+	TAssert(dummy_hmd);
+	TAssert(ohmd_device_geti(dummy_hmd, OHMD_FUSION_ALGORITHM, &val) == OHMD_S_OK && val == OHMD_FUSION_COMPLEMENTARY);
+	TAssert(ohmd_device_seti(dummy_hmd, OHMD_FUSION_ALGORITHM, &val) == OHMD_S_UNSUPPORTED);
+
+	ohmd_device_settings_destroy(settings);
+	ohmd_ctx_destroy(ctx);
+}
+
+void test_highlevel_mag_correction_gain()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	int external = find_device(ctx, num_devices, "External Device");
+	int dummy = find_device(ctx, num_devices, "Dummy Device");
+	TAssert(external >= 0 && dummy >= 0);
+
+	ohmd_device* hmd = ohmd_list_open_device(ctx, external);
+	TAssert(hmd);
+
+	float gain = 1;
+	TAssert(ohmd_device_getf(hmd, OHMD_MAG_CORRECTION_GAIN, &gain) == OHMD_S_OK && gain == 0);
+
+	gain = 0.05f;
+	TAssert(ohmd_device_setf(hmd, OHMD_MAG_CORRECTION_GAIN, &gain) == OHMD_S_OK);
+	TAssert(ohmd_device_getf(hmd, OHMD_MAG_CORRECTION_GAIN, &gain) == OHMD_S_OK && gain == 0.05f);
+
+	gain = -1;
+	TAssert(ohmd_device_setf(hmd, OHMD_MAG_CORRECTION_GAIN, &gain) == OHMD_S_INVALID_PARAMETER);
+	TAssert(ohmd_device_getf(hmd, OHMD_MAG_CORRECTION_GAIN, &gain) == OHMD_S_OK && gain == 0.05f);
+
+	// devices without a magnetometer
+	ohmd_device* dummy_hmd = ohmd_list_open_device(ctx, dummy);
+	TAssert(dummy_hmd);
+	TAssert(ohmd_device_setf(dummy_hmd, OHMD_MAG_CORRECTION_GAIN, &gain) == OHMD_S_UNSUPPORTED);
+
+	ohmd_ctx_destroy(ctx);
+}
+
+// two samples per device between updates, turning about the gravity axis at the given rates
+static void feed_external_devices(ohmd_context* ctx, ohmd_device** hmds, const float* rates, int count, int passes)
+{
+	for(int i = 0; i < passes; i++){
+		for(int d = 0; d < count; d++){
+			if(!hmds[d])
+				continue;
+
+			float sample[10] = { 0.001f, 0, rates[d], 0, 0, 9.81f, 0, 0, 0, 0 };
+			TAssert(ohmd_device_setf(hmds[d], OHMD_EXTERNAL_SENSOR_FUSION, sample) == OHMD_S_OK);
+			TAssert(ohmd_device_setf(hmds[d], OHMD_EXTERNAL_SENSOR_FUSION, sample) == OHMD_S_OK);
+		}
+
+		ohmd_ctx_update(ctx);
+	}
+}
+
+static bool external_device_turned(ohmd_device* hmd, float angle)
+{
+	quatf rot, expected;
+	vec3f up = {{0, 1, 0}};
+	oquatf_init_axis(&expected, &up, angle);
+
+	ohmd_device_getf(hmd, OHMD_ROTATION_QUAT, rot.arr);
+	return quatf_eq(rot, expected, 0.01f);
+}
+
+void test_highlevel_external_fusion_batch()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	int external = find_device(ctx, num_devices, "External Device");
+	TAssert(external >= 0);
+
+	const float rates[3] = { 0.5f, 1.0f, -1.5f };
+	ohmd_device* hmds[3];
+
+	for(int d = 0; d < 3; d++){
+		hmds[d] = ohmd_list_open_device(ctx, external);
+		TAssert(hmds[d]);
+	}
+
+	feed_external_devices(ctx, hmds, rates, 3, 500);
+
+	for(int d = 0; d < 3; d++)
+		TAssert(external_device_turned(hmds[d], rates[d]));
+
+	// the first device leaves the batch and keeps its orientation, the last one takes its place
+	int val = OHMD_FUSION_MADGWICK;
+	TAssert(ohmd_device_seti(hmds[0], OHMD_FUSION_ALGORITHM, &val) == OHMD_S_OK);
+	TAssert(external_device_turned(hmds[0], rates[0]));
+
+	feed_external_devices(ctx, hmds, rates, 3, 500);
+
+	for(int d = 0; d < 3; d++)
+		TAssert(external_device_turned(hmds[d], rates[d] * 2));
+
+	TAssert(ohmd_close_device(hmds[1]) == 0);
+	hmds[1] = NULL;
+
+	feed_external_devices(ctx, hmds, rates, 3, 500);
+
+	TAssert(external_device_turned(hmds[0], rates[0] * 3));
+	TAssert(external_device_turned(hmds[2], rates[2] * 3));
+
+	ohmd_ctx_destroy(ctx);
+}
+
+static void transform_point(const quatf* rot, const vec3f* pos, const float* in, float* out)
+{
+	vec3f p = {{ in[0], in[1], in[2] }}, r;
+	oquatf_get_rotated(rot, &p, &r);
+
+	for(int i = 0; i < 3; i++)
+		out[i] = r.arr[i] + pos->arr[i];
+}
+
+void test_highlevel_transform_points()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	TAssert(num_devices > 0);
+
+	ohmd_device* hmd = ohmd_list_open_device(ctx, num_devices - 1);
+	TAssert(hmd);
+
+	// give the device a pose through the corrections
+	quatf rot;
+	vec3f axis = {{1, 2, 3}}, pos = {{0.5f, -1.0f, 2.0f}};
+	oquatf_init_axis(&rot, &axis, 0.7f);
+	TAssert(ohmd_device_setf(hmd, OHMD_ROTATION_QUAT, rot.arr) == OHMD_S_OK);
+	TAssert(ohmd_device_setf(hmd, OHMD_POSITION_VECTOR, pos.arr) == OHMD_S_OK);
+	ohmd_ctx_update(ctx);
+
+	quatf dev_rot;
+	vec3f dev_pos;
+	ohmd_device_getf(hmd, OHMD_ROTATION_QUAT, dev_rot.arr);
+	ohmd_device_getf(hmd, OHMD_POSITION_VECTOR, dev_pos.arr);
+	TAssert(float_eq(oquatf_get_length(&dev_rot), 1.0f, 0.0001f));
+
+	// an odd count, so the vectorized paths have a remainder
+	enum { count = 37 };
+	float aos[count * 3], soa[count * 3], expected[count * 3], given_pose[count * 3];
+
+	for(int i = 0; i < count; i++){
+		for(int j = 0; j < 3; j++){
+			aos[i * 3 + j] = (float)(i * 3 + j) * 0.1f - 5.0f;
+			soa[i + j * count] = aos[i * 3 + j];
+		}
+
+		transform_point(&dev_rot, &dev_pos, aos + i * 3, expected + i * 3);
+	}
+
+	TAssert(ohmd_device_transform_points(hmd, NULL, OHMD_POINTS_AOS, aos, given_pose, count) == OHMD_S_OK);
+	TAssert(ohmd_device_transform_points(hmd, NULL, OHMD_POINTS_AOS, aos, aos, count) == OHMD_S_OK);
+	TAssert(ohmd_device_transform_points(hmd, NULL, OHMD_POINTS_SOA, soa, soa, count) == OHMD_S_OK);
+
+	for(int i = 0; i < count; i++){
+		for(int j = 0; j < 3; j++){
+			TAssert(float_eq(given_pose[i * 3 + j], expected[i * 3 + j], 0.0001f));
+			TAssert(float_eq(aos[i * 3 + j], expected[i * 3 + j], 0.0001f));
+			TAssert(float_eq(soa[i + j * count], expected[i * 3 + j], 0.0001f));
+		}
+	}
+
+	// an explicit pose, transforming back to the original points with the inverse
+	quatf inv = dev_rot;
+	oquatf_inverse(&inv);
+
+	vec3f inv_pos;
+	oquatf_get_rotated(&inv, &dev_pos, &inv_pos);
+
+	float pose[7] = { inv.x, inv.y, inv.z, inv.w, -inv_pos.x, -inv_pos.y, -inv_pos.z };
+	TAssert(ohmd_device_transform_points(hmd, pose, OHMD_POINTS_AOS, aos, aos, count) == OHMD_S_OK);
+
+	for(int i = 0; i < count * 3; i++)
+		TAssert(float_eq(aos[i], (float)i * 0.1f - 5.0f, 0.0001f));
+
+	TAssert(ohmd_device_transform_points(hmd, NULL, 42, aos, aos, count) == OHMD_S_INVALID_PARAMETER);
+
+	ohmd_ctx_destroy(ctx);
+}
+
+void test_highlevel_eye_views()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	TAssert(num_devices > 0);
+
+	ohmd_device* hmd = ohmd_list_open_device(ctx, num_devices - 1);
+	TAssert(hmd);
+
+	quatf rot;
+	vec3f axis = {{0.2f, 1, -0.4f}};
+	oquatf_init_axis(&rot, &axis, 1.1f);
+	TAssert(ohmd_device_setf(hmd, OHMD_ROTATION_QUAT, rot.arr) == OHMD_S_OK);
+	ohmd_ctx_update(ctx);
+
+	float left[16], right[16], both[32], affine[24];
+	TAssert(ohmd_device_getf(hmd, OHMD_LEFT_EYE_GL_MODELVIEW_MATRIX, left) == OHMD_S_OK);
+	TAssert(ohmd_device_getf(hmd, OHMD_RIGHT_EYE_GL_MODELVIEW_MATRIX, right) == OHMD_S_OK);
+	TAssert(ohmd_device_getf(hmd, OHMD_EYES_GL_MODELVIEW_MATRICES, both) == OHMD_S_OK);
+	TAssert(ohmd_device_getf(hmd, OHMD_EYES_MODELVIEW_AFFINE, affine) == OHMD_S_OK);
+
+	for(int i = 0; i < 16; i++){
+		TAssert(left[i] == both[i]);
+		TAssert(right[i] == both[16 + i]);
+	}
+
+	for(int row = 0; row < 3; row++){
+		for(int col = 0; col < 4; col++){
+			TAssert(affine[row * 4 + col] == left[col * 4 + row]);
+			TAssert(affine[12 + row * 4 + col] == right[col * 4 + row]);
+		}
+	}
+
+	// the view rotation undoes the head rotation set above
+	vec3f forward = {{0, 0, -1}}, world, view;
+	oquatf_get_rotated(&rot, &forward, &world);
+	for(int i = 0; i < 3; i++)
+		view.arr[i] = left[i] * world.x + left[4 + i] * world.y + left[8 + i] * world.z;
+
+	TAssert(vec3f_eq(view, forward, 0.0001f));
+
+	// the eyes are ipd apart
+	float ipd;
+	ohmd_device_getf(hmd, OHMD_EYE_IPD, &ipd);
+	TAssert(float_eq(left[12] - right[12], ipd, 0.0001f));
+
+	ohmd_ctx_destroy(ctx);
+}
+
+void test_highlevel_projection()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	TAssert(num_devices > 0);
+
+	ohmd_device* hmd = ohmd_list_open_device(ctx, num_devices - 1);
+	TAssert(hmd);
+
+	int flags;
+	TAssert(ohmd_device_geti(hmd, OHMD_PROJECTION_FLAGS, &flags) == OHMD_S_OK && flags == 0);
+
+	float proj[16], changed[16], row_major[16];
+	TAssert(ohmd_device_getf(hmd, OHMD_LEFT_EYE_GL_PROJECTION_MATRIX, proj) == OHMD_S_OK);
+
+	// column major, -1 in the fourth column of the third row
+	TAssert(proj[11] == -1.0f);
+
+	// changing the planes changes the matrix
+	float znear = 0.05f, zfar = 20.0f;
+	TAssert(ohmd_device_setf(hmd, OHMD_PROJECTION_ZNEAR, &znear) == OHMD_S_OK);
+	TAssert(ohmd_device_setf(hmd, OHMD_PROJECTION_ZFAR, &zfar) == OHMD_S_OK);
+	TAssert(ohmd_device_getf(hmd, OHMD_LEFT_EYE_GL_PROJECTION_MATRIX, changed) == OHMD_S_OK);
+
+	TAssert(changed[0] == proj[0]);
+	TAssert(changed[10] != proj[10]);
+	TAssert(float_eq(changed[10], -(zfar + znear) / (zfar - znear), 0.0001f));
+
+	// reverse z, [0, 1] depth, row major
+	flags = OHMD_PROJECTION_REVERSE_Z | OHMD_PROJECTION_DEPTH_ZERO_TO_ONE | OHMD_PROJECTION_ROW_MAJOR;
+	TAssert(ohmd_device_seti(hmd, OHMD_PROJECTION_FLAGS, &flags) == OHMD_S_OK);
+	TAssert(ohmd_device_geti(hmd, OHMD_PROJECTION_FLAGS, &flags) == OHMD_S_OK);
+	TAssert(flags == (OHMD_PROJECTION_REVERSE_Z | OHMD_PROJECTION_DEPTH_ZERO_TO_ONE | OHMD_PROJECTION_ROW_MAJOR));
+	TAssert(ohmd_device_getf(hmd, OHMD_LEFT_EYE_GL_PROJECTION_MATRIX, row_major) == OHMD_S_OK);
+
+	TAssert(row_major[14] == -1.0f);
+	TAssert(row_major[0] == proj[0]);
+
+	// depth 1 at the near plane and 0 at the far plane
+	TAssert(float_eq((row_major[10] * -znear + row_major[11]) / znear, 1.0f, 0.0001f));
+	TAssert(float_eq((row_major[10] * -zfar + row_major[11]) / zfar, 0.0f, 0.0001f));
+
+	flags = 16;
+	TAssert(ohmd_device_seti(hmd, OHMD_PROJECTION_FLAGS, &flags) == OHMD_S_INVALID_PARAMETER);
+
+	ohmd_ctx_destroy(ctx);
+}
+
+void test_highlevel_sensor_sample_counts()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	TAssert(num_devices > 0);
+
+	ohmd_device* hmd = ohmd_list_open_device(ctx, num_devices - 1);
+	TAssert(hmd);
+
+	// the dummy device has no IMU transfer to count samples on
+	int count = -1;
+	TAssert(ohmd_device_geti(hmd, OHMD_SENSOR_SAMPLES_DROPPED, &count) == OHMD_S_UNSUPPORTED);
+	TAssert(ohmd_device_geti(hmd, OHMD_SENSOR_SAMPLES_DUPLICATED, &count) == OHMD_S_UNSUPPORTED);
+	TAssert(count == -1);
+
+	// nor a report interval to query or change
+	int interval = 1000;
+	TAssert(ohmd_device_geti(hmd, OHMD_SENSOR_REPORT_INTERVAL, &count) == OHMD_S_UNSUPPORTED);
+	TAssert(ohmd_device_seti(hmd, OHMD_SENSOR_REPORT_INTERVAL, &interval) == OHMD_S_UNSUPPORTED);
+	TAssert(count == -1);
+
+	ohmd_ctx_destroy(ctx);
+}
+
+void test_highlevel_read_stream()
+{
+	ohmd_context* ctx = ohmd_ctx_create();
+	TAssert(ctx);
+
+	int num_devices = ohmd_ctx_probe(ctx);
+	TAssert(num_devices > 0);
+
+	ohmd_device* hmd = ohmd_list_open_device(ctx, num_devices - 1);
+	TAssert(hmd);
+
+	ohmd_sweep_sample sweeps[4];
+	TAssert(ohmd_device_read_stream(hmd, OHMD_STREAM_LIGHTHOUSE_SWEEPS, sweeps, -1) == OHMD_S_INVALID_PARAMETER);
+	TAssert(ohmd_device_read_stream(hmd, OHMD_STREAM_LIGHTHOUSE_SWEEPS, NULL, 4) == OHMD_S_INVALID_PARAMETER);
+
+	// the dummy device has no photodiodes
+	TAssert(ohmd_device_read_stream(hmd, OHMD_STREAM_LIGHTHOUSE_SWEEPS, sweeps, 4) == OHMD_S_UNSUPPORTED);
+
+	ohmd_ctx_destroy(ctx);
+}
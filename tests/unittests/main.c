@@ -28,21 +28,89 @@ int main()
 	
 	printf("quatf tests\n");
 	Test(test_oquatf_init_axis);
+	Test(test_oquatf_init_rotation_vector);
 	Test(test_oquatf_get_rotated);
 	Test(test_oquatf_get_dot);
 	Test(test_oquatf_inverse);
 	Test(test_oquatf_diff);
+	Test(test_oquatd);
+	printf("\n");
+
+	printf("mat4x4f tests\n");
+	Test(test_omat4x4f_init_eye_views);
+	Test(test_omat4x4f_init_frustum_tangents);
+	printf("\n");
+
+	printf("fusion tests\n");
+	Test(test_ofusion_gyro_bias);
+	Test(test_ofusion_gyro_bias_ignores_slow_turn);
+	Test(test_ofusion_mag_yaw_correction);
+	Test(test_ofusion_batch_integrate);
+	Test(test_ofusion_batch_gravity_correction);
+	Test(test_ofusion_batch_gyro_bias_ignores_slow_turn);
+	Test(test_ofusion_madgwick);
+	Test(test_ofusion_mahony);
+	Test(test_ofusion_set_algorithm);
+	Test(test_ofusion_coning_window);
+	Test(test_ofusion_double_precision);
 	printf("\n");
 
 	printf("high level tests\n");
 	Test(test_highlevel_open_close_device);
 	Test(test_highlevel_open_close_many_devices);
+	Test(test_highlevel_fusion_algorithm);
+	Test(test_highlevel_mag_correction_gain);
+	Test(test_highlevel_external_fusion_batch);
+	Test(test_highlevel_transform_points);
+	Test(test_highlevel_eye_views);
+	Test(test_highlevel_projection);
+	Test(test_highlevel_sensor_sample_counts);
+	Test(test_highlevel_read_stream);
 	printf("\n");
 	
 	printf("queue tests\n");
 	Test(test_ohmdq_push_pop);
 	printf("\n");
 
+	printf("simd tests\n");
+	Test(test_omath_simd_kernels);
+	Test(test_omath_init_impl);
+	Test(test_omath_inline);
+	printf("\n");
+
+	printf("packet layout tests\n");
+	Test(test_packet_layout_decode);
+	Test(test_packet_layout_size);
+	Test(test_packet_unpack_vec21);
+	printf("\n");
+
+#if DRIVER_HTC_VIVE
+	printf("vive replay tests\n");
+	Test(test_vive_controller_replay);
+	Test(test_vive_lighthouse_replay);
+	Test(test_vive_sample_reorder_replay);
+	printf("\n");
+#endif
+
+#if DRIVER_NOLO
+	printf("nolo packet tests\n");
+	Test(test_nolo_decrypt_from);
+	printf("\n");
+#endif
+
+#if DRIVER_PSVR
+	printf("psvr replay tests\n");
+	Test(test_psvr_sensor_replay);
+	printf("\n");
+#endif
+
+#if DRIVER_OCULUS_RIFT
+	printf("rift packet tests\n");
+	Test(test_rift_packet_interval_from_us);
+	Test(test_rift_report_first_dt);
+	printf("\n");
+#endif
+
 	printf("all a-ok\n");
 	return 0;
 }
@@ -0,0 +1,117 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Unit Tests - Matrix Tests */
+
+#include "tests.h"
+
+static const float t = 0.00001;
+
+// the view of one eye built the long way, look_at, translate, multiply and transpose
+static void get_eye_view(const quatf* rot, const vec3f* pos, float shift, mat4x4f* out)
+{
+	vec3f point = {{0, 0, 0}};
+	mat4x4f orient, world_shift, result;
+	omat4x4f_init_look_at(&orient, rot, &point);
+	omat4x4f_init_translate(&world_shift, -pos->x + shift, -pos->y, -pos->z);
+	omat4x4f_mult(&world_shift, &orient, &result);
+	omat4x4f_transpose(&result, out);
+}
+
+void test_omat4x4f_init_eye_views()
+{
+	vec3f axes[] = { {{0, 1, 0}}, {{1, 2, 3}}, {{-0.3f, 0.1f, 0.9f}} };
+	vec3f positions[] = { {{0, 0, 0}}, {{0.5f, 1.7f, -2.0f}}, {{-3.0f, 0.2f, 0.1f}} };
+	float ipd = 0.064f;
+
+	for(int i = 0; i < 3; i++){
+		quatf rot;
+		oquatf_init_axis(&rot, &axes[i], 0.4f + i);
+
+		mat4x4f expected_left, expected_right;
+		get_eye_view(&rot, &positions[i], ipd / 2.0f, &expected_left);
+		get_eye_view(&rot, &positions[i], -ipd / 2.0f, &expected_right);
+
+		float left[16], right[16];
+		omat4x4f_init_eye_views_gl(&rot, &positions[i], ipd, left, right);
+
+		for(int j = 0; j < 16; j++){
+			TAssert(float_eq(left[j], expected_left.arr[j], t));
+			TAssert(float_eq(right[j], expected_right.arr[j], t));
+		}
+
+		// the affine form is the upper three rows, row major
+		float left_affine[12], right_affine[12];
+		omat3x4f_init_eye_views(&rot, &positions[i], ipd, left_affine, right_affine);
+
+		for(int row = 0; row < 3; row++){
+			for(int col = 0; col < 4; col++){
+				TAssert(float_eq(left_affine[row * 4 + col], expected_left.m[col][row], t));
+				TAssert(float_eq(right_affine[row * 4 + col], expected_right.m[col][row], t));
+			}
+		}
+	}
+}
+
+// depth in clip space of a point straight ahead at a distance
+static float get_depth(const mat4x4f* proj, float distance)
+{
+	float z = proj->m[2][2] * -distance + proj->m[2][3];
+	float w = proj->m[3][2] * -distance + proj->m[3][3];
+	return z / w;
+}
+
+void test_omat4x4f_init_frustum_tangents()
+{
+	float n = 0.1f, f = 100.0f;
+	float l = -1.2f, r = 0.9f, b = -1.0f, top = 1.1f;
+
+	// no flags is the same as the classic frustum
+	mat4x4f proj, expected;
+	omat4x4f_init_frustum_tangents(&proj, l, r, b, top, n, f, 0);
+	omat4x4f_init_frustum(&expected, l * n, r * n, b * n, top * n, n, f);
+
+	for(int i = 0; i < 16; i++)
+		TAssert(float_eq(proj.arr[i], expected.arr[i], t));
+
+	struct {
+		int flags;
+		float near_depth, far_depth;
+	} list[] = {
+		{ 0, -1, 1 },
+		{ OMATH_PROJ_REVERSE_Z, 1, -1 },
+		{ OMATH_PROJ_ZERO_TO_ONE, 0, 1 },
+		{ OMATH_PROJ_ZERO_TO_ONE | OMATH_PROJ_REVERSE_Z, 1, 0 },
+		{ OMATH_PROJ_INFINITE_FAR, -1, 1 },
+		{ OMATH_PROJ_INFINITE_FAR | OMATH_PROJ_ZERO_TO_ONE | OMATH_PROJ_REVERSE_Z, 1, 0 },
+	};
+
+	for(int i = 0; i < sizeof(list) / sizeof(list[0]); i++){
+		omat4x4f_init_frustum_tangents(&proj, l, r, b, top, n, f, list[i].flags);
+
+		TAssert(float_eq(get_depth(&proj, n), list[i].near_depth, 0.0001f));
+
+		// the infinite far plane is only reached at infinity
+		if(list[i].flags & OMATH_PROJ_INFINITE_FAR){
+			float depth = get_depth(&proj, 1e6f);
+			TAssert(float_eq(depth, list[i].far_depth, 0.001f));
+			TAssert(depth != list[i].far_depth);
+		}else{
+			TAssert(float_eq(get_depth(&proj, f), list[i].far_depth, 0.0001f));
+		}
+
+		// the edges of the frustum land on the edges of clip space
+		TAssert(float_eq(proj.m[0][0] * l - proj.m[0][2], -1.0f, t));
+		TAssert(float_eq(proj.m[1][1] * top - proj.m[1][2], 1.0f, t));
+	}
+
+	// degenerate frustums give the identity
+	omat4x4f_init_frustum_tangents(&proj, l, l, b, top, n, f, 0);
+	omat4x4f_init_ident(&expected);
+	for(int i = 0; i < 16; i++)
+		TAssert(proj.arr[i] == expected.arr[i]);
+}
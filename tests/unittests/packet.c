@@ -0,0 +1,585 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Unit Tests - Packet Layouts */
+
+#include "tests.h"
+#include "packet_layout.h"
+#include "packet_vec21.h"
+
+typedef struct {
+	uint8_t report_id;
+	uint16_t seq;
+	int16_t accel[3];
+	uint32_t tick;
+	int32_t offset;
+	float scale;
+	float gain;
+} test_packet;
+
+#define TEST_PACKET_LAYOUT(F) \
+	F(report_id, 0, u8) \
+	F(seq, 1, u16) \
+	PL_VEC3(F, accel, 3, s16) \
+	F(tick, 9, u32) \
+	F(offset, 13, s32) \
+	F(scale, 17, fixed) \
+	F(gain, 21, float)
+
+static PL_DECODER(test_decode_packet, test_packet, TEST_PACKET_LAYOUT, 25, 26)
+static PL_DECODER_SIZES(test_decode_packet_sizes, test_packet, TEST_PACKET_LAYOUT, 25, 27)
+
+void test_packet_layout_decode()
+{
+	const unsigned char buffer[26] = {
+		0x20, // report id
+		0x34, 0x12, // seq
+		0x01, 0x00, 0xff, 0xff, 0x00, 0x80, // accel
+		0x78, 0x56, 0x34, 0xf2, // tick
+		0xfe, 0xff, 0xff, 0xff, // offset
+		0x60, 0x79, 0xfe, 0xff, // scale, -100000 millionths
+		0x00, 0x00, 0x20, 0xc0, // gain, -2.5
+		0x00 // padding
+	};
+
+	test_packet pkt;
+
+	TAssert(test_decode_packet(&pkt, buffer, 25));
+	TAssert(pkt.report_id == 0x20);
+	TAssert(pkt.seq == 0x1234);
+	TAssert(pkt.accel[0] == 1 && pkt.accel[1] == -1 && pkt.accel[2] == -32768);
+	TAssert(pkt.tick == 0xf2345678u);
+	TAssert(pkt.offset == -2);
+	TAssert(float_eq(pkt.scale, -0.1f, 1e-7f));
+	TAssert(pkt.gain == -2.5f);
+
+	TAssert(test_decode_packet(&pkt, buffer, 26));
+}
+
+void test_packet_layout_size()
+{
+	const unsigned char buffer[32] = { 0 };
+	test_packet pkt;
+
+	TAssert(!test_decode_packet(&pkt, buffer, 24));
+	TAssert(!test_decode_packet(&pkt, buffer, 27));
+	TAssert(!test_decode_packet(&pkt, buffer, 0));
+
+	TAssert(test_decode_packet_sizes(&pkt, buffer, 25));
+	TAssert(test_decode_packet_sizes(&pkt, buffer, 27));
+	TAssert(!test_decode_packet_sizes(&pkt, buffer, 24));
+	TAssert(!test_decode_packet_sizes(&pkt, buffer, 26));
+	TAssert(!test_decode_packet_sizes(&pkt, buffer, 28));
+}
+
+// the Rift driver's original one vector at a time decoder
+static void decode_sample(const unsigned char* buffer, int32_t* smp)
+{
+	int x = (buffer[0] << 24)          | (buffer[1] << 16) | ((buffer[2] & 0xF8) << 8);
+	int y = ((buffer[2] & 0x07) << 29) | (buffer[3] << 21) | (buffer[4] << 13) | ((buffer[5] & 0xC0) << 5);
+	int z = ((buffer[5] & 0x3F) << 26) | (buffer[6] << 18) | (buffer[7] << 10);
+
+	smp[0] = x >> 11;
+	smp[1] = y >> 11;
+	smp[2] = z >> 11;
+}
+
+void test_packet_unpack_vec21()
+{
+	// DK1 reports carry up to 6 vectors from byte 8, DK2 reports 4 from byte 12
+	static const struct { int offset, count; } layouts[] = { { 8, 6 }, { 12, 4 } };
+	unsigned int state = 1;
+
+	for(int r = 0; r < 1000; r++){
+		unsigned char report[64];
+		for(int i = 0; i < 64; i++){
+			state = state * 1664525u + 1013904223u;
+			report[i] = state >> 24;
+		}
+
+		for(int l = 0; l < 2; l++){
+			// every count, so the partial last block is covered as well
+			for(int count = 1; count <= layouts[l].count; count++){
+				float x[8], y[8], z[8];
+				pl_unpack_vec21(report + layouts[l].offset, count, 0.0001f, x, y, z);
+
+				for(int i = 0; i < count; i++){
+					int32_t smp[3];
+					float v[3];
+					decode_sample(report + layouts[l].offset + i * 8, smp);
+					pl_read_vec21(report + layouts[l].offset + i * 8, 0.0001f, v);
+
+					TAssert(x[i] == (float)smp[0] * 0.0001f);
+					TAssert(y[i] == (float)smp[1] * 0.0001f);
+					TAssert(z[i] == (float)smp[2] * 0.0001f);
+					TAssert(v[0] == x[i] && v[1] == y[i] && v[2] == z[i]);
+				}
+
+				// the rest of the last block is 0, not whatever follows in the report
+				for(int i = count; i < (count + 3) / 4 * 4; i++)
+					TAssert(x[i] == 0 && y[i] == 0 && z[i] == 0);
+			}
+		}
+	}
+}
+
+#if DRIVER_HTC_VIVE || DRIVER_PSVR
+
+#include <string.h>
+
+static void write16(unsigned char* p, uint16_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = v >> 8;
+}
+
+static void write32(unsigned char* p, uint32_t v)
+{
+	write16(p, v & 0xffff);
+	write16(p + 2, v >> 16);
+}
+
+#endif
+
+#if DRIVER_HTC_VIVE
+
+#include "drv_htc_vive/vive.h"
+
+#define REPLAY_CONTROLLER_REPORTS 6
+
+typedef struct {
+	uint8_t type;
+	unsigned char payload[20];
+	int length;
+	int num_events;
+	ohmd_digital_input_event events[3];
+} controller_replay;
+
+// the low time code byte, accel (40, -8192, 120) and gyro (-4, 7, 2)
+#define REPLAY_IMU 0x9c, 0x28, 0x00, 0x00, 0xe0, 0x78, 0x00, 0xfc, 0xff, 0x07, 0x00, 0x02, 0x00
+
+void test_vive_controller_replay()
+{
+	static const controller_replay replay[REPLAY_CONTROLLER_REPORTS] = {
+		// trigger and trackpad touch pressed
+		{ 0xf1, { 0x05 }, 1, 2, {
+			{ VIVE_CONTROLLER_TRIGGER, OHMD_BUTTON_DOWN },
+			{ VIVE_CONTROLLER_TRACKPAD_TOUCH, OHMD_BUTTON_DOWN } } },
+		// every input with an IMU sample, grip pressed as well
+		{ 0xff, { 0x15, 0xc0, 0x50, 0xfb, 0x28, 0x23, REPLAY_IMU }, 19, 1, {
+			{ VIVE_CONTROLLER_GRIP, OHMD_BUTTON_DOWN } } },
+		// battery state followed by an IMU sample, no buttons
+		{ 0xe1, { 0x80 | 64, 0xe8, REPLAY_IMU }, 15, 0 },
+		// trigger and trackpad released
+		{ 0xf1, { 0x10 }, 1, 2, {
+			{ VIVE_CONTROLLER_TRIGGER, OHMD_BUTTON_UP },
+			{ VIVE_CONTROLLER_TRACKPAD_TOUCH, OHMD_BUTTON_UP } } },
+		// unchanged
+		{ 0xf1, { 0x10 }, 1, 0 },
+		// system and menu pressed, grip released
+		{ 0xf1, { 0x28 }, 1, 3, {
+			{ VIVE_CONTROLLER_SYSTEM, OHMD_BUTTON_DOWN },
+			{ VIVE_CONTROLLER_GRIP, OHMD_BUTTON_UP },
+			{ VIVE_CONTROLLER_MENU, OHMD_BUTTON_DOWN } } },
+	};
+
+	uint8_t buttons = 0;
+
+	for(int r = 0; r < REPLAY_CONTROLLER_REPORTS; r++){
+		const controller_replay* c = &replay[r];
+		unsigned char buffer[30] = { VIVE_CONTROLLER_REPORT, 0x12, 2 + c->length, 0x34 + r, c->type };
+		memcpy(buffer + 5, c->payload, sizeof(c->payload));
+
+		vive_controller_packet pkt;
+		TAssert(vive_decode_controller_packet(&pkt, buffer, sizeof(buffer)));
+
+		ohmd_digital_input_event events[VIVE_CONTROLLER_BUTTON_COUNT];
+		TAssert(vive_controller_button_events(&buttons, &pkt.message, events) == c->num_events);
+
+		for(int i = 0; i < c->num_events; i++)
+			TAssert(events[i].idx == c->events[i].idx && events[i].state == c->events[i].state);
+
+		if(pkt.message.flags & VIVE_CONTROLLER_HAS_IMU){
+			TAssert(pkt.message.time_ticks == (0x12u << 24 | (0x34u + r) << 16 | 0x9cu << 8));
+			TAssert(pkt.message.acc[0] == 40 && pkt.message.acc[1] == -8192 && pkt.message.acc[2] == 120);
+			TAssert(pkt.message.rot[0] == -4 && pkt.message.rot[1] == 7 && pkt.message.rot[2] == 2);
+		}
+	}
+
+	TAssert(buttons == 0x28);
+}
+
+#define REPLAY_LH_CYCLES 300
+#define REPLAY_LH_SENSORS 16
+#define REPLAY_LH_CYCLE_TICKS 400000
+#define REPLAY_LH_STATION_TICKS 20000
+
+typedef struct {
+	uint8_t sensor;
+	uint16_t length;
+	uint32_t time;
+} lighthouse_pulse;
+
+static int decode_lighthouse_pulses(vive_lighthouse_decoder* d, const lighthouse_pulse* pulses, int count, ohmd_sweep_sample* out)
+{
+	unsigned char buffer[64];
+
+	memset(buffer, 0xff, sizeof(buffer));
+	buffer[0] = VIVE_LIGHTHOUSE_REPORT;
+
+	for(int i = 0; i < count; i++){
+		unsigned char* p = buffer + 1 + 7 * i;
+		p[0] = pulses[i].sensor;
+		write16(p + 1, pulses[i].length);
+		write32(p + 3, pulses[i].time);
+	}
+
+	return vive_decode_lighthouse_report(d, buffer, sizeof(buffer), out);
+}
+
+/*
+ * A synthetic capture: every cycle both stations flash, three photodiodes see
+ * each flash and the first of them is clipped. The station and axis that
+ * sweep go round in the order a pair of stations would, and sixteen
+ * photodiodes are hit by every sweep. The tick counter wraps part way.
+ */
+void test_vive_lighthouse_replay()
+{
+	static lighthouse_pulse pulses[REPLAY_LH_CYCLES * (6 + REPLAY_LH_SENSORS)];
+	static ohmd_sweep_sample expected[REPLAY_LH_CYCLES * REPLAY_LH_SENSORS];
+	static ohmd_sweep_sample decoded[REPLAY_LH_CYCLES * REPLAY_LH_SENSORS + VIVE_LIGHTHOUSE_PULSES];
+	int num_pulses = 0, num_expected = 0, num_decoded = 0;
+
+	for(int c = 0; c < REPLAY_LH_CYCLES; c++){
+		uint32_t start = 0xfc000000u + (uint32_t)c * REPLAY_LH_CYCLE_TICKS;
+		int station = (c >> 1) & 1, axis = c & 1;
+
+		for(int s = 0; s < 2; s++){
+			int code = axis | (s == station ? 0 : 4);
+
+			for(int k = 0; k < 3; k++){
+				lighthouse_pulse* p = &pulses[num_pulses++];
+				p->sensor = 20 + k;
+				p->length = 3000 + 500 * code - (k == 0 ? 200 : 10 * k);
+				p->time = start + s * REPLAY_LH_STATION_TICKS + 20 * k;
+			}
+		}
+
+		uint32_t sweep_start = start + station * REPLAY_LH_STATION_TICKS;
+
+		for(int i = 0; i < REPLAY_LH_SENSORS; i++){
+			// from about -1.1 to 1 radians, a little further every cycle
+			int32_t ticks = 200000 + (i - REPLAY_LH_SENSORS / 2) * 18000 + c * 7;
+
+			lighthouse_pulse* p = &pulses[num_pulses++];
+			p->sensor = (i * 5 + c) % 32;
+			p->length = 100 + 2 * i;
+			p->time = sweep_start + ticks - p->length / 2;
+
+			ohmd_sweep_sample* e = &expected[num_expected++];
+			e->timestamp = sweep_start + ticks;
+			e->angle = (ticks - 200000) * (float)(M_PI / 400000);
+			e->length = p->length;
+			e->sensor = p->sensor;
+			e->station = station;
+			e->axis = axis;
+		}
+	}
+
+	vive_lighthouse_decoder d = { 0 };
+
+	for(int i = 0; i < num_pulses; i += VIVE_LIGHTHOUSE_PULSES){
+		int count = OHMD_MIN(num_pulses - i, VIVE_LIGHTHOUSE_PULSES);
+		int ret = decode_lighthouse_pulses(&d, pulses + i, count, decoded + num_decoded);
+
+		TAssert(ret >= 0 && num_decoded + ret <= num_expected);
+		num_decoded += ret;
+	}
+
+	TAssert(num_decoded == 4800);
+
+	for(int i = 0; i < num_expected; i++){
+		TAssert(decoded[i].sensor == expected[i].sensor);
+		TAssert(decoded[i].station == expected[i].station && decoded[i].axis == expected[i].axis);
+		TAssert(decoded[i].timestamp == expected[i].timestamp && decoded[i].length == expected[i].length);
+		TAssert(float_eq(decoded[i].angle, expected[i].angle, 1e-6f));
+	}
+}
+
+#define REPLAY_IMU_SAMPLES 3000
+#define REPLAY_IMU_BASE_TICKS 0xfc000000u
+#define REPLAY_IMU_GYRO 3000
+
+// the sensor report sent after sample newest, with the last three samples in rotating slots
+static void write_sensor_report(unsigned char* buffer, int newest)
+{
+	memset(buffer, 0, 52);
+	buffer[0] = VIVE_IRQ_SENSORS;
+
+	for(int s = newest - 2; s <= newest; s++){
+		unsigned char* p = buffer + 1 + 17 * (s % 3);
+		write16(p + 2, 8192);
+		write16(p + 6, REPLAY_IMU_GYRO);
+		write32(p + 12, REPLAY_IMU_BASE_TICKS + (uint32_t)s * VIVE_SAMPLE_TICKS);
+		p[16] = s & 0xff;
+	}
+}
+
+/*
+ * Replays the IMU stream with one in ten reports lost at random and a burst
+ * of 300 reports lost in a row, longer than the sequence numbers can tell
+ * apart. Every sample that made it through is used once and in order, the
+ * rest is counted as dropped, and the time spans add up to the whole stream.
+ */
+void test_vive_sample_reorder_replay()
+{
+	static bool received[REPLAY_IMU_SAMPLES];
+	uint32_t rng = 1;
+	int first = -1, last = -1, num_reports = 0;
+
+	vive_sample_order order;
+	memset(&order, 0, sizeof(order));
+
+	imu_ring ring;
+	memset(&ring, 0, sizeof(ring));
+
+	double time = 0, angle = 0;
+	int num_steps = 0;
+	uint32_t last_tick = 0;
+
+	for(int newest = 2; newest < REPLAY_IMU_SAMPLES; newest++){
+		rng = rng * 1103515245u + 12345u;
+		if((rng >> 16) % 10 == 0 || (newest >= 1500 && newest < 1800))
+			continue;
+
+		unsigned char buffer[52];
+		write_sensor_report(buffer, newest);
+		TAssert(vive_decode_sensor_samples(&ring, buffer, sizeof(buffer)));
+
+		imu_sample* smp[VIVE_SAMPLES];
+		for(int i = 0; i < VIVE_SAMPLES; i++)
+			smp[i] = imu_ring_pop(&ring);
+
+		vive_fusion_step steps[VIVE_MAX_FUSION_STEPS];
+		int count = vive_order_samples(&order, smp, steps);
+		TAssert(count >= 0 && count <= VIVE_MAX_FUSION_STEPS);
+
+		for(int i = 0; i < count; i++){
+			// in order, and never going back
+			TAssert(num_steps == 0 || (int32_t)(steps[i].sample->tick - last_tick) >= 0);
+			last_tick = steps[i].sample->tick;
+
+			time += steps[i].dt;
+			angle += steps[i].gyro.x * steps[i].dt;
+			num_steps++;
+		}
+
+		for(int s = newest - 2; s <= newest; s++)
+			received[s] = true;
+
+		if(first < 0)
+			first = newest - 2;
+
+		last = newest;
+		num_reports++;
+	}
+
+	int num_received = 0, num_missing = 0, num_gaps = 0;
+	for(int s = first; s <= last; s++){
+		if(received[s])
+			num_received++;
+		else
+			num_missing++;
+
+		if(!received[s] && received[s - 1])
+			num_gaps++;
+	}
+
+	TAssert(order.dropped_samples == num_missing);
+	TAssert(order.duplicate_samples == num_reports * VIVE_SAMPLES - num_received);
+	TAssert(num_steps == num_received + num_gaps);
+
+	// the stream starts a sample before the first one received
+	double span = (last - first + 1) * (double)VIVE_SAMPLE_TICKS / VIVE_TIME_DIV;
+	TAssert(fabs(time - span) < 1e-5);
+	TAssert(fabs(angle - span * REPLAY_IMU_GYRO * 8.7 / 32768.0) < 1e-5);
+}
+
+#endif
+
+#if DRIVER_NOLO
+
+#include <string.h>
+#include "drv_nolo/nolo.h"
+
+// the whole report through the generic XXTEA, as the driver used to decrypt it
+static void nolo_decrypt_reference(unsigned char* buf)
+{
+	static const uint32_t key[4] = {0x875bcc51, 0xa7637a66, 0x50960967, 0xf8536c51};
+	uint32_t words[15];
+
+	for(int i = 0; i < 15; i++)
+		words[i] = buf[1 + 4 * i] | (buf[2 + 4 * i] << 8) | (buf[3 + 4 * i] << 16) | ((uint32_t)buf[4 + 4 * i] << 24);
+
+	btea_decrypt(words, 15, 1, key);
+
+	for(int i = 0; i < 15; i++){
+		buf[1 + 4 * i] = words[i];
+		buf[2 + 4 * i] = words[i] >> 8;
+		buf[3 + 4 * i] = words[i] >> 16;
+		buf[4 + 4 * i] = words[i] >> 24;
+	}
+}
+
+void test_nolo_decrypt_from()
+{
+	// a whole report, the base station data, the second controller and a first byte on a word boundary
+	static const int first_bytes[] = { 1, 0x15, 64 - NOLO_CONTROLLER_LENGTH, 45 };
+	unsigned int state = 7;
+
+	for(int r = 0; r < 1000; r++){
+		unsigned char report[64], expected[64];
+		for(int i = 0; i < 64; i++){
+			state = state * 1664525u + 1013904223u;
+			report[i] = state >> 24;
+		}
+
+		memcpy(expected, report, 64);
+		nolo_decrypt_reference(expected);
+
+		for(int f = 0; f < 4; f++){
+			unsigned char buf[64];
+			memcpy(buf, report, 64);
+			nolo_decrypt_data_from(buf, first_bytes[f]);
+
+			TAssert(buf[0] == report[0]);
+			TAssert(memcmp(buf + first_bytes[f], expected + first_bytes[f], 64 - first_bytes[f]) == 0);
+		}
+	}
+}
+
+#endif
+
+#if DRIVER_PSVR
+
+#include "drv_psvr/psvr.h"
+
+/*
+ * Replays sensor reports through the decoder and the per sample tick deltas
+ * the driver integrates over, the samples sit at bytes 16 and 32.
+ */
+void test_psvr_sensor_replay()
+{
+	static const struct {
+		uint32_t ticks[PSVR_SAMPLES];
+		uint32_t deltas[PSVR_SAMPLES];
+	} reports[] = {
+		{ { 1000, 1500 }, { 500, 500 } }, // the first report falls back to the spacing within it
+		{ { 2000, 2500 }, { 500, 500 } },
+		{ { 2500, 3000 }, { 500, 500 } }, // a repeated tick
+		{ { 300000, 300500 }, { 500, 500 } }, // a gap of almost 300 ms
+		{ { 300600, 400700 }, { 100, 0 } }, // 100.1 ms to the second sample, and as its fallback
+		{ { 600000, 600000 }, { 0, 0 } }, // a gap and a repeated tick without a usable spacing
+		{ { 600250, 600500 }, { 250, 250 } },
+	};
+
+	imu_ring ring;
+	memset(&ring, 0, sizeof(ring));
+	uint32_t last_tick = 0;
+
+	for(int r = 0; r < sizeof(reports) / sizeof(reports[0]); r++){
+		unsigned char report[64] = { PSVR_IRQ_SENSORS };
+
+		for(int i = 0; i < PSVR_SAMPLES; i++){
+			unsigned char* p = report + 16 + 16 * i;
+			write32(p, reports[r].ticks[i]);
+
+			// gyro then accel, each as raw y, x, -z in thousandths
+			for(int j = 0; j < 3; j++){
+				write16(p + 4 + 2 * j, 100 * r + 10 * i + j);
+				write16(p + 10 + 2 * j, (uint16_t)-(100 * r + 10 * i + j));
+			}
+		}
+
+		TAssert(psvr_decode_sensor_samples(&ring, report, sizeof(report)));
+		TAssert(imu_ring_count(&ring) == PSVR_SAMPLES);
+
+		imu_sample* s[PSVR_SAMPLES];
+		for(int i = 0; i < PSVR_SAMPLES; i++)
+			s[i] = imu_ring_pop(&ring);
+
+		for(int i = 0; i < PSVR_SAMPLES; i++){
+			float v = 0.001f * (100 * r + 10 * i);
+			vec3f gyro = {{ v + 0.001f, v, -(v + 0.002f) }};
+			vec3f accel = {{ -(v + 0.001f), -v, v + 0.002f }};
+
+			TAssert(s[i]->tick == reports[r].ticks[i]);
+			TAssert(vec3f_eq(s[i]->gyro, gyro, 1e-6f));
+			TAssert(vec3f_eq(s[i]->accel, accel, 1e-6f));
+
+			TAssert(psvr_sample_tick_delta(last_tick, s[i]->tick, s[1]->tick - s[0]->tick) == reports[r].deltas[i]);
+			last_tick = s[i]->tick;
+		}
+	}
+}
+
+#endif
+
+#if DRIVER_OCULUS_RIFT
+
+#include <limits.h>
+
+// every driver header has its own
+#undef FEATURE_BUFFER_SIZE
+#include "drv_oculus_rift/rift.h"
+
+void test_rift_packet_interval_from_us()
+{
+	static const struct {
+		int interval_us;
+		uint16_t packet_interval;
+	} cases[] = {
+		{ INT_MIN, 0 }, { -1, 0 }, { 0, 0 }, { 1, 0 }, { 499, 0 }, { 500, 0 },
+		{ 1000, 0 }, { 1499, 0 }, { 1500, 1 }, { 2000, 1 }, { 16000, 15 }, { 16499, 15 },
+		{ 16500, 16 }, { 255499, 254 }, { 255500, 255 }, { 256000, 255 }, { 1000000, 255 }, { INT_MAX, 255 },
+	};
+
+	for(int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+		TAssert(rift_packet_interval_from_us(cases[i].interval_us) == cases[i].packet_interval);
+}
+
+void test_rift_report_first_dt()
+{
+	static const struct {
+		uint16_t packet_interval;
+		int count;
+		uint32_t last_timestamp, timestamp;
+		float dt;
+	} cases[] = {
+		{ 0, 1, 1000, 2000, 0.001f },
+		{ 1, 2, 1000, 3000, 0.001f },
+		{ 15, 3, 10000, 26000, 0.014f }, // a 16 ms report, the last two samples follow 1 ms apart
+		{ 15, 3, 10000, 10000, 0.014f }, // no time passed, the configured 16 samples stand in
+		{ 15, 3, 0xffffff00, 100, 0.014f }, // the time stamp overflowed
+		{ 9, 1, 5000, 5000, 0.010f },
+		{ 1, 3, 5000, 5000, 0.001f }, // more samples than configured, still one sample
+		{ 255, 3, 7000, 7000, 0.254f },
+	};
+
+	for(int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+		float dt = rift_report_first_dt(cases[i].packet_interval, cases[i].count, cases[i].last_timestamp, cases[i].timestamp);
+		TAssert(float_eq(dt, cases[i].dt, 1e-6f));
+	}
+
+	// a requested interval comes back as the dt of a one sample report
+	for(int us = 1000; us <= 256000; us += 1000){
+		float dt = rift_report_first_dt(rift_packet_interval_from_us(us), 1, 0, 0);
+		TAssert(float_eq(dt, us / 1000000.0f, 1e-6f));
+	}
+}
+
+#endif
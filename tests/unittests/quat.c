@@ -49,6 +49,107 @@ void test_oquatf_init_axis()
 	}
 }
 
+void test_oquatf_init_rotation_vector()
+{
+	// void oquatf_init_rotation_vector(quatf* me, const vec3f* rot_vec);
+
+	const double axis[3] = { 0.48, -0.6, 0.64 };
+
+	// per sample angles at 1 kHz from 0.1 to 2000 deg/s, around the series
+	// cutoff and well above it
+	const double angles[] = {
+		0, DEG_TO_RAD(0.1) / 1000, DEG_TO_RAD(10.0) / 1000, DEG_TO_RAD(500.0) / 1000,
+		DEG_TO_RAD(2000.0) / 1000, 0.1, 0.2499, 0.2501, 1.0, 3.0,
+	};
+
+	for(int i = 0; i < sizeof(angles) / sizeof(angles[0]); i++){
+		double a = angles[i];
+		vec3f rot_vec = {{ axis[0] * a, axis[1] * a, axis[2] * a }};
+
+		quatf q;
+		oquatf_init_rotation_vector(&q, &rot_vec);
+
+		// exact in double precision, the result should be within float rounding
+		quatf expected = {{ axis[0] * sin(a / 2), axis[1] * sin(a / 2), axis[2] * sin(a / 2), cos(a / 2) }};
+		TAssert(quatf_eq(q, expected, 2e-7f));
+		TAssert(float_eq(oquatf_get_length(&q), 1.0f, 2e-7f));
+
+		// and agree with building it from axis and angle
+		if(a > 0){
+			vec3f axis_f = {{ axis[0], axis[1], axis[2] }};
+			quatf q_axis;
+			oquatf_init_axis(&q_axis, &axis_f, a);
+			TAssert(quatf_eq(q, q_axis, 2e-7f));
+		}
+	}
+}
+
+void test_oquatd()
+{
+	// the double precision functions match the float ones, and are exact to well below float precision
+	vec3f axis_f = {{1, 2, -3}}, point_f = {{0.5f, -4, 2}};
+	vec3d axis = {{1, 2, -3}}, point = {{0.5, -4, 2}};
+
+	quatf qf;
+	quatd q, r, inv;
+	oquatf_init_axis(&qf, &axis_f, 0.8f);
+	oquatd_init_axis(&q, &axis, 0.8);
+
+	quatf q_as_f;
+	oquatd_get_quatf(&q, &q_as_f);
+	TAssert(quatf_eq(q_as_f, qf, 1e-6f));
+
+	vec3f rotated_f, rotated_as_f;
+	vec3d rotated;
+	oquatf_get_rotated(&qf, &point_f, &rotated_f);
+	oquatd_get_rotated(&q, &point, &rotated);
+	ovec3d_get_vec3f(&rotated, &rotated_as_f);
+	TAssert(vec3f_eq(rotated_as_f, rotated_f, 1e-5f));
+	TAssert(fabs(ovec3d_get_length(&rotated) - ovec3d_get_length(&point)) < 1e-14);
+
+	// rotating back with the inverse
+	inv = q;
+	oquatd_inverse(&inv);
+	vec3d back;
+	oquatd_get_rotated(&inv, &rotated, &back);
+	for(int i = 0; i < 3; i++)
+		TAssert(fabs(back.arr[i] - point.arr[i]) < 1e-14);
+
+	// the rotation vector form agrees, on both sides of the series cutoff
+	double angles[] = { 0.001, 0.04, 0.06, 2.0 };
+	for(int i = 0; i < 4; i++){
+		vec3d n = axis;
+		ovec3d_normalize_me(&n);
+		vec3d rot_vec = {{ n.x * angles[i], n.y * angles[i], n.z * angles[i] }};
+
+		oquatd_init_axis(&q, &axis, angles[i]);
+		oquatd_init_rotation_vector(&r, &rot_vec);
+		for(int j = 0; j < 4; j++)
+			TAssert(fabs(q.arr[j] - r.arr[j]) < 1e-15);
+	}
+
+	// q * q^-1 is the identity
+	oquatd_from_quatf(&q, &qf);
+	oquatd_diff(&q, &q, &r);
+	TAssert(fabs(r.w - 1.0) < 1e-15 && fabs(r.x) < 1e-15 && fabs(r.y) < 1e-15 && fabs(r.z) < 1e-15);
+
+	mat4x4d m, t, mt;
+	mat4x4f mf;
+	oquatd_get_mat4x4(&q, &point, m.m);
+	omat4x4d_get_mat4x4f(&m, &mf);
+	TAssert(float_eq(mf.m[0][3], 0.5f, 1e-6f));
+
+	// a rotation matrix times its transpose is the identity
+	vec3d zero = {{0, 0, 0}};
+	oquatd_normalize_me(&q);
+	oquatd_get_mat4x4(&q, &zero, m.m);
+	omat4x4d_transpose(&m, &t);
+	omat4x4d_mult(&m, &t, &mt);
+	for(int i = 0; i < 4; i++)
+		for(int j = 0; j < 4; j++)
+			TAssert(fabs(mt.m[i][j] - (i == j ? 1.0 : 0.0)) < 1e-14);
+}
+
 typedef struct {
 	quatf q;
 	vec3f v1, v2;
@@ -0,0 +1,193 @@
+/*
+ * OpenHMD - Free and Open Source API and drivers for immersive technology.
+ * Copyright (C) 2013 Fredrik Hultin.
+ * Copyright (C) 2013 Jakob Bornecrantz.
+ * Distributed under the Boost 1.0 licence, see LICENSE for full text.
+ */
+
+/* Unit Tests - SIMD Math Kernel Tests */
+
+#include <string.h>
+#include "tests.h"
+
+// relative to the magnitude of the inputs, a few ULP
+static const float t = 0.00001f;
+
+static float random_float(unsigned int* state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return (float)(*state >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+static void random_quat(unsigned int* state, quatf* q)
+{
+	for(int i = 0; i < 4; i++)
+		q->arr[i] = random_float(state);
+
+	oquatf_normalize_me(q);
+}
+
+static bool arr_eq(const float* a, const float* b, int count)
+{
+	for(int i = 0; i < count; i++)
+		if(!float_eq(a[i], b[i], t)){
+			printf("\n[%d] == %f, expected %f\n", i, a[i], b[i]);
+			return false;
+		}
+
+	return true;
+}
+
+// runs every kernel with the given implementation and compares to the scalar results
+static void compare_impl(omath_impl impl)
+{
+	unsigned int state = 1;
+
+	for(int n = 0; n < 1000; n++){
+		quatf a, b, out[2];
+		vec3f v = {{ random_float(&state) * 10, random_float(&state) * 10, random_float(&state) * 10 }}, rot[2];
+		mat4x4f l, r, mult[2], transp[2];
+
+		TAssert(omath_set_impl(OMATH_IMPL_SCALAR) == 0);
+		random_quat(&state, &a);
+		random_quat(&state, &b);
+
+		for(int i = 0; i < 16; i++){
+			l.arr[i] = random_float(&state);
+			r.arr[i] = random_float(&state);
+		}
+
+		for(int k = 0; k < 2; k++){
+			TAssert(omath_set_impl(k == 0 ? OMATH_IMPL_SCALAR : impl) == 0);
+
+			oquatf_mult(&a, &b, &out[k]);
+			oquatf_get_rotated(&a, &v, &rot[k]);
+			omat4x4f_mult(&l, &r, &mult[k]);
+			omat4x4f_transpose(&l, &transp[k]);
+		}
+
+		TAssert(arr_eq(out[1].arr, out[0].arr, 4));
+		TAssert(arr_eq(rot[1].arr, rot[0].arr, 3));
+		TAssert(arr_eq(mult[1].arr, mult[0].arr, 16));
+		TAssert(arr_eq(transp[1].arr, transp[0].arr, 16));
+
+		// unnormalized input
+		quatf q = {{ a.x * 3, a.y * 3, a.z * 3, a.w * 3 }}, norm[2];
+
+		for(int k = 0; k < 2; k++){
+			TAssert(omath_set_impl(k == 0 ? OMATH_IMPL_SCALAR : impl) == 0);
+			norm[k] = q;
+			oquatf_normalize_me(&norm[k]);
+		}
+
+		TAssert(arr_eq(norm[1].arr, norm[0].arr, 4));
+
+		// point arrays, with a count that leaves a remainder for every vector width
+		enum { count = 13 };
+		float points[count * 3], moved[2][count * 3], moved_soa[2][count * 3];
+		for(int i = 0; i < count * 3; i++)
+			points[i] = random_float(&state) * 10;
+
+		for(int k = 0; k < 2; k++){
+			TAssert(omath_set_impl(k == 0 ? OMATH_IMPL_SCALAR : impl) == 0);
+
+			omat4x4f_transform_points_aos(&l, points, moved[k], count);
+			omat4x4f_transform_points_soa(&l, points, moved_soa[k], count);
+		}
+
+		TAssert(arr_eq(moved[1], moved[0], count * 3));
+		TAssert(arr_eq(moved_soa[1], moved_soa[0], count * 3));
+
+		// accumulating into the left matrix must still work
+		TAssert(omath_set_impl(impl) == 0);
+		mat4x4f in_place = l;
+		omat4x4f_mult(&in_place, &r, &in_place);
+		TAssert(arr_eq(in_place.arr, mult[0].arr, 16));
+	}
+}
+
+void test_omath_simd_kernels()
+{
+	omath_impl prev = omath_get_impl();
+	int tested = 0;
+
+	for(int impl = OMATH_IMPL_SCALAR + 1; impl < OMATH_IMPL_COUNT; impl++){
+		if(omath_set_impl(impl) != 0)
+			continue;
+
+		compare_impl(impl);
+		tested++;
+	}
+
+	// at least one vector implementation on the common targets
+#if defined(__x86_64__) || defined(_M_X64) || defined(__aarch64__)
+	TAssert(tested > 0);
+#endif
+
+	TAssert(omath_set_impl(prev) == 0);
+}
+
+void test_omath_init_impl()
+{
+	omath_impl prev = omath_get_impl();
+
+	TAssert(omath_set_impl(OMATH_IMPL_COUNT) != 0);
+	TAssert(omath_get_impl() == prev);
+
+	// picks something that works on this CPU
+	omath_init_impl();
+	omath_impl best = omath_get_impl();
+	TAssert(omath_set_impl(best) == 0);
+	TAssert(strcmp(omath_get_impl_name(best), "unknown") != 0);
+
+	// and only once, later contexts don't switch kernels under running update threads
+	TAssert(omath_set_impl(OMATH_IMPL_SCALAR) == 0);
+	omath_init_impl();
+	TAssert(omath_get_impl() == OMATH_IMPL_SCALAR);
+
+	TAssert(omath_set_impl(prev) == 0);
+}
+
+void test_omath_inline()
+{
+	const vec3f vecs[] = {
+		{{1, 2, 3}}, {{-0.5f, 0.25f, 4}}, {{0, 0, 0}}, {{0, -9.82f, 0.1f}},
+	};
+	const quatf quats[] = {
+		{{0, 0, 0, 1}}, {{0.5f, -0.5f, 0.5f, 0.5f}}, {{0.1f, 0.7f, -0.1f, 0.7f}},
+	};
+
+	for(int i = 0; i < 4; i++){
+		vec3f a = vecs[i], b = vecs[i];
+
+		// the parenthesized names always call the exported functions
+		TAssert((ovec3f_get_length)(&a) == ovec3f_get_length_inline(&a));
+		TAssert((ovec3f_get_dot)(&a, &vecs[3 - i]) == ovec3f_get_dot_inline(&a, &vecs[3 - i]));
+
+		(ovec3f_normalize_me)(&a);
+		ovec3f_normalize_me_inline(&b);
+		TAssert(vec3f_eq(a, b, 1e-6f));
+
+		for(int j = 0; j < 3; j++){
+			quatf qa, qb;
+			(oquatf_init_axis)(&qa, &vecs[i], 0.3f * j);
+			oquatf_init_axis_inline(&qb, &vecs[i], 0.3f * j);
+			TAssert(quatf_eq(qa, qb, 1e-6f));
+
+			vec3f ra, rb;
+			(oquatf_get_rotated)(&quats[j], &vecs[i], &ra);
+			oquatf_get_rotated_inline(&quats[j], &vecs[i], &rb);
+			TAssert(vec3f_eq(ra, rb, 1e-5f));
+
+			qa = qb = quats[j];
+			(oquatf_mult_me)(&qa, &quats[2 - j]);
+			oquatf_mult_me_inline(&qb, &quats[2 - j]);
+			TAssert(quatf_eq(qa, qb, 1e-5f));
+
+			(oquatf_normalize_me)(&qa);
+			oquatf_normalize_me_inline(&qb);
+			TAssert(quatf_eq(qa, qb, 1e-5f));
+			TAssert(fabsf(oquatf_get_length_inline(&qb) - 1.0f) < 1e-5f);
+		}
+	}
+}
@@ -20,6 +20,7 @@
 
 bool float_eq(float a, float b, float t);
 bool vec3f_eq(vec3f v1, vec3f v2, float t);
+bool quatf_eq(quatf q1, quatf q2, float t);
 
 // vec3f tests
 void test_ovec3f_normalize_me();
@@ -29,6 +30,8 @@ void test_ovec3f_get_dot();
 
 // quatf tests
 void test_oquatf_init_axis();
+void test_oquatf_init_rotation_vector();
+void test_oquatd();
 void test_oquatf_get_rotated();
 void test_oquatf_mult();
 void test_oquatf_mult_me();
@@ -40,11 +43,65 @@ void test_oquatf_diff();
 
 void test_oquatf_get_mat4x4();
 
+// mat4x4f tests
+void test_omat4x4f_init_eye_views();
+void test_omat4x4f_init_frustum_tangents();
+
+// fusion tests
+void test_ofusion_gyro_bias();
+void test_ofusion_gyro_bias_ignores_slow_turn();
+void test_ofusion_mag_yaw_correction();
+void test_ofusion_batch_integrate();
+void test_ofusion_batch_gravity_correction();
+void test_ofusion_batch_gyro_bias_ignores_slow_turn();
+void test_ofusion_madgwick();
+void test_ofusion_mahony();
+void test_ofusion_set_algorithm();
+void test_ofusion_coning_window();
+void test_ofusion_double_precision();
+
 // high-level tests
 void test_highlevel_open_close_device();
 void test_highlevel_open_close_many_devices();
+void test_highlevel_fusion_algorithm();
+void test_highlevel_mag_correction_gain();
+void test_highlevel_external_fusion_batch();
+void test_highlevel_transform_points();
+void test_highlevel_eye_views();
+void test_highlevel_projection();
+void test_highlevel_sensor_sample_counts();
+void test_highlevel_read_stream();
 
 // queue tests
 void test_ohmdq_push_pop();
 
+// simd tests
+void test_omath_simd_kernels();
+void test_omath_init_impl();
+void test_omath_inline();
+
+// packet layout tests
+void test_packet_layout_decode();
+void test_packet_layout_size();
+void test_packet_unpack_vec21();
+
+#if DRIVER_HTC_VIVE
+void test_vive_controller_replay();
+void test_vive_lighthouse_replay();
+void test_vive_sample_reorder_replay();
+#endif
+
+#if DRIVER_NOLO
+void test_nolo_decrypt_from();
+#endif
+
+#if DRIVER_PSVR
+void test_psvr_sensor_replay();
+#endif
+
+#if DRIVER_OCULUS_RIFT
+void test_rift_packet_interval_from_us();
+void test_rift_report_first_dt();
+#endif
+
 #endif